@@ -5,6 +5,133 @@
 #include "Stdint.h"
 #include "Bootloader.h"
 
+/* static efiStatus ReadKernelFile()
+
+   Inputs: efiFileProtocol* File - The file protocol of the (open) kernel image.
+           uint64 Position - The offset within the file to start reading from, in bytes.
+           uint64 Size - The number of bytes we want to read.
+           void* Buffer - The buffer we want to read *to*.
+
+   Outputs: efiStatus - The status returned by the file protocol (or EfiLoadError,
+   if the file ended before we were able to read Size bytes).
+
+   This function reads a specific byte range of the kernel image into Buffer, using
+   the file protocol's SetPosition() and Read() functions; this lets us load each
+   part of the kernel straight to where it needs to go, instead of reading the
+   entire image into memory first.
+
+   (This always reads the file as-is; see ReadKernelImage() for the version
+   that handles compressed kernel images.)
+
+*/
+
+static efiStatus ReadKernelFile(efiFileProtocol* File, uint64 Position, uint64 Size, void* Buffer) {
+
+  // (Move to the requested position within the file)
+
+  efiStatus Status = File->SetPosition(File, Position);
+
+  if (Status != EfiSuccess) {
+    return Status;
+  }
+
+  // (Read Size bytes from there, and make sure we actually read all of them,
+  // since Read() returns fewer bytes if it reaches the end of the file)
+
+  uint64 BytesRead = Size;
+  Status = File->Read(File, &BytesRead, Buffer);
+
+  if ((Status == EfiSuccess) && (BytesRead != Size)) {
+    Status = EfiLoadError;
+  }
+
+  return Status;
+
+}
+
+
+/* static bool ReadCompressedKernel()
+
+   Inputs: void* Context - The file protocol of the (open) kernel image.
+           uint64 Position - The offset within the file to start reading from, in bytes.
+           void* Buffer - The buffer we want to read *to*.
+           uint32 Size - The number of bytes we want to read.
+
+   Outputs: bool - Whether we were able to read Size bytes from the file.
+
+   This function is a small wrapper around ReadKernelFile(), which is passed
+   on to Lz4OpenStream() (in Common/Compression/Lz4.c) so it can read each
+   compressed block as it needs it.
+
+*/
+
+static bool ReadCompressedKernel(void* Context, uint64 Position, void* Buffer, uint32 Size) {
+
+  return (ReadKernelFile((efiFileProtocol*)Context, Position, Size, Buffer) == EfiSuccess);
+
+}
+
+
+/* static efiStatus ReadKernelImage()
+
+   Inputs: efiFileProtocol* File - The file protocol of the (open) kernel image.
+           uint64 Position - The offset within the (decompressed) image to start reading from.
+           uint64 Size - The number of bytes we want to read.
+           void* Buffer - The buffer we want to read *to*.
+
+   Outputs: efiStatus - EfiSuccess if we were able to read Size bytes, or
+   an error code otherwise.
+
+   This function reads a specific byte range of the kernel image, like
+   ReadKernelFile() - except that if the kernel image is compressed, it
+   decompresses that range from KernelStream instead.
+
+   (In that case, the image can only be read *forwards*, since blocks are
+   decompressed straight to wherever they're needed; see Lz4ReadStream()
+   in Common/Compression/Lz4.c.)
+
+*/
+
+static efiStatus ReadKernelImage(efiFileProtocol* File, uint64 Position, uint64 Size, void* Buffer) {
+
+  if (IsKernelCompressed == false) {
+    return ReadKernelFile(File, Position, Size, Buffer);
+  }
+
+  if ((Position > KernelStream.Info.ContentSize) || (Size > (KernelStream.Info.ContentSize - Position))) {
+    return EfiLoadError;
+  }
+
+  return (Lz4ReadStream(&KernelStream, Position, Buffer, Size) == true) ? EfiSuccess : EfiLoadError;
+
+}
+
+
+/* static bool QueryMmapEntry()
+
+   Inputs: const void* Entry - The EFI memory map entry we want to read.
+           uint64* Base - Where to save the start of the area it covers.
+           uint64* Size - Where to save the size of that area, in bytes.
+
+   Outputs: bool - Whether the area is usable (EfiConventionalMemory).
+
+   This function is passed on to SortMmap() and NormalizeMmap() (in
+   Common/Memory/Mmap.c), so they can read EFI memory map entries.
+
+*/
+
+static bool QueryMmapEntry(const void* Entry, uint64* Base, uint64* Size) {
+
+  const efiMemoryDescriptor* Descriptor = (const efiMemoryDescriptor*)Entry;
+
+  *Base = Descriptor->PhysicalStart;
+  *Size = (Descriptor->NumberOfPages * 4096);
+
+  return (Descriptor->Type == EfiConventionalMemory);
+
+}
+
+
 /* efiStatus efiAbi SEfiBootloader()
 
    Inputs: efiHandle ImageHandle - The firmware-provided image handle.
@@ -41,7 +168,6 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
   efiStatus AppStatus = EfiSuccess;
 
-  bool HasAllocatedKernel = false;
   bool HasAllocatedKernelArea = false;
   bool HasAllocatedMemory = false;
   bool HasAllocatedStack = false;
@@ -54,6 +180,11 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
   bool HasOpenedEdidProtocols = false;
 
   volatile efiFileInfo* KernelInfo = NULL;
+  volatile void* KernelProgramHdrs = NULL;
+  volatile void* KernelSectionHdrs = NULL;
+  volatile void* KernelRelocations = NULL;
+  volatile void* KernelCompressedBlock = NULL;
+  volatile void* KernelDecompressedBlock = NULL;
   volatile void* Mmap = NULL;
   uint16 NumUsableMmapEntries = 0;
   usableMmapEntry* UsableMmap = NULL;
@@ -815,19 +946,19 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
 
 
-  // [Read the kernel image from disk]
+  // [Read the kernel image's headers from disk]
 
   // Now that we've obtained the kernel image's file handle, the next thing
-  // we need to do is to read it from disk.
+  // we need to do is to read its headers from disk.
 
-  // This is a little more involved though; before we can actually read it,
-  // we first need to figure out how large it is and then allocate the
-  // necessary buffer, which can take some time.
+  // We don't read the entire image at once; instead, we only read what we
+  // need to figure out where everything goes, and then (later on) we read
+  // each segment straight to its final location in memory.
 
   uint64 KernelSize = 0;
 
   Print(u"\n\r", 0);
-  Message(Boot, u"Preparing to read the kernel image from disk.");
+  Message(Boot, u"Preparing to read the kernel image's headers from disk.");
 
   // (Our kernel's file handle has an information table of its own (defined
   // in efiFileInfo{}), which we need to get the size of.)
@@ -903,43 +1034,126 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
   Message(Info, u"Kernel image size is %d bytes.", KernelSize);
 
-  // Finally, now that we actually know the size of the kernel image, we
-  // can allocate space for it, and read it from disk.
+  // Before we go any further, we need to check whether the kernel image is
+  // compressed; if it's an LZ4 frame, then we decompress each part of it
+  // as we read it (one block at a time), instead of reading it as-is.
 
-  #define AlignDivision(Num, Divisor) ((Num + Divisor - 1) / Divisor)
+  // (Reading a compressed image is much faster on slow media, and LZ4 is
+  // fast enough to decompress that it's almost always worth it.)
 
-  AppStatus = gBS->AllocatePages(AllocateAnyPages, EfiLoaderData, AlignDivision(KernelSize, 4096), (volatile efiPhysicalAddress*)&Kernel);
+  uint8 KernelMagic[Lz4MaxFrameHeaderSize];
+  uint64 KernelMagicSize = (KernelSize < sizeof(KernelMagic)) ? KernelSize : sizeof(KernelMagic);
 
-  if ((AppStatus != EfiSuccess) || (Kernel == NULL)) {
+  AppStatus = ReadKernelFile(KernelFileProtocol, 0, KernelMagicSize, KernelMagic);
 
-    Message(Error, u"Failed to allocate enough space (%d KiB) for the kernel image.", (AlignDivision(KernelSize, 4096) * 4));
+  if (AppStatus != EfiSuccess) {
+
+    Message(Error, u"Failed to read the start of the kernel image from disk.");
     goto ExitEfiApplication;
 
-  } else {
+  }
 
-    Message(Ok, u"Successfully allocated %d KiB of space for the kernel image.", (AlignDivision(KernelSize, 4096) * 4));
-    HasAllocatedKernel = true;
+  uint32 KernelMagicNumber = 0;
 
+  if (KernelMagicSize >= sizeof(KernelMagicNumber)) {
+    Memcpy(&KernelMagicNumber, KernelMagic, sizeof(KernelMagicNumber));
   }
 
-  // (Read the kernel image into our newly allocated buffer, at *Kernel)
+  if (KernelMagicNumber == ZstdFrameMagic) {
 
-  AppStatus = KernelFileProtocol->Read(KernelFileProtocol, &KernelSize, Kernel);
+    Message(Error, u"Kernel image is zstd-compressed, which isn't supported (use LZ4).");
+    goto ExitEfiApplication;
 
-  if ((AppStatus != EfiSuccess) || (Kernel == NULL)) {
+  } else if (KernelMagicNumber == Lz4FrameMagic) {
+
+    // (Read the frame header; we need the frame to include the size of
+    // the decompressed image, so we can check everything we read against
+    // it, and its blocks need to be independent of each other)
+
+    lz4FrameInfo KernelFrame;
+
+    if ((Lz4ReadFrameHeader(KernelMagic, KernelMagicSize, &KernelFrame) == false) || (KernelFrame.ContentSize == 0) || (KernelFrame.HasLinkedBlocks == true)) {
+
+      Message(Error, u"Kernel image has an invalid LZ4 frame header (or no content size, or linked blocks).");
+      goto ExitEfiApplication;
+
+    }
+
+    Message(Info, u"Kernel image is LZ4-compressed (%d bytes decompressed, in blocks of up to %d bytes).",
+            KernelFrame.ContentSize, (uint64)KernelFrame.BlockMaxSize);
+
+    // (Allocate a buffer for each compressed block, and another one for
+    // any decompressed block that can't go straight to where it's needed;
+    // that's the only extra memory we need, since every other block is
+    // decompressed straight into the kernel area)
+
+    AppStatus = gBS->AllocatePool(EfiLoaderData, (KernelFrame.BlockMaxSize + 8), &KernelCompressedBlock);
+
+    if ((AppStatus != EfiSuccess) || (KernelCompressedBlock == NULL)) {
+
+      Message(Error, u"Failed to allocate space for the compressed kernel image's blocks.");
+      goto ExitEfiApplication;
+
+    }
+
+    AppStatus = gBS->AllocatePool(EfiLoaderData, KernelFrame.BlockMaxSize, &KernelDecompressedBlock);
+
+    if ((AppStatus != EfiSuccess) || (KernelDecompressedBlock == NULL)) {
+
+      Message(Error, u"Failed to allocate space for the decompressed kernel image's blocks.");
+      goto ExitEfiApplication;
+
+    }
+
+    // (From now on, ReadKernelImage() will decompress everything we read)
+
+    if (Lz4OpenStream(&KernelStream, &KernelFrame, ReadCompressedKernel, (void*)KernelFileProtocol, (void*)KernelCompressedBlock, (void*)KernelDecompressedBlock) == false) {
+
+      Message(Error, u"Failed to read the first block of the kernel image.");
+      goto ExitEfiApplication;
 
-    Message(Error, u"Failed to read the kernel image from disk.");
+    }
+
+    IsKernelCompressed = true;
+    KernelSize = KernelFrame.ContentSize;
+
+  }
+
+  // Finally, now that we actually know the size of the kernel image, we
+  // can allocate space for its ELF header, and read it from disk.
+
+  #define AlignDivision(Num, Divisor) ((Num + Divisor - 1) / Divisor)
+
+  if (KernelSize < sizeof(elfHeader)) {
+
+    Message(Error, u"Kernel image is too small to contain an ELF header.");
     goto ExitEfiApplication;
 
-  } else {
+  }
 
-    Message(Ok, u"Successfully loaded the kernel image to %xh in memory.", (uint64)Kernel);
+  AppStatus = gBS->AllocatePool(EfiLoaderData, sizeof(elfHeader), (volatile void**)&Kernel);
+
+  if ((AppStatus != EfiSuccess) || (Kernel == NULL)) {
+
+    Message(Error, u"Failed to allocate space for the kernel's ELF header.");
+    goto ExitEfiApplication;
 
   }
 
-  // (Close the kernel file itself, now that we're done with it.)
+  // (Read the kernel's ELF header into our newly allocated buffer, at *Kernel)
 
-  KernelFileProtocol->Close(KernelFileProtocol);
+  AppStatus = ReadKernelImage(KernelFileProtocol, 0, sizeof(elfHeader), Kernel);
+
+  if (AppStatus != EfiSuccess) {
+
+    Message(Error, u"Failed to read the kernel's ELF header from disk.");
+    goto ExitEfiApplication;
+
+  } else {
+
+    Message(Ok, u"Successfully loaded the kernel's ELF header to %xh in memory.", (uint64)Kernel);
+
+  }
 
 
 
@@ -1008,6 +1222,8 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
     KernelHasValidElf = false;
   } else if ((KernelHeader->ProgramHeaderOffset == 0) || (KernelHeader->NumProgramHeaders == 0)) {
     KernelHasValidElf = false;
+  } else if ((KernelHeader->ProgramHeaderSize < sizeof(elfProgramHeader)) || (KernelHeader->SectionHeaderSize < sizeof(elfSectionHeader))) {
+    KernelHasValidElf = false;
   } else if (KernelHeader->Version < 1) {
     Message(Warning, u"ELF header version appears to be invalid (%d)", (uint64)KernelHeader->Version);
   } else if (KernelHeader->FileType != EtDyn) {
@@ -1040,6 +1256,34 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
   }
 
+  // Now that we know where the program headers are, we can read them from
+  // disk as well; we'll need them in order to figure out what to load.
+
+  #define ProgramHdrSize KernelHeader->ProgramHeaderSize
+  #define GetProgramHeader(Index) (elfProgramHeader*)((uint64)KernelProgramHdrs + (Index * ProgramHdrSize))
+
+  AppStatus = gBS->AllocatePool(EfiLoaderData, (NumProgramHdrs * ProgramHdrSize), &KernelProgramHdrs);
+
+  if ((AppStatus != EfiSuccess) || (KernelProgramHdrs == NULL)) {
+
+    Message(Error, u"Failed to allocate space for the kernel's program headers.");
+    goto ExitEfiApplication;
+
+  }
+
+  AppStatus = ReadKernelImage(KernelFileProtocol, ProgramHdrOffset, (NumProgramHdrs * ProgramHdrSize), (void*)KernelProgramHdrs);
+
+  if (AppStatus != EfiSuccess) {
+
+    Message(Error, u"Failed to read the kernel's program headers from disk.");
+    goto ExitEfiApplication;
+
+  } else {
+
+    Message(Ok, u"Successfully loaded the kernel's program headers to %xh.", (uint64)KernelProgramHdrs);
+
+  }
+
 
 
   // [Allocate space for the kernel itself]
@@ -1049,7 +1293,7 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
   // and where.
 
   // In our case, we need to allocate a space large enough for *all* of the
-  // program headers, and then copy everything there.
+  // program headers, and then read everything there.
 
   Print(u"\n\r", 0);
   Message(Boot, u"Preparing to allocate space for the kernel.");
@@ -1057,11 +1301,9 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
   // (Go through all loadable program headers, and keep track of the
   // 'earliest' and 'latest' virtual addresses we find)
 
-  #define ProgramHdrSize KernelHeader->ProgramHeaderSize
-  #define GetProgramHeader(Start, Index) (elfProgramHeader*)(Start + ProgramHdrOffset + (Index * ProgramHdrSize))
-
   uint64 EarliestVirtualAddress = uintmax;
   uint64 LatestVirtualAddress = 0;
+  uint64 LatestOffset = 0;
 
   bool FoundLoadable = false;
 
@@ -1070,7 +1312,7 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
     // (Get program header, and make sure that it's loadable (.Type == 1)
     // or dynamic (.Type == 2))
 
-    const elfProgramHeader* Program = GetProgramHeader((uint64)KernelHeader, Index);
+    const elfProgramHeader* Program = GetProgramHeader(Index);
 
     if ((Program->Type != 1) && (Program->Type != 2)) {
       continue;
@@ -1102,6 +1344,36 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
     }
 
+    // (Since we'll be reading loadable sections straight from disk, we
+    // also want to make sure they don't go past the end of the file)
+
+    if ((Program->Type == 1) && ((Program->Offset > KernelSize) || (Program->Size > (KernelSize - Program->Offset)))) {
+
+      Message(Error, u"Program header %d extends past the end of the kernel image.", Index);
+      AppStatus = EfiLoadError;
+
+      goto ExitEfiApplication;
+
+    }
+
+    // (If the kernel image is compressed, then we can only read it
+    // forwards, so loadable sections also need to be in file order)
+
+    if ((Program->Type == 1) && (IsKernelCompressed == true)) {
+
+      if (Program->Offset < LatestOffset) {
+
+        Message(Error, u"Program header %d comes before the previous one in the (compressed) kernel image.", Index);
+        AppStatus = EfiLoadError;
+
+        goto ExitEfiApplication;
+
+      }
+
+      LatestOffset = (Program->Offset + Program->Size);
+
+    }
+
     // (Update EarliestVirtualAddress and LatestVirtualAddress)
 
     if (Start < EarliestVirtualAddress) {
@@ -1170,16 +1442,16 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
   // [Setup the kernel area]
 
-  // Now that we've allocated enough space, let's copy everything over from
-  // the kernel file. This requires *everything* to be page-aligned, but we
+  // Now that we've allocated enough space, let's read everything from the
+  // kernel file. This requires *everything* to be page-aligned, but we
   // already made sure of that earlier, thankfully.
 
   Print(u"\n\r", 0);
   Message(Boot, u"Preparing to setup the kernel area.");
 
   // The first thing we need to do is to go through the (loadable) program
-  // headers again, and manually copy everything. We also use SSE functions
-  // to speed things up.
+  // headers again, and read each one from disk, straight into the kernel
+  // area (so the data only needs to cross the memory bus once).
 
   // (Additionally, we also need to 'pad' the difference between PaddedSize
   // (p_memsz) and Size (p_filesz) with zeroes)
@@ -1188,19 +1460,27 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
     // (Get program header, and make sure that it's loadable (.Type == 1))
 
-    elfProgramHeader* Program = GetProgramHeader((uint64)KernelHeader, Index);
+    elfProgramHeader* Program = GetProgramHeader(Index);
 
     if (Program->Type != 1) {
       continue;
     }
 
-    // (Copy Size (p_filesz) bytes from our file (in *Kernel) to our newly
+    // (Read Size (p_filesz) bytes from our file (at Offset) to our newly
     // allocated area (in *KernelArea))
 
     if (Program->Size > 0) {
 
-      SseMemcpy((void*)((uint64)KernelArea + Program->VirtAddress), (const void*)((uint64)Kernel + Program->Offset), Program->Size);
-      Message(Info, u"Copied %xh bytes from %xh to %xh", Program->Size, ((uint64)Kernel + Program->Offset), ((uint64)KernelArea + Program->VirtAddress));
+      AppStatus = ReadKernelImage(KernelFileProtocol, Program->Offset, Program->Size, (void*)((uint64)KernelArea + Program->VirtAddress));
+
+      if (AppStatus != EfiSuccess) {
+
+        Message(Error, u"Failed to read program header %d from disk.", (uint64)Index);
+        goto ExitEfiApplication;
+
+      }
+
+      Message(Info, u"Read %xh bytes from +%xh to %xh", Program->Size, Program->Offset, ((uint64)KernelArea + Program->VirtAddress));
 
     }
 
@@ -1216,6 +1496,11 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
   }
 
+  // (We don't need the program headers anymore, so free them)
+
+  gBS->FreePool((void*)KernelProgramHdrs);
+  KernelProgramHdrs = NULL;
+
   // Now that we've done that, we can also calculate where the actual
   // kernel entrypoint is located - thankfully, this is pretty easy:
 
@@ -1248,22 +1533,44 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
   // (Define a few important macros)
 
   #define SectionHdrSize KernelHeader->SectionHeaderSize
-  #define GetSectionHeader(Start, Index) (elfSectionHeader*)(Start + SectionHdrOffset + (Index * SectionHdrSize))
+  #define GetSectionHeader(Index) (elfSectionHeader*)((uint64)KernelSectionHdrs + (Index * SectionHdrSize))
+
+  // (Read the section headers from disk, since we didn't need them
+  // until now)
+
+  AppStatus = gBS->AllocatePool(EfiLoaderData, (NumSectionHdrs * SectionHdrSize), &KernelSectionHdrs);
+
+  if ((AppStatus != EfiSuccess) || (KernelSectionHdrs == NULL)) {
+
+    Message(Error, u"Failed to allocate space for the kernel's section headers.");
+    goto ExitEfiApplication;
+
+  }
+
+  AppStatus = ReadKernelImage(KernelFileProtocol, SectionHdrOffset, (NumSectionHdrs * SectionHdrSize), (void*)KernelSectionHdrs);
+
+  if (AppStatus != EfiSuccess) {
+
+    Message(Error, u"Failed to read the kernel's section headers from disk.");
+    goto ExitEfiApplication;
+
+  }
 
   // (Iterate through each section within the executable to try to find
-  // the dynamic relocation (`.rela.dyn`) section)
+  // the dynamic relocation (`.rela.dyn`) and packed relocation (`.relr.dyn`)
+  // sections)
 
   elfSectionHeader* DynamicRelocationSection = NULL;
+  elfSectionHeader* PackedRelocationSection = NULL;
 
   for (uint64 Index = 0; Index < NumSectionHdrs; Index++) {
 
-    elfSectionHeader* Section = GetSectionHeader((uint64)KernelHeader, Index);
-
-    if (Section->Type == 4) {
+    elfSectionHeader* Section = GetSectionHeader(Index);
 
+    if ((Section->Type == 4) && (DynamicRelocationSection == NULL)) {
       DynamicRelocationSection = Section;
-      break;
-
+    } else if ((Section->Type == 19) && (PackedRelocationSection == NULL)) {
+      PackedRelocationSection = Section;
     }
 
   }
@@ -1280,11 +1587,46 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
     // (Calculate the number of relocations in the section)
 
     auto NumRelocations = (DynamicRelocationSection->Size / sizeof(elfRelocationWithAddend));
-    elfRelocationWithAddend* RelocationList = (elfRelocationWithAddend*)((uintptr)Kernel + DynamicRelocationSection->Offset);
 
     Message(Ok, u"Found `.rela.dyn` section at %xh.", (uintptr)DynamicRelocationSection);
     Message(Info, u"Section appears to contain %d relocation(s).", (uint64)NumRelocations);
 
+    // (The section is usually part of a loadable segment (SHF_ALLOC), in
+    // which case it's already in the kernel area - which also matters if
+    // the kernel image is compressed, since we can't go back and read it
+    // again; otherwise, read it from disk.)
+
+    elfRelocationWithAddend* RelocationList;
+    uint64 RelocationListSize = (NumRelocations * sizeof(elfRelocationWithAddend));
+
+    if (((DynamicRelocationSection->Flags & 2) != 0) && (DynamicRelocationSection->Address <= KernelAreaSize) && (RelocationListSize <= (KernelAreaSize - DynamicRelocationSection->Address))) {
+
+      RelocationList = (elfRelocationWithAddend*)((uintptr)KernelArea + (uintptr)DynamicRelocationSection->Address);
+
+    } else {
+
+      AppStatus = gBS->AllocatePool(EfiLoaderData, RelocationListSize, &KernelRelocations);
+
+      if ((AppStatus != EfiSuccess) || (KernelRelocations == NULL)) {
+
+        Message(Error, u"Failed to allocate space for the kernel's relocations.");
+        goto ExitEfiApplication;
+
+      }
+
+      AppStatus = ReadKernelImage(KernelFileProtocol, DynamicRelocationSection->Offset, RelocationListSize, (void*)KernelRelocations);
+
+      if (AppStatus != EfiSuccess) {
+
+        Message(Error, u"Failed to read the kernel's relocations from disk.");
+        goto ExitEfiApplication;
+
+      }
+
+      RelocationList = (elfRelocationWithAddend*)KernelRelocations;
+
+    }
+
     // (Handle each relocation)
 
     for (uint64 Index = 0; Index < NumRelocations; Index++) {
@@ -1331,6 +1673,69 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
   }
 
+  // If the kernel was linked with `-z pack-relative-relocs`, then most (if
+  // not all) of its relative relocations will be in `.relr.dyn` instead,
+  // which is much smaller, and can be applied in one pass.
+
+  // (This section is always part of a loadable segment, so we don't need
+  // to read anything else from disk - it's already in the kernel area.)
+
+  if (PackedRelocationSection != NULL) {
+
+    uint64 NumPackedEntries = (PackedRelocationSection->Size / sizeof(elfPackedRelocation));
+    uint64 NumPackedRelocations = 0;
+
+    Message(Ok, u"Found `.relr.dyn` section at %xh.", (uintptr)PackedRelocationSection);
+    Message(Info, u"Section appears to contain %d packed relocation entries.", NumPackedEntries);
+
+    if (((PackedRelocationSection->Flags & 2) == 0) || (PackedRelocationSection->Address > KernelAreaSize) || (PackedRelocationSection->Size > (KernelAreaSize - PackedRelocationSection->Address))) {
+
+      Message(Error, u"Kernel's `.relr.dyn` section isn't part of a loadable segment.");
+      goto ExitEfiApplication;
+
+    }
+
+    const elfPackedRelocation* PackedRelocationList = (const elfPackedRelocation*)((uintptr)KernelArea + (uintptr)PackedRelocationSection->Address);
+
+    if (ApplyPackedRelocations((uintptr)KernelArea, KernelAreaSize, PackedRelocationList, NumPackedEntries, &NumPackedRelocations) == false) {
+
+      Message(Error, u"Kernel's `.relr.dyn` section refers to an address outside of the kernel area.");
+      goto ExitEfiApplication;
+
+    }
+
+    Message(Ok, u"Successfully processed %d packed relative relocation(s).", NumPackedRelocations);
+
+  }
+
+  // (We're done reading from the kernel image, so we can close it, and
+  // free anything we don't need anymore)
+
+  gBS->FreePool((void*)KernelSectionHdrs);
+  KernelSectionHdrs = NULL;
+
+  if (KernelRelocations != NULL) {
+
+    gBS->FreePool((void*)KernelRelocations);
+    KernelRelocations = NULL;
+
+  }
+
+  if (IsKernelCompressed == true) {
+
+    gBS->FreePool((void*)KernelCompressedBlock);
+    gBS->FreePool((void*)KernelDecompressedBlock);
+
+    KernelCompressedBlock = NULL;
+    KernelDecompressedBlock = NULL;
+
+    IsKernelCompressed = false;
+
+  }
+
+  KernelFileProtocol->Close(KernelFileProtocol);
+  KernelFileProtocol = NULL;
+
 
 
   // [Obtain the system memory map]
@@ -1477,42 +1882,19 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
   }
 
-  // (Sort each entry by their starting address)
+  // (Sort each entry by their starting address, and then build a 'clean'
+  // list of every usable area, with overlapping and adjacent entries
+  // merged and reserved areas cut out; see Common/Memory/Mmap.c)
 
   // Since we can't dynamically allocate memory without changing the
-  // memory map, we need a sorting algorithm that uses no additional
-  // space, like insertion sort:
-
-  for (uint16 Threshold = 1; Threshold < NumMmapEntries; Threshold++) {
+  // memory map, both of these work in place, or on the usable memory
+  // map buffer we allocated earlier (which has space for one entry per
+  // memory map entry, which is always enough).
 
-    for (uint16 Position = Threshold; Position > 0; Position--) {
+  SortMmap((void*)Mmap, NumMmapEntries, MmapDescriptorSize, QueryMmapEntry);
 
-      // (Get the actual entries themselves)
-
-      efiMemoryDescriptor* Entry = GetMmapEntry(Mmap, MmapDescriptorSize, Position);
-      efiMemoryDescriptor* PreviousEntry = GetMmapEntry(Mmap, MmapDescriptorSize, (Position - 1));
-
-      // (Use insertion sort to sort the entries; while Mmap[n] < Mmap[n-1],
-      // swap them both, and decrement n.)
-
-      if (Entry->PhysicalStart < PreviousEntry->PhysicalStart) {
-        Memswap((void*)Entry, (void*)PreviousEntry, MmapDescriptorSize);
-      }
-
-      // (If we have two entries with the same starting point, make sure
-      // that the 'usable' one always comes last)
-
-      if (Entry->PhysicalStart == PreviousEntry->PhysicalStart) {
-
-        if (PreviousEntry->Type == EfiConventionalMemory) {
-          Memswap((void*)Entry, (void*)PreviousEntry, MmapDescriptorSize);
-        }
-
-      }
-
-    }
-
-  }
+  uint32 NumNormalizedEntries = NormalizeMmap((const void*)Mmap, NumMmapEntries, MmapDescriptorSize, QueryMmapEntry,
+                                              UsableMmap, NumMmapEntries, 4096, 4096);
 
   // Now that we've sorted the memory map, we can move onto the next part:
   // actually building the usable memory map.
@@ -1526,68 +1908,18 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
   uint64 UsableOffset = 0;
 
-  // In this case, the usable memory map is simply just a 'simplified'
-  // memory map that accounts for overlapping and duplicate entries, and
-  // that *only* contains memory that the kernel can use.
-
   // Since we don't plan on calling ExitBootServices(), that means we're
   // still running 'alongside' the firmware - that means we need to set
   // aside some space for it, as well as explicitly allocate any memory
   // meant for the kernel.
 
-  uint16 MmapPositionThreshold = 0;
-  uint64 UsableMmapThreshold = 0;
-
-  for (uint16 Position = 0; Position < NumMmapEntries; Position++) {
-
-    // (Find the first entry that starts on or at UsableMmapThreshold, of
-    // type EfiConventionalMemory)
-
-    efiMemoryDescriptor* Entry = NULL;
-
-    for (uint16 MmapPosition = MmapPositionThreshold; MmapPosition < NumMmapEntries; MmapPosition++) {
-
-      efiMemoryDescriptor* MmapEntry = GetMmapEntry(Mmap, MmapDescriptorSize, MmapPosition);
-
-      if (MmapEntry->Type == EfiConventionalMemory) {
-
-        if (MmapEntry->PhysicalStart >= UsableMmapThreshold) {
+  // (Entries are only ever removed from the usable memory map here, so we
+  // can safely overwrite it as we go along)
 
-          Entry = MmapEntry;
+  for (uint32 Position = 0; Position < NumNormalizedEntries; Position++) {
 
-          MmapPositionThreshold = (MmapPosition + 1);
-          UsableMmapThreshold = MmapEntry->PhysicalStart;
-
-          break;
-
-        }
-
-      }
-
-    }
-
-    if (Entry == NULL) {
-      break;
-    }
-
-    // (Now that we've found it, compare it with the starting position of
-    // the next entry and update the entry size if the two overlap)
-
-    uint64 Start = Entry->PhysicalStart;
-    uint64 Size = (Entry->NumberOfPages * 4096);
-
-    if (MmapPositionThreshold < NumMmapEntries) {
-
-      const efiMemoryDescriptor* NextEntry = GetMmapEntry(Mmap, MmapDescriptorSize, MmapPositionThreshold);
-
-      if (NextEntry->PhysicalStart < (Start + Size)) {
-
-        Entry->NumberOfPages = (NextEntry->PhysicalStart - Start) / 4096;
-        Size = (NextEntry->PhysicalStart - Start);
-
-      }
-
-    }
+    uint64 Start = UsableMmap[Position].Base;
+    uint64 Size = UsableMmap[Position].Limit;
 
     // (Make sure we have enough memory for the firmware, as defined in
     // MinFirmwareMemory (see Bootloader.h))
@@ -1624,6 +1956,10 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
       auto Remainder = (4096 - (Start % 4096));
 
+      if (Size < Remainder) {
+        continue;
+      }
+
       Start += Remainder;
       Size -= Remainder;
 
@@ -1672,9 +2008,18 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
     AppStatus = EfiOutOfResources;
     goto ExitEfiApplication;
 
-  } else {
+  }
+
+  HasAllocatedMemory = true;
+
+  if (VerifyUsableMmap(UsableMmap, NumUsableMmapEntries, 4096, MmapEntryMemoryLimit) != MmapIsValid) {
 
-    HasAllocatedMemory = true;
+    Message(Fail, u"Unable to process the system memory map; the usable memory map is invalid.");
+
+    AppStatus = EfiAborted;
+    goto ExitEfiApplication;
+
+  } else {
 
     Message(Ok, u"Allocated %d MiB of space (over %d usable memory area(s)) for the kernel.",
             (UsableMemory / 1048576), (uint64)NumUsableMmapEntries);
@@ -1961,12 +2306,6 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
     }
 
-    // If we've allocated memory *for the kernel file*, then free it.
-
-    if (HasAllocatedKernel == true) {
-      gBS->FreePages((efiPhysicalAddress)Kernel, AlignDivision(KernelSize, 4096));
-    }
-
     // If we've allocated memory *for the kernel itself*, then free it.
 
     if (HasAllocatedKernelArea == true) {
@@ -1983,6 +2322,10 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
     if (HasOpenedFsHandles == true) {
 
+      if (KernelFileProtocol != NULL) {
+        KernelFileProtocol->Close(KernelFileProtocol);
+      }
+
       if (FileProtocol != NULL) {
         FileProtocol->Close(FileProtocol);
       }
@@ -2016,7 +2359,13 @@ efiStatus efiAbi SEfiBootloader(efiHandle ImageHandle, efiSystemTable* SystemTab
 
     #define FreePoolIfAllocated(Ptr) if (Ptr != NULL) gBS->FreePool((void*)Ptr);
 
+    FreePoolIfAllocated(Kernel);
     FreePoolIfAllocated(KernelInfo);
+    FreePoolIfAllocated(KernelProgramHdrs);
+    FreePoolIfAllocated(KernelSectionHdrs);
+    FreePoolIfAllocated(KernelRelocations);
+    FreePoolIfAllocated(KernelCompressedBlock);
+    FreePoolIfAllocated(KernelDecompressedBlock);
     FreePoolIfAllocated(Mmap);
     FreePoolIfAllocated(UsableMmap);
 
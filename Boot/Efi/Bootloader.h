@@ -14,6 +14,9 @@
   #include "Memory/Memory.h"
 
   #include "../../Common/Common.h"
+  #include "../../Common/Compression/Lz4.h"
+  #include "../../Common/Elf/Relocations.h"
+  #include "../../Common/Memory/Mmap.h"
 
   // Declare functions in Bootloader.c and Stub.asm.
 
@@ -55,4 +58,7 @@
   void* KernelEntrypoint = NULL;
   void* KernelStack = NULL;
 
+  lz4Stream KernelStream = {0}; // (Only used if the kernel image is compressed)
+  bool IsKernelCompressed = false;
+
 #endif
@@ -54,6 +54,7 @@
   typedef efiStatus (efiAbi *efiFileGetInfo) (efiProtocol This, const efiUuid* InformationType, volatile uint64* BufferSize, volatile void* Buffer);
   typedef efiStatus (efiAbi *efiFileOpen) (efiProtocol This, volatile efiProtocol* NewHandle, char16* FileName, uint64 OpenMode, uint64 Attributes);
   typedef efiStatus (efiAbi *efiFileRead) (efiProtocol This, volatile uint64* BufferSize, volatile void* Buffer);
+  typedef efiStatus (efiAbi *efiFileSetPosition) (efiProtocol This, uint64 Position);
 
   typedef struct _efiFileProtocol {
 
@@ -67,7 +68,7 @@
     efiNotImplemented Write;
 
     efiNotImplemented GetPosition;
-    efiNotImplemented SetPosition;
+    efiFileSetPosition SetPosition;
 
     efiFileGetInfo GetInfo;
     efiNotImplemented SetInfo;
@@ -75,7 +75,7 @@
   typedef struct _elfSectionHeader {
 
     uint32 NameOffset; // (The offset for the name string, in .shstrtab (StringSectionIndex))
-    uint32 Type; // (1 = load, 3 = string, 4 = relocations, otherwise ignore)
+    uint32 Type; // (1 = load, 3 = string, 4 = relocations, 19 = packed relocations, otherwise ignore)
     uint64 Flags; // (Can be ignored)
 
     uint64 Address; // (Same as elfProgramHeader->VirtAddress)
@@ -107,6 +107,12 @@
 
   } __attribute__((packed)) elfRelocationWithAddend;
 
+  // (Packed relative relocations (`.relr.dyn`, or DT_RELR) are stored as a
+  // list of 64-bit entries - an even entry is the offset of a relocation,
+  // and an odd entry is a bitmap of the next 63 words after it)
+
+  typedef uint64 elfPackedRelocation;
+
   static_assert((sizeof(elfHeader) == 64), "elfHeader{} was not packed correctly by the compiler.");
   static_assert((sizeof(elfProgramHeader) == 56), "elfProgramHeader{} was not packed correctly by the compiler.");
   static_assert((sizeof(elfSectionHeader) == 64), "elfSectionHeader{} was not packed correctly by the compiler.");
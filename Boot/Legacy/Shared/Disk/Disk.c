@@ -96,6 +96,10 @@ realModeTable* ReadSector(uint16 NumBlocks, uint32 Address, uint64 Offset) {
    Otherwise, it runs in the same way as ReadSector(); *just be careful to avoid exceeding
    the stack size, since this function allocates a buffer/cache.*
 
+   (If the logical and physical sector sizes match, and the destination can be reached by
+   the disk address packet (it's below DirectReadLimit), then this function skips the cache
+   entirely and reads straight into Address, which is a lot faster.)
+
 */
 
 realModeTable* ReadFatSector(uint16 NumBlocks, uint32 Address, uint32 Lba) {
@@ -125,7 +129,14 @@ realModeTable* ReadFatSector(uint16 NumBlocks, uint32 Address, uint32 Lba) {
 
   }
 
-  // Next, we'll want to create a temporary array to store the data we're reading from
+  // If the logical and physical sector sizes are the same - and the destination is low
+  // enough in memory that the BIOS can reach it - then we can just read it directly.
+
+  if ((PhysicalSectorSize == LogicalSectorSize) && ((Address + (LogicalSectorSize * NumBlocks)) <= DirectReadLimit)) {
+    return ReadSector(NumSectors, Address, PhysicalLba);
+  }
+
+  // Otherwise, we'll want to create a temporary array to store the data we're reading from
   // disk. We can't just directly use ReadSector() on Address, since the size of a physical
   // sector might exceed the size of a logical sector, so instead, we do this:
 
@@ -144,7 +155,7 @@ realModeTable* ReadFatSector(uint16 NumBlocks, uint32 Address, uint32 Lba) {
 }
 
 
-/* uint32 GetFatEntry()
+/* static uint32 ReadFatEntry()
 
    Inputs: uint32 ClusterNum - The cluster number that we want to check the FAT for.
 
@@ -156,22 +167,22 @@ realModeTable* ReadFatSector(uint16 NumBlocks, uint32 Address, uint32 Lba) {
 
            bool IsFat32 - Whether this partition is FAT16 (false) or FAT32 (true).
 
-   Outputs: uint32 - The cluster number indicated in the FAT (file allocation table).
+           uint8* Buffer - A buffer (the size of one logical sector) that holds the FAT
+           sector that was last read by this function.
 
-   This function reads a given partition's FAT (file allocation table) in order to find the
-   next cluster indicated by the FAT, which is useful for following cluster chains.
+           uint32* BufferLba - The LBA of the FAT sector currently in Buffer (or FFFFFFFFh,
+           if the buffer doesn't contain anything yet).
 
-   Every cluster is part of a cluster chain, which is basically a singly-linked list of
-   clusters, and the data structure that contains the information about these cluster chains
-   is called the File Allocation Table (FAT).
+   Outputs: uint32 - The cluster number indicated in the FAT (file allocation table), or
+   zero if we weren't able to read from the disk.
 
-   The role of this function is to read the FAT to find the next cluster for a given cluster;
-   for example, if there's a cluster chain like 1234h -> 5678h, then that means the FAT entry
-   for the cluster 1234h is 5678h, and this function helps find that.
+   This function does the actual work behind GetFatEntry(), but it only reads a sector of
+   the FAT from disk if it isn't already in Buffer. Since cluster chains are usually laid
+   out sequentially, this means most lookups don't need to go through int 13h at all.
 
 */
 
-uint32 GetFatEntry(uint32 ClusterNum, uint32 PartitionOffset, uint32 FatOffset, bool IsFat32) {
+static uint32 ReadFatEntry(uint32 ClusterNum, uint32 PartitionOffset, uint32 FatOffset, bool IsFat32, uint8* Buffer, uint32* BufferLba) {
 
   // If this is FAT32, then since each cluster entry is 4 bytes long (instead of 2),
   // multiply the cluster number by 2.
@@ -185,21 +196,26 @@ uint32 GetFatEntry(uint32 ClusterNum, uint32 PartitionOffset, uint32 FatOffset,
   uint32 SectorOffset = (PartitionOffset + FatOffset + ((ClusterNum * 2) / LogicalSectorSize));
   uint16 EntryOffset = (uint16)((ClusterNum * 2) % LogicalSectorSize);
 
-  // Next, we want to create a temporary buffer (with the same size as one sector), and then
-  // load that part of the FAT onto it:
+  // Next, if the buffer doesn't already contain that part of the FAT, then we want to
+  // load it in, and see if it succeeded (if it didn't, return zero).
 
-  uint8 Buffer[LogicalSectorSize];
-  Memset(&Buffer[0], '\0', LogicalSectorSize);
+  if (*BufferLba != SectorOffset) {
+
+    const realModeTable* Table = ReadFatSector(1, (uint32)(int)&Buffer[0], SectorOffset);
 
-  const realModeTable* Table = ReadFatSector(1, (uint32)(int)&Buffer[0], SectorOffset);
+    if (hasFlag(Table->Eflags, CarryFlag)) {
 
-  // Finally, we want to see if it succeeded, and if it did, return the corresponding entry
-  // from the FAT; otherwise, return zero.
+      *BufferLba = 0xFFFFFFFF;
+      return 0;
+
+    }
+
+    *BufferLba = SectorOffset;
 
-  if (hasFlag(Table->Eflags, CarryFlag)) {
-    return 0;
   }
 
+  // Finally, we want to return the corresponding entry from the FAT.
+
   uint32 ClusterEntry;
   uintptr ClusterEntryPtr = (uintptr)&Buffer[EntryOffset];
 
@@ -214,6 +230,46 @@ uint32 GetFatEntry(uint32 ClusterNum, uint32 PartitionOffset, uint32 FatOffset,
 }
 
 
+/* uint32 GetFatEntry()
+
+   Inputs: uint32 ClusterNum - The cluster number that we want to check the FAT for.
+
+           uint32 PartitionOffset - The first LBA of the current partition (relative to the
+           start of the disk itself; this is the same as the number of hidden sectors).
+
+           uint32 FatOffset - The first LBA of this partition's FAT (relative to the start of
+           the partition itself; this is the same as the number of reserved sectors).
+
+           bool IsFat32 - Whether this partition is FAT16 (false) or FAT32 (true).
+
+   Outputs: uint32 - The cluster number indicated in the FAT (file allocation table).
+
+   This function reads a given partition's FAT (file allocation table) in order to find the
+   next cluster indicated by the FAT, which is useful for following cluster chains.
+
+   Every cluster is part of a cluster chain, which is basically a singly-linked list of
+   clusters, and the data structure that contains the information about these cluster chains
+   is called the File Allocation Table (FAT).
+
+   The role of this function is to read the FAT to find the next cluster for a given cluster;
+   for example, if there's a cluster chain like 1234h -> 5678h, then that means the FAT entry
+   for the cluster 1234h is 5678h, and this function helps find that.
+
+*/
+
+uint32 GetFatEntry(uint32 ClusterNum, uint32 PartitionOffset, uint32 FatOffset, bool IsFat32) {
+
+  // We want to create a temporary buffer (with the same size as one sector), and then
+  // let ReadFatEntry() load that part of the FAT onto it:
+
+  uint8 Buffer[LogicalSectorSize];
+  uint32 BufferLba = 0xFFFFFFFF;
+
+  return ReadFatEntry(ClusterNum, PartitionOffset, FatOffset, IsFat32, &Buffer[0], &BufferLba);
+
+}
+
+
 /* static bool FatNameIsEqual()
 
    Inputs: const char EntryName[8] - The name specified in the entry we want to compare.
@@ -401,12 +457,17 @@ fatDirectory FindDirectory(uint32 ClusterNum, uint8 SectorsPerCluster, uint32 Pa
 }
 
 
-/* void ReadFile()
+/* bool ReadFileRange()
 
    Inputs: void* Address - The address we want to read the file *to*.
 
            fatDirectory Entry - The (directory) entry of the file we want to read *from*.
 
+           uint32 Position - The offset within the file that we want to start reading from,
+           in bytes.
+
+           uint32 Size - The number of bytes we want to read (starting from Position).
+
            uint8 SectorsPerCluster - The amount of sectors per cluster (specified by the BPB).
 
            uint32 PartitionOffset - The first LBA of the current partition (relative to the
@@ -422,17 +483,21 @@ fatDirectory FindDirectory(uint32 ClusterNum, uint8 SectorsPerCluster, uint32 Pa
 
    Outputs: bool - Whether the operation was successful (true) or not (false).
 
-   This function reads the contents of a file from disk to memory, given an address to load
-   it to, and the directory entry of the file we want to read from (as returned by
-   FindDirectory()).
+   This function reads a specific byte range of a file from disk to memory, given an address
+   to load it to, and the directory entry of the file we want to read from (as returned by
+   FindDirectory()); exactly Size bytes are written to Address, and nothing beyond that.
 
-   Despite being more inefficient, this function saves on memory space by only loading one
-   logical sector at a time, since the individual cluster size may exceed the remaining space
-   on the stack.
+   In order to keep the number of int 13h calls down, this function looks ahead in the
+   cluster chain, and merges any physically adjacent clusters into a single transfer (of up
+   to MaxDapSectors sectors or MaxDapTransferSize bytes, or MaxBounceSize bytes if
+   ReadFatSector() needs its cache).
+
+   (Whole sectors are read straight into Address; only the partial sectors at the start
+   and end of the range go through a temporary buffer.)
 
 */
 
-bool ReadFile(void* Address, fatDirectory Entry, uint8 SectorsPerCluster, uint32 PartitionOffset, uint32 FatOffset, uint32 DataOffset, bool IsFat32) {
+bool ReadFileRange(void* Address, fatDirectory Entry, uint32 Position, uint32 Size, uint8 SectorsPerCluster, uint32 PartitionOffset, uint32 FatOffset, uint32 DataOffset, bool IsFat32) {
 
   // (Define limits for FAT16 and FAT32)
 
@@ -442,73 +507,166 @@ bool ReadFile(void* Address, fatDirectory Entry, uint8 SectorsPerCluster, uint32
     Limit = 0x0FFFFFF6;
   }
 
-  // Before we do anything, we want to get two variables from the entry we were given - the
-  // initial starting cluster, and the size of the file we're reading.
+  // Before we do anything, let's make sure the range we were given actually falls within
+  // the file, and get the initial starting cluster.
+
+  if ((Position > Entry.Size) || (Size > (Entry.Size - Position))) {
+    return false;
+  } else if (Size == 0) {
+    return true;
+  }
 
   uint32 ClusterNum = GetDirectoryCluster(Entry);
-  uint32 Size = Entry.Size;
 
-  // Next, we want to actually start reading from the file, until we hit either the end of
-  // the cluster chain, or the end of the file. We'll be keeping track of the offset and the
-  // number of bytes read using the Offset variable.
+  // Next, we want to figure out how many logical sectors we can read at once. The disk
+  // address packet can only hold so many sectors, and if ReadFatSector() can't read
+  // directly to Address, then we also need to fit within its on-stack cache.
 
-  uint32 Offset = 0;
+  // (The extra physical sector accounts for reads that don't start on a physical
+  // sector boundary; on top of that, the BIOS writes through a single segment:offset
+  // window, so no transfer can be larger than MaxDapTransferSize bytes, even on disks
+  // with 4 KiB sectors)
 
-  while (!ExceedsLimit(ClusterNum, Limit)) {
+  uint32 TransferLimit = (((MaxDapSectors - 1) * PhysicalSectorSize) / LogicalSectorSize);
 
-    // We'll only be reading up to SectorReadLimit sectors at a time, in order to
-    // conserve memory space, as the cluster size can sometimes be bigger than the
-    // stack size.
+  if (TransferLimit > (MaxDapTransferSize / LogicalSectorSize)) {
+    TransferLimit = (MaxDapTransferSize / LogicalSectorSize);
+  }
 
-    // (In this case, SectorReadLimit = (0.5 * stack size) / (logical sector size))
+  if ((PhysicalSectorSize != LogicalSectorSize) || (((uint32)(int)Address + Size) > DirectReadLimit)) {
 
-    uint32 ClusterOffset = ((ClusterNum - 2) * SectorsPerCluster);
-    uint8 SectorReadLimit = (32768 / LogicalSectorSize);
+    if (TransferLimit > (MaxBounceSize / LogicalSectorSize)) {
+      TransferLimit = (MaxBounceSize / LogicalSectorSize);
+    }
 
-    // For every sector in the current cluster..
+  }
 
-    uint32 SectorNum = 0;
+  // We'll also keep a copy of the last FAT sector we read, since most cluster chains are
+  // sequential, and we don't want to read the same FAT sector over and over again.
 
-    while (SectorNum < SectorsPerCluster) {
+  // (This buffer is also used for partial sectors, in which case we invalidate it.)
 
-      // How many sectors should we read?
+  uint8 Buffer[LogicalSectorSize];
+  uint32 BufferLba = 0xFFFFFFFF;
 
-      uint8 SectorsToRead = SectorReadLimit;
+  // Now, let's skip over every cluster that comes before Position, and figure out where
+  // in the first cluster we should start reading from.
 
-      if ((SectorsPerCluster - SectorNum) < SectorReadLimit) {
-        SectorsToRead = (SectorsPerCluster - SectorNum);
-      }
+  uint32 ClusterSize = (SectorsPerCluster * LogicalSectorSize);
 
-      // Read from the disk, and see if it failed
+  for (uint32 Skip = (Position / ClusterSize); Skip > 0; Skip--) {
 
-      const realModeTable* Table = ReadFatSector(SectorsToRead, (uint32)((int)Address + Offset), (PartitionOffset + DataOffset + ClusterOffset + SectorNum));
-      Offset += (LogicalSectorSize * SectorsToRead);
+    ClusterNum = ReadFatEntry(ClusterNum, PartitionOffset, FatOffset, IsFat32, &Buffer[0], &BufferLba);
 
-      if (hasFlag(Table->Eflags, CarryFlag)) {
+    if ((ClusterNum == 0) || ExceedsLimit(ClusterNum, Limit)) {
+      return false;
+    }
+
+  }
+
+  uint32 SectorOffset = ((Position % ClusterSize) / LogicalSectorSize);
+  uint32 ByteOffset = (Position % LogicalSectorSize);
+
+  // Finally, we want to actually start reading from the file, until we've read the entire
+  // range. We'll be keeping track of the number of bytes read using the Offset variable.
+
+  uint32 Offset = 0;
+
+  while (Offset < Size) {
+
+    // If we've reached the end of the cluster chain before reading everything, then
+    // something's wrong with the file.
+
+    if (ExceedsLimit(ClusterNum, Limit)) {
+      return false;
+    }
+
+    // First, let's look ahead in the cluster chain, to see how many clusters are laid out
+    // contiguously on disk (starting from ClusterNum); we can read all of them at once.
+
+    // (We stop once we've covered the rest of the range, so we don't end up following the
+    // cluster chain for longer than necessary)
+
+    uint32 RunStart = ClusterNum;
+    uint32 RunLength = 0;
+
+    uint32 RunSkip = ((SectorOffset * LogicalSectorSize) + ByteOffset);
+
+    do {
+
+      ClusterNum = ReadFatEntry(ClusterNum, PartitionOffset, FatOffset, IsFat32, &Buffer[0], &BufferLba);
+      RunLength++;
+
+      if (ClusterNum == 0) {
         return false;
       }
 
-      // If we've already reached the end of the file, no need to continue, just end the
-      // function immediately.
+    } while ((ClusterNum == (RunStart + RunLength)) && (((RunLength * ClusterSize) - RunSkip) < (Size - Offset)));
 
-      if (Offset >= Size) {
-        return true;
-      }
+    // Next, let's figure out where this run starts on disk, and how many sectors it has
+    // (excluding any we're skipping over in the first cluster).
 
-      // Update accordingly.
+    uint32 Lba = (PartitionOffset + DataOffset + ((RunStart - 2) * SectorsPerCluster) + SectorOffset);
+    uint32 SectorsLeft = ((RunLength * SectorsPerCluster) - SectorOffset);
 
-      SectorNum += SectorsToRead;
+    SectorOffset = 0;
 
-    }
+    // Now, we can read the run from disk, in chunks of (up to) TransferLimit sectors,
+    // and see if anything failed.
 
-    // Finally, if we've already finished this cluster, then continue to the next cluster
-    // in the chain (if it exceeds the limit, the condition of the while loop will end things
-    // here).
+    while ((SectorsLeft > 0) && (Offset < Size)) {
 
-    ClusterNum = GetFatEntry(ClusterNum, PartitionOffset, FatOffset, IsFat32);
+      const realModeTable* Table;
+      uint32 SectorsToRead;
+
+      if ((ByteOffset != 0) || ((Size - Offset) < LogicalSectorSize)) {
+
+        // If we only need part of this sector, then read it into our buffer, and only
+        // copy the bytes we need.
+
+        uint32 BytesToCopy = (LogicalSectorSize - ByteOffset);
+
+        if (BytesToCopy > (Size - Offset)) {
+          BytesToCopy = (Size - Offset);
+        }
+
+        Table = ReadFatSector(1, (uint32)(int)&Buffer[0], Lba);
+        BufferLba = 0xFFFFFFFF;
+
+        Memcpy((void*)((int)Address + Offset), &Buffer[ByteOffset], BytesToCopy);
+
+        SectorsToRead = 1;
+        Offset += BytesToCopy;
+        ByteOffset = 0;
+
+      } else {
+
+        // Otherwise, read as many whole sectors as we can, straight to Address.
+
+        SectorsToRead = TransferLimit;
+
+        if (SectorsLeft < SectorsToRead) {
+          SectorsToRead = SectorsLeft;
+        }
+
+        if (((Size - Offset) / LogicalSectorSize) < SectorsToRead) {
+          SectorsToRead = ((Size - Offset) / LogicalSectorSize);
+        }
+
+        Table = ReadFatSector((uint16)SectorsToRead, (uint32)((int)Address + Offset), Lba);
+        Offset += (LogicalSectorSize * SectorsToRead);
+
+      }
+
+      // See if reading from the disk failed, and update accordingly.
+
+      if (hasFlag(Table->Eflags, CarryFlag)) {
+        return false;
+      }
+
+      SectorsLeft -= SectorsToRead;
+      Lba += SectorsToRead;
 
-    if (ClusterNum == 0) {
-      return false;
     }
 
   }
@@ -518,3 +676,37 @@ bool ReadFile(void* Address, fatDirectory Entry, uint8 SectorsPerCluster, uint32
   return true;
 
 }
+
+
+/* bool ReadFile()
+
+   Inputs: void* Address - The address we want to read the file *to*.
+
+           fatDirectory Entry - The (directory) entry of the file we want to read *from*.
+
+           uint8 SectorsPerCluster - The amount of sectors per cluster (specified by the BPB).
+
+           uint32 PartitionOffset - The first LBA of the current partition (relative to the
+           start of the disk itself; this is the same as the number of hidden sectors).
+
+           uint32 FatOffset - The first LBA of this partition's FAT (relative to the start of
+           the partition itself; this is the same as the number of reserved sectors).
+
+           uint32 DataOffset - The first LBA of this partition's data section (relative to
+           the start of the partition itself).
+
+           bool IsFat32 - Whether this partition is FAT16 (false) or FAT32 (true).
+
+   Outputs: bool - Whether the operation was successful (true) or not (false).
+
+   This function reads the entire contents of a file from disk to memory, given an address
+   to load it to, and the directory entry of the file we want to read from (as returned by
+   FindDirectory()); it's just a wrapper around ReadFileRange().
+
+*/
+
+bool ReadFile(void* Address, fatDirectory Entry, uint8 SectorsPerCluster, uint32 PartitionOffset, uint32 FatOffset, uint32 DataOffset, bool IsFat32) {
+
+  return ReadFileRange(Address, Entry, 0, Entry.Size, SectorsPerCluster, PartitionOffset, FatOffset, DataOffset, IsFat32);
+
+}
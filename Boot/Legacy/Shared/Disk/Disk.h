@@ -137,6 +137,11 @@
   extern uint16 LogicalSectorSize;
   extern uint16 PhysicalSectorSize;
 
+  #define DirectReadLimit 0x100000 // (Anything below this can be reached by the disk address packet)
+  #define MaxBounceSize 32768 // (The largest cache ReadFatSector() should allocate, in bytes)
+  #define MaxDapSectors 127 // (The largest number of sectors *every* EDD BIOS accepts at once)
+  #define MaxDapTransferSize 0xFFF0 // (The largest transfer that fits in one segment:offset window, in bytes)
+
   realModeTable* ReadSector(uint16 NumBlocks, uint32 Address, uint64 Offset);
   realModeTable* ReadFatSector(uint16 NumBlocks, uint32 Address, uint32 Lba);
 
@@ -149,6 +154,7 @@
 
   uint32 GetFatEntry(uint32 ClusterNum, uint32 PartitionOffset, uint32 FatOffset, bool IsFat32);
   fatDirectory FindDirectory(uint32 ClusterNum, uint8 SectorsPerCluster, uint32 PartitionOffset, uint32 FatOffset, uint32 DataOffset, char Name[8], char Extension[3], bool IsFolder, bool IsFat32);
+  bool ReadFileRange(void* Address, fatDirectory Entry, uint32 Position, uint32 Size, uint8 SectorsPerCluster, uint32 PartitionOffset, uint32 FatOffset, uint32 DataOffset, bool IsFat32);
   bool ReadFile(void* Address, fatDirectory Entry, uint8 SectorsPerCluster, uint32 PartitionOffset, uint32 FatOffset, uint32 DataOffset, bool IsFat32);
 
 #endif
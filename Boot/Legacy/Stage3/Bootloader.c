@@ -38,6 +38,96 @@ void RestoreState(void) {
 }
 
 
+/* static bool ReadKernelFile()
+
+   Inputs: const kernelFileInfo* File - Information about the kernel file;
+           void* Address - The address we want to read *to*;
+           uint32 Position - The offset within the file to start reading from;
+           uint32 Size - The number of bytes we want to read.
+
+   Outputs: bool - Whether we were able to read Size bytes from the file.
+
+   This function reads a specific byte range of the kernel file, using
+   ReadFileRange() (from Shared/Disk/Disk.c) - or, if the kernel is
+   compressed, by decompressing that range with Lz4ReadStream() instead
+   (which means the file can only be read *forwards*).
+
+*/
+
+static bool ReadKernelFile(const kernelFileInfo* File, void* Address, uint32 Position, uint32 Size) {
+
+  // (If the kernel is compressed, then decompress the range we want)
+
+  if (File->Stream != NULL) {
+
+    if ((Position > File->Stream->Info.ContentSize) || (Size > (File->Stream->Info.ContentSize - Position))) {
+      return false;
+    }
+
+    return Lz4ReadStream(File->Stream, Position, Address, Size);
+
+  }
+
+  // (Otherwise, read it from disk)
+
+  return ReadFileRange(Address, File->Directory, Position, Size, File->SectorsPerCluster, File->PartitionOffset, File->FatOffset, File->DataOffset, File->IsFat32);
+
+}
+
+
+/* static bool ReadCompressedKernel()
+
+   Inputs: void* Context - A pointer to the kernel's kernelFileInfo{} table;
+           uint64 Position - The offset within the file to start reading from;
+           void* Buffer - The buffer we want to read *to*;
+           uint32 Size - The number of bytes we want to read.
+
+   Outputs: bool - Whether we were able to read Size bytes from the file.
+
+   This function is passed on to Lz4OpenStream() (in Common/Compression/
+   Lz4.c), so it can read each compressed block straight from disk as it
+   needs it.
+
+*/
+
+static bool ReadCompressedKernel(void* Context, uint64 Position, void* Buffer, uint32 Size) {
+
+  const kernelFileInfo* File = (const kernelFileInfo*)Context;
+
+  if (Position > File->Directory.Size) {
+    return false;
+  }
+
+  return ReadFileRange(Buffer, File->Directory, (uint32)Position, Size, File->SectorsPerCluster, File->PartitionOffset, File->FatOffset, File->DataOffset, File->IsFat32);
+
+}
+
+
+/* static bool QueryMmapEntry()
+
+   Inputs: const void* Entry - The (E820) memory map entry we want to read;
+           uint64* Base - Where to save the start of the area it covers;
+           uint64* Size - Where to save the size of that area, in bytes.
+
+   Outputs: bool - Whether the area is usable (type 1).
+
+   This function is passed on to SortMmap() and NormalizeMmap() (in
+   Common/Memory/Mmap.c), so they can read E820 memory map entries.
+
+*/
+
+static bool QueryMmapEntry(const void* Entry, uint64* Base, uint64* Size) {
+
+  const mmapEntry* MmapEntry = (const mmapEntry*)Entry;
+
+  *Base = MmapEntry->Base;
+  *Size = MmapEntry->Limit;
+
+  return (MmapEntry->Type == 1);
+
+}
+
+
 /* void S3Bootloader()
 
    Inputs: (none, except for InfoTable)
@@ -276,7 +366,6 @@ void S3Bootloader(void) {
   // Now, let's actually go ahead and fill MmapBuffer:
 
   uint8 NumMmapEntries = 0;
-  uint8 NumUsableMmapEntries = 0;
 
   uint32 MmapContinuation = 0;
 
@@ -286,13 +375,6 @@ void S3Bootloader(void) {
 
     MmapContinuation = GetMmapEntry((void*)&Mmap[NumMmapEntries], sizeof(mmapEntry), MmapContinuation);
 
-    // Get the number of *usable* memory map entries (type 1 means free
-    // memory) - this will be useful later on, for UsableMmap
-
-    if (Mmap[NumMmapEntries].Type == 1) {
-      NumUsableMmapEntries++;
-    }
-
     // Increment the number of entries, and break if we've reached the
     // memory map entry limit (MaxMmapEntries)
 
@@ -336,28 +418,9 @@ void S3Bootloader(void) {
   Message(Boot, "Preparing to process the system memory map.");
 
   // The first step here is to just sort each entry according to
-  // its base address, like this:
-
-  for (auto Threshold = 1; Threshold < NumMmapEntries; Threshold++) {
-
-    for (auto Position = Threshold; Position > 0; Position--) {
-
-      // (Use insertion sort to sort the entries; while Mmap[n] < Mmap[n-1],
-      // swap them both, and decrement n)
+  // its base address (see Common/Memory/Mmap.c):
 
-      if (Mmap[Position].Base < Mmap[Position - 1].Base) {
-
-        Memswap((void*)(int)&Mmap[Position], (void*)(int)&Mmap[Position - 1], sizeof(mmapEntry));
-
-      } else {
-
-        break;
-
-      }
-
-    }
-
-  }
+  SortMmap((void*)Mmap, NumMmapEntries, sizeof(mmapEntry), QueryMmapEntry);
 
   // (Show system memory map entries)
 
@@ -375,100 +438,23 @@ void S3Bootloader(void) {
   }
 
   // Next, we just need to isolate all the usable entries, and deal
-  // with overlapping entries.
-
-  uint8 UsableMmapBuffer[sizeof(usableMmapEntry) * NumUsableMmapEntries] = {};
-  usableMmapEntry* UsableMmap = (usableMmapEntry*)UsableMmapBuffer;
-
-  uint64 MinStart = 0;
-  uint8 UsablePosition = 0;
-
-  for (auto Position = 0; Position < NumMmapEntries; Position++) {
-
-    // First, get the start and end position of this entry
-
-    auto Start = Mmap[Position].Base;
-    auto End = (Start + Mmap[Position].Limit);
-
-    // Next, update the minimum start, and skip over any entries that
-    // end before it (decrementing NumUsableMmapEntries accordingly).
-
-    if (Start < MinStart) {
-      Start = MinStart;
-    }
-
-    if (End <= MinStart) {
-
-      if (Mmap[Position].Type == 1) {
-        NumUsableMmapEntries--;
-      }
-
-      continue;
-
-    }
-
-    // Finally, if the entry doesn't overlap with another entry
-    // *and* has the right type, we can add it to UsableMmap.
-
-    if (Mmap[Position].Type == 1) {
-
-      // Update the start variable, if necessary
-
-      if (Start < MinStart) {
-        Start = MinStart;
-      }
-
-      // Update the end variable; for this, we only need to check
-      // for the next entry, as the list of entries is already
-      // sorted for us
-
-      if (Position < (NumMmapEntries - 1)) {
-
-        if (End > Mmap[Position + 1].Base) {
-          End = Mmap[Position + 1].Base;
-        }
+  // with overlapping entries; NormalizeMmap() merges overlapping and
+  // adjacent usable entries, cuts out anything that's reserved, aligns
+  // everything to page size boundaries, and removes any entries under
+  // `MmapEntryMemoryLimit` bytes.
 
-      }
-
-      // Align our usable entry to page size boundaries, just
-      // in case.
-
-      if ((Start % 4096) != 0) {
-
-        auto Remainder = (4096 - (Start % 4096));
-        Start += Remainder;
-
-      }
-
-      if ((End % 4096) != 0) {
-
-        auto Remainder = (End % 4096);
-        End -= Remainder;
-
-      }
-
-      // Check if the entry size is at least `MmapEntryMemoryLimit`
-      // bytes; if not, skip it.
-
-      auto Size = (End - Start);
+  // (Splitting usable entries around reserved ones means we can end up
+  // with more usable entries than there were to begin with, but never
+  // more than NumMmapEntries)
 
-      if (Size < MmapEntryMemoryLimit) {
-        NumUsableMmapEntries--;
-        continue;
-      }
-
-      // Finally, add the entry to the usable memory map area,
-      // and increment the position
-
-      UsableMmap[UsablePosition].Base = Start;
-      UsableMmap[UsablePosition].Limit = (End - Start);
-
-      UsablePosition++;
-
-    }
+  uint8 UsableMmapBuffer[sizeof(usableMmapEntry) * NumMmapEntries] = {};
+  usableMmapEntry* UsableMmap = (usableMmapEntry*)UsableMmapBuffer;
 
-    MinStart = End;
+  uint8 NumUsableMmapEntries = NormalizeMmap((const void*)Mmap, NumMmapEntries, sizeof(mmapEntry), QueryMmapEntry,
+                                             UsableMmap, NumMmapEntries, 4096, MmapEntryMemoryLimit);
 
+  if (VerifyUsableMmap(UsableMmap, NumUsableMmapEntries, 4096, MmapEntryMemoryLimit) != MmapIsValid) {
+    Panic("Failed to process the system's memory map.", 0);
   }
 
   // (Show usable memory map entries)
@@ -567,6 +553,15 @@ void S3Bootloader(void) {
     CommonInfoTable.Firmware.Bios.Pat.IsSupported = true;
   }
 
+  // Finally, check for 1 GiB page support (PDPE1GB); this isn't essential
+  // either, but it lets us map large areas of memory with far fewer page
+  // tables (and TLB entries).
+
+  if (Cpuid_ExtendedFeatures.Edx & (1 << 26)) {
+    Message(Info, "1 GiB pages appear to be supported");
+    PagingData.Supports1GiBPages = true;
+  }
+
 
 
 
@@ -1021,10 +1016,10 @@ void S3Bootloader(void) {
 
 
 
-  // [Allocate space for the kernel and any initial page tables]
+  // [Allocate space for the kernel stack and any initial page tables]
 
   Putchar('\n', 0);
-  Message(Boot, "Preparing to allocate space for the kernel and initial page tables.");
+  Message(Boot, "Preparing to allocate space for the kernel stack and initial page tables.");
 
   // First, we need to find a suitable starting point. The stack isn't large
   // enough for our page tables, so we need to find a new way to allocate
@@ -1038,6 +1033,9 @@ void S3Bootloader(void) {
   // order to actually use the function; in this case, we're just looking
   // for the earliest possible point after 1 MiB (100000h).
 
+  // (We don't allocate any space for the kernel file itself; instead, we
+  // read each of its segments straight to their final location later on.)
+
   uint64 Offset = 0x100000;
 
   for (auto Entry = 0; Entry < NumUsableMmapEntries; Entry++) {
@@ -1051,25 +1049,6 @@ void S3Bootloader(void) {
 
   }
 
-  // Now that we've defined Offset, we can start allocating space from our
-  // usable memory map. We'll start off by allocating space for the kernel
-  // executable:
-
-  uintptr KernelImage = (uintptr)(AllocateFromMmap(Offset, PageAlign(KernelDirectory.Size), false, UsableMmap, NumUsableMmapEntries));
-
-  if (KernelImage == 0) {
-
-    Panic("Unable to allocate enough space for the kernel.", 0);
-
-  } else {
-
-    Offset = KernelImage;
-    KernelImage -= PageAlign(KernelDirectory.Size);
-
-    Message(Ok, "Allocated kernel space between %xh and %xh (in pmem).", KernelImage, (uint32)Offset);
-
-  }
-
   // Next, we should also allocate some space for the kernel stack:
 
   uintptr KernelStackArea = (uintptr)(AllocateFromMmap(Offset, KernelStackSize, false, UsableMmap, NumUsableMmapEntries));
@@ -1172,9 +1151,9 @@ void S3Bootloader(void) {
 
   // Also, if PAT is supported, add support for write-combining by updating
   // its MSR (the default value is usually 0007040600070406h, where PAT4
-  // is 00h (uncached) instead of 01h (write-combining)).
+  // is 06h (write-back) instead of 01h (write-combining)).
 
-  constexpr uint64 PatMsrValue = 0x0007040601070406;
+  constexpr uint64 PatMsrValue = 0x0007040100070406;
 
   if (CommonInfoTable.Firmware.Bios.Pat.IsSupported == true) {
 
@@ -1221,6 +1200,15 @@ void S3Bootloader(void) {
 
   }
 
+  // (Show how many page tables we needed, and how many pages of each
+  // size we ended up mapping)
+
+  Message(Info, "Created %d page tables (in batches of %d), and split %d 1 GiB pages",
+                PagingData.NumTables, PageTableBatchSize, PagingData.NumSplitPages);
+
+  Message(Info, "Mapped %d 4 KiB pages, %d 2 MiB pages and %d 1 GiB pages",
+                (uint32)PagingData.NumPages[0], (uint32)PagingData.NumPages[1], (uint32)PagingData.NumPages[2]);
+
 
 
 
@@ -1229,28 +1217,121 @@ void S3Bootloader(void) {
   Putchar('\n', 0);
   Message(Boot, "Preparing to read the kernel's ELF headers.");
 
-  // First, let's read the kernel file from disk. We already obtained the
-  // directory earlier (KernelDirectory), and allocated space for it in
-  // memory (KernelImage), so all that's left is to call ReadFile().
+  // Before we can read the kernel's ELF headers, we need to check whether
+  // the kernel is compressed. If it's an LZ4 frame, then we decompress
+  // each part of it as we read it (one block at a time, straight to where
+  // it needs to go); this is usually much faster than reading the
+  // uncompressed file, especially on older systems.
 
-  bool ReadFileSuccessful = ReadFile((void*)KernelImage, KernelDirectory, Bpb.SectorsPerCluster, Bpb.HiddenSectors, Bpb.ReservedSectors, DataSectorOffset, PartitionIsFat32);
+  kernelFileInfo KernelFile = {
 
-  if (ReadFileSuccessful == true) {
-    Message(Ok, "Successfully loaded Boot/Serra/Kernel.elf to %xh.", (uint32)KernelImage);
-  } else {
+    .Directory = KernelDirectory,
+
+    .SectorsPerCluster = Bpb.SectorsPerCluster,
+    .PartitionOffset = Bpb.HiddenSectors,
+    .FatOffset = Bpb.ReservedSectors,
+    .DataOffset = DataSectorOffset,
+    .IsFat32 = PartitionIsFat32,
+
+    .Stream = NULL
+
+  };
+
+  lz4Stream KernelStream;
+
+  #define ReadKernelRange(Address, Position, Size) ReadKernelFile(&KernelFile, (void*)(Address), (uint32)(Position), (uint32)(Size))
+
+  uint8 KernelMagic[Lz4MaxFrameHeaderSize];
+  uint32 KernelMagicSize = (KernelDirectory.Size < sizeof(KernelMagic)) ? KernelDirectory.Size : sizeof(KernelMagic);
+
+  if (ReadKernelRange(KernelMagic, 0, KernelMagicSize) == false) {
     Panic("Failed to read Boot/Serra/Kernel.elf from disk.", 0);
   }
 
-  // Okay - now that we've loaded it, we can start by reading the kernel's
-  // ELF headers. Unlike earlier stages, our kernel is stored as an ELF
-  // executable, *not* as a raw binary, so it requires some processing
-  // before we can actually run it.
+  uint32 KernelMagicNumber = 0;
+
+  if (KernelMagicSize >= sizeof(KernelMagicNumber)) {
+    Memcpy(&KernelMagicNumber, KernelMagic, sizeof(KernelMagicNumber));
+  }
+
+  if (KernelMagicNumber == ZstdFrameMagic) {
+
+    Panic("Kernel is zstd-compressed, which isn't supported (use LZ4).", 0);
+
+  } else if (KernelMagicNumber == Lz4FrameMagic) {
+
+    // (Read the frame header; we need the frame to include the size of
+    // the decompressed image, so we can check everything we read against
+    // it, and its blocks need to be independent of each other)
+
+    lz4FrameInfo KernelFrame;
+
+    if ((Lz4ReadFrameHeader(KernelMagic, KernelMagicSize, &KernelFrame) == false) || (KernelFrame.ContentSize == 0) || (KernelFrame.HasLinkedBlocks == true)) {
+      Panic("Kernel has an invalid LZ4 frame header (or no content size, or linked blocks).", 0);
+    } else if (KernelFrame.ContentSize > 0xFFFFFFFF) {
+      Panic("Decompressed kernel is outside the 32-bit address space.", 0);
+    }
+
+    Message(Info, "Kernel is LZ4-compressed (%d KiB decompressed, in blocks of up to %d KiB).",
+                  (uint32)(KernelFrame.ContentSize / 1024), (KernelFrame.BlockMaxSize / 1024));
+
+    // (Allocate a buffer for each compressed block, and another one for
+    // any decompressed block that can't go straight to where it's needed;
+    // every other block is decompressed straight into the kernel area)
+
+    uint32 DecompressedBlockSize = KernelFrame.BlockMaxSize;
+    uintptr DecompressedBlock = (uintptr)(AllocateFromMmap(Offset, PageAlign(DecompressedBlockSize), false, UsableMmap, NumUsableMmapEntries));
+
+    if (DecompressedBlock == 0) {
+      Panic("Unable to allocate enough space for the decompressed kernel's blocks.", 0);
+    } else {
+      Offset = DecompressedBlock;
+      DecompressedBlock -= PageAlign(DecompressedBlockSize);
+    }
+
+    uint32 CompressedBlockSize = (KernelFrame.BlockMaxSize + 8);
+    uintptr CompressedBlock = (uintptr)(AllocateFromMmap(Offset, PageAlign(CompressedBlockSize), false, UsableMmap, NumUsableMmapEntries));
+
+    if (CompressedBlock == 0) {
+      Panic("Unable to allocate enough space for the compressed kernel's blocks.", 0);
+    } else {
+      Offset = CompressedBlock;
+      CompressedBlock -= PageAlign(CompressedBlockSize);
+    }
+
+    // (From now on, ReadKernelRange() will decompress everything we read)
+
+    if (Lz4OpenStream(&KernelStream, &KernelFrame, ReadCompressedKernel, &KernelFile, (void*)CompressedBlock, (void*)DecompressedBlock) == false) {
+      Panic("Failed to read the first block of Boot/Serra/Kernel.elf.", 0);
+    }
+
+    KernelFile.Stream = &KernelStream;
+
+  }
+
+  uint32 KernelSize = (KernelFile.Stream != NULL) ? (uint32)KernelStream.Info.ContentSize : KernelDirectory.Size;
+
+  // Now, let's read the kernel's ELF header. We already obtained the
+  // directory earlier (KernelDirectory), so all we need to do is to read
+  // the first few bytes of the file.
 
   // (For context: the ELF headers tell us a lot of useful information,
   // such as where to load the kernel, and are always located at the
   // very beginning of the file.)
 
-  elfHeader* KernelHeader = (elfHeader*)KernelImage;
+  elfHeader KernelElfHeader;
+  elfHeader* KernelHeader = &KernelElfHeader;
+
+  if (ReadKernelRange(KernelHeader, 0, sizeof(elfHeader)) == true) {
+    Message(Ok, "Successfully read the ELF header of Boot/Serra/Kernel.elf.");
+  } else {
+    Panic("Failed to read Boot/Serra/Kernel.elf from disk.", 0);
+  }
+
+  // Okay - now that we've loaded it, we can start by checking the kernel's
+  // ELF header. Unlike earlier stages, our kernel is stored as an ELF
+  // executable, *not* as a raw binary, so it requires some processing
+  // before we can actually run it.
 
   if (KernelHeader->Ident.MagicNumber != 0x464C457F) {
     Panic("Kernel does not appear to be an actual ELF file.", 0);
@@ -1262,6 +1343,8 @@ void S3Bootloader(void) {
     Panic("Kernel does not appear to have a proper string table section.", 0);
   } else if ((KernelHeader->ProgramHeaderOffset == 0) || (KernelHeader->NumProgramHeaders == 0)) {
     Panic("Kernel does not appear to have any ELF program headers.", 0);
+  } else if ((KernelHeader->ProgramHeaderSize < sizeof(elfProgramHeader)) || (KernelHeader->SectionHeaderSize < sizeof(elfSectionHeader))) {
+    Panic("Kernel does not appear to have valid ELF header sizes.", 0);
   } else if (KernelHeader->Version < 1) {
     Message(Warning, "ELF header version appears to be invalid (%d)", (uint32)KernelHeader->Version);
   } else if (KernelHeader->FileType != EtDyn) {
@@ -1270,6 +1353,45 @@ void S3Bootloader(void) {
     Message(Ok, "Kernel appears to be a valid ELF executable.");
   }
 
+  // Next, we also need the program and section headers. Since the kernel
+  // needs to be able to access the ELF header later on, we'll allocate a
+  // small area for all of them (the ELF header, followed by the program
+  // header table, followed by the section header table).
+
+  // (The section headers are usually at the very end of the file, and
+  // we don't need them until we get to relocations, so we only read them
+  // after the kernel area; this way, a compressed kernel can be read in
+  // one go, from start to finish)
+
+  uint32 ProgramHeaderTableSize = ((uint32)KernelHeader->NumProgramHeaders * KernelHeader->ProgramHeaderSize);
+  uint32 SectionHeaderTableSize = ((uint32)KernelHeader->NumSectionHeaders * KernelHeader->SectionHeaderSize);
+  uint32 KernelHeaderAreaSize = (uint32)PageAlign(sizeof(elfHeader) + ProgramHeaderTableSize + SectionHeaderTableSize);
+
+  uintptr KernelHeaderArea = (uintptr)(AllocateFromMmap(Offset, KernelHeaderAreaSize, false, UsableMmap, NumUsableMmapEntries));
+
+  if (KernelHeaderArea == 0) {
+
+    Panic("Unable to allocate enough space for the kernel's ELF headers.", 0);
+
+  } else {
+
+    Offset = KernelHeaderArea;
+    KernelHeaderArea -= KernelHeaderAreaSize;
+
+  }
+
+  Memcpy((void*)KernelHeaderArea, (const void*)KernelHeader, sizeof(elfHeader));
+  KernelHeader = (elfHeader*)KernelHeaderArea;
+
+  uintptr ProgramHeaderTable = (KernelHeaderArea + sizeof(elfHeader));
+  uintptr SectionHeaderTable = (ProgramHeaderTable + ProgramHeaderTableSize);
+
+  if (ReadKernelRange(ProgramHeaderTable, KernelHeader->ProgramHeaderOffset, ProgramHeaderTableSize) == false) {
+    Panic("Failed to read the kernel's program headers from disk.", 0);
+  } else {
+    Message(Ok, "Successfully read the kernel's ELF and program headers to %xh.", (uint32)KernelHeaderArea);
+  }
+
   // (Define a few variables / set up info table)
 
   CommonInfoTable.Image.Type = ImageType_Elf;
@@ -1280,7 +1402,7 @@ void S3Bootloader(void) {
   Message(Info, "KernelHeader() | File type %xh | Machine type %xh | Header version %d",
          (uint32)KernelHeader->FileType, (uint32)KernelHeader->MachineType, KernelHeader->Version);
 
-  Message(Info, "Physical address (start of file) at %xh", (uint32)KernelImage);
+  Message(Info, "ELF headers are located at %xh", (uint32)KernelHeaderArea);
   Message(Info, "Virtual address (entrypoint) at %x:%xh", (uint32)((KernelHeader->Entrypoint) >> 32), (uint32)(KernelHeader->Entrypoint));
 
   Message(Info, "Found %d program header(s) at +%xh.", (uint32)KernelHeader->NumProgramHeaders, (uint32)KernelHeader->ProgramHeaderOffset);
@@ -1291,13 +1413,14 @@ void S3Bootloader(void) {
 
   // We do this because the kernel file isn't laid out in the same way it
   // would be in memory, so we can't safely execute off of it without any
-  // modifications - so, we need to allocate *another* area for the kernel.
+  // modifications - so, we need to allocate an area for the kernel.
 
   // In order to do that, we need to figure out how much space we need to
   // allocate, which we can only get from reading the program headers.
 
   uintptr EarliestVirtualAddress = 0xFFFFFFFF;
   uintptr LatestVirtualAddress = 0;
+  uint32 LatestOffset = 0;
 
   bool FoundLoadable = false;
 
@@ -1306,7 +1429,7 @@ void S3Bootloader(void) {
     // (Get program header, and make sure that it's loadable (.Type == 1)
     // or dynamic (.Type == 2))
 
-    const elfProgramHeader* Program = GetProgramHeader(KernelImage, KernelHeader, Index);
+    const elfProgramHeader* Program = GetProgramHeader(ProgramHeaderTable, KernelHeader, Index);
 
     if ((Program->Type != 1) && (Program->Type != 2)) {
       continue;
@@ -1339,6 +1462,26 @@ void S3Bootloader(void) {
       Panic("Program header is not page-aligned.", 0);
     }
 
+    // (Since we'll be reading loadable sections straight from disk, we
+    // also want to make sure they don't go past the end of the file)
+
+    if ((Program->Type == 1) && ((Program->Offset > KernelSize) || (Program->Size > (KernelSize - Program->Offset)))) {
+      Panic("Program header extends past the end of the kernel file.", 0);
+    }
+
+    // (If the kernel is compressed, then we can only read it forwards, so
+    // loadable sections also need to be in file order)
+
+    if ((Program->Type == 1) && (KernelFile.Stream != NULL)) {
+
+      if (Program->Offset < LatestOffset) {
+        Panic("Program header comes before the previous one in the (compressed) kernel file.", 0);
+      }
+
+      LatestOffset = (uint32)(Program->Offset + Program->Size);
+
+    }
+
     // (Update EarliestVirtualAddress and LatestVirtualAddress)
 
     if (Start < EarliestVirtualAddress) {
@@ -1379,7 +1522,7 @@ void S3Bootloader(void) {
 
   // [Setup the kernel area]
 
-  // Now that we've allocated enough space, let's copy everything over from
+  // Now that we know how much space we need, let's read everything from
   // the kernel file. This requires *everything* to be page-aligned, but we
   // already made sure of that earlier, thankfully.
 
@@ -1411,8 +1554,8 @@ void S3Bootloader(void) {
   }
 
   // The next thing we need to do then is to go through the (loadable)
-  // program headers again, and manually copy everything. We use SSE
-  // functions here to speed things up.
+  // program headers again, and read each one from disk, straight to its
+  // final location (so we don't need a second copy of the kernel).
 
   // (Additionally, we also need to 'pad' the difference between PaddedSize
   // (p_memsz) and Size (p_filesz) with zeroes)
@@ -1421,14 +1564,14 @@ void S3Bootloader(void) {
 
     // (Get program header, and make sure that it's loadable (.Type == 1))
 
-    elfProgramHeader* Program = GetProgramHeader(KernelImage, KernelHeader, Index);
+    elfProgramHeader* Program = GetProgramHeader(ProgramHeaderTable, KernelHeader, Index);
 
     if (Program->Type != 1) {
       continue;
     }
 
-    // (Copy Size (p_filesz) bytes from our file (in *Kernel) to our newly
-    // allocated area (in *KernelArea))
+    // (Read Size (p_filesz) bytes from our file (starting at Offset) to
+    // our newly allocated area (in *KernelArea))
 
     uint32 ProgramAddress = (uint32)Program->VirtAddress;
     uint32 ProgramOffset = (uint32)Program->Offset;
@@ -1436,8 +1579,11 @@ void S3Bootloader(void) {
 
     if (ProgramSize > 0) {
 
-      SseMemcpy((void*)(KernelArea + ProgramAddress), (const void*)(KernelImage + ProgramOffset), ProgramSize);
-      Message(Info, "Copied %xh bytes from %xh to %xh", ProgramSize, (KernelImage + ProgramOffset), (KernelArea + ProgramAddress));
+      if (ReadKernelRange(KernelArea + ProgramAddress, ProgramOffset, ProgramSize) == false) {
+        Panic("Failed to read a loadable section of Boot/Serra/Kernel.elf from disk.", 0);
+      }
+
+      Message(Info, "Read %xh bytes from +%xh to %xh", ProgramSize, ProgramOffset, (KernelArea + ProgramAddress));
 
     }
 
@@ -1489,20 +1635,30 @@ void S3Bootloader(void) {
   Putchar('\n', 0);
   Message(Boot, "Preparing to process ELF relocations.");
 
+  // (Read the section headers from disk, since we didn't need them
+  // until now)
+
+  if (ReadKernelRange(SectionHeaderTable, KernelHeader->SectionHeaderOffset, SectionHeaderTableSize) == false) {
+    Panic("Failed to read the kernel's section headers from disk.", 0);
+  } else {
+    Message(Ok, "Successfully read the kernel's section headers to %xh.", (uint32)SectionHeaderTable);
+  }
+
   // (Iterate through each section within the executable to try to find
-  // the dynamic relocation (`.rela.dyn`) section)
+  // the dynamic relocation (`.rela.dyn`) and packed relocation (`.relr.dyn`)
+  // sections)
 
   elfSectionHeader* DynamicRelocationSection = NULL;
+  elfSectionHeader* PackedRelocationSection = NULL;
 
   for (auto Index = 0; Index < KernelHeader->NumSectionHeaders; Index++) {
 
-    elfSectionHeader* Section = GetSectionHeader(KernelImage, KernelHeader, Index);
-
-    if (Section->Type == 4) {
+    elfSectionHeader* Section = GetSectionHeader(SectionHeaderTable, KernelHeader, Index);
 
+    if ((Section->Type == 4) && (DynamicRelocationSection == NULL)) {
       DynamicRelocationSection = Section;
-      break;
-
+    } else if ((Section->Type == 19) && (PackedRelocationSection == NULL)) {
+      PackedRelocationSection = Section;
     }
 
   }
@@ -1519,11 +1675,39 @@ void S3Bootloader(void) {
     // (Calculate the number of relocations in the section)
 
     auto NumRelocations = ((uint32)DynamicRelocationSection->Size / sizeof(elfRelocationWithAddend));
-    elfRelocationWithAddend* RelocationList = (elfRelocationWithAddend*)(KernelImage + (uintptr)DynamicRelocationSection->Offset);
+    elfRelocationWithAddend* RelocationList;
 
     Message(Ok, "Found `.rela.dyn` section at %xh.", (uintptr)DynamicRelocationSection);
     Message(Info, "Section appears to contain %d relocation(s).", (uint32)NumRelocations);
 
+    // (We don't have a copy of the whole file anymore, but the section is
+    // usually part of a loadable segment (SHF_ALLOC), in which case it's
+    // already in the kernel area; otherwise, read it from disk.)
+
+    if ((DynamicRelocationSection->Flags & 2) != 0) {
+
+      RelocationList = (elfRelocationWithAddend*)(KernelArea + (uintptr)DynamicRelocationSection->Address);
+
+    } else {
+
+      uint32 RelocationListSize = (uint32)PageAlign(NumRelocations * sizeof(elfRelocationWithAddend));
+      uintptr RelocationArea = (uintptr)(AllocateFromMmap(Offset, RelocationListSize, false, UsableMmap, NumUsableMmapEntries));
+
+      if (RelocationArea == 0) {
+        Panic("Unable to allocate enough space for the kernel's relocations.", 0);
+      }
+
+      Offset = RelocationArea;
+      RelocationArea -= RelocationListSize;
+
+      if (ReadKernelRange(RelocationArea, DynamicRelocationSection->Offset, (NumRelocations * sizeof(elfRelocationWithAddend))) == false) {
+        Panic("Failed to read the kernel's relocations from disk.", 0);
+      }
+
+      RelocationList = (elfRelocationWithAddend*)RelocationArea;
+
+    }
+
     // (Handle each relocation)
 
     for (uint64 Index = 0; Index < NumRelocations; Index++) {
@@ -1569,6 +1753,35 @@ void S3Bootloader(void) {
 
   }
 
+  // If the kernel was linked with `-z pack-relative-relocs`, then most (if
+  // not all) of its relative relocations will be in `.relr.dyn` instead,
+  // which is much smaller, and can be applied in one pass.
+
+  // (This section is always part of a loadable segment, so we don't need
+  // to read anything else from disk - it's already in the kernel area.)
+
+  if (PackedRelocationSection != NULL) {
+
+    uint32 NumPackedEntries = ((uint32)PackedRelocationSection->Size / sizeof(elfPackedRelocation));
+    uint64 NumPackedRelocations = 0;
+
+    Message(Ok, "Found `.relr.dyn` section at %xh.", (uintptr)PackedRelocationSection);
+    Message(Info, "Section appears to contain %d packed relocation entries.", NumPackedEntries);
+
+    if (((PackedRelocationSection->Flags & 2) == 0) || (PackedRelocationSection->Address > KernelAreaSize) || (PackedRelocationSection->Size > (KernelAreaSize - PackedRelocationSection->Address))) {
+      Panic("Kernel's `.relr.dyn` section isn't part of a loadable segment.", 0);
+    }
+
+    const elfPackedRelocation* PackedRelocationList = (const elfPackedRelocation*)(KernelArea + (uintptr)PackedRelocationSection->Address);
+
+    if (ApplyPackedRelocations(KernelArea, KernelAreaSize, PackedRelocationList, NumPackedEntries, &NumPackedRelocations) == false) {
+      Panic("Kernel's `.relr.dyn` section refers to an address outside of the kernel area.", 0);
+    }
+
+    Message(Ok, "Successfully processed %d packed relative relocation(s).", (uint32)NumPackedRelocations);
+
+  }
+
 
 
 
@@ -18,6 +18,26 @@
 
   #include "../Shared/InfoTable.h"
   #include "../../../Common/Common.h"
+  #include "../../../Common/Compression/Lz4.h"
+  #include "../../../Common/Elf/Relocations.h"
+  #include "../../../Common/Memory/Mmap.h"
+
+  // Kernel file-related structures, used by ReadKernelFile() and
+  // ReadCompressedKernel() in Bootloader.c
+
+  typedef struct _kernelFileInfo {
+
+    fatDirectory Directory; // (The directory entry of Boot/Serra/Kernel.elf)
+
+    uint8 SectorsPerCluster;
+    uint32 PartitionOffset;
+    uint32 FatOffset;
+    uint32 DataOffset;
+    bool IsFat32;
+
+    lz4Stream* Stream; // (If the kernel is compressed, then this is what we decompress it with; otherwise, NULL)
+
+  } kernelFileInfo;
 
   // Declare functions in Bootloader.c and Stub.asm
 
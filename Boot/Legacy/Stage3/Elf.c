@@ -7,7 +7,7 @@
 
 /* elfProgramHeader* GetProgramHeader()
 
-   Inputs: uintptr Start - The start of the file in memory;
+   Inputs: uintptr Table - The start of the program header table in memory;
            const elfHeader* ElfHeader - A pointer to the file's ELF header;
            uint16 Index - The index of the program header you want to get.
 
@@ -25,9 +25,12 @@
    It's assumed that ElfHeader redirects to a valid ELF header, and that
    Index is a valid index number (otherwise, this function will return 0).
 
+   (The table doesn't need to be part of a copy of the whole file; it can
+   just be read from disk on its own, which is what Stage 3 does.)
+
 */
 
-elfProgramHeader* GetProgramHeader(uintptr Start, const elfHeader* ElfHeader, uint16 Index) {
+elfProgramHeader* GetProgramHeader(uintptr Table, const elfHeader* ElfHeader, uint16 Index) {
 
   // First, does the index even make sense?
 
@@ -37,7 +40,7 @@ elfProgramHeader* GetProgramHeader(uintptr Start, const elfHeader* ElfHeader, ui
 
   // Find the address of the program header, and return it as a pointer.
 
-  uintptr Address = (uintptr)(Start + ElfHeader->ProgramHeaderOffset + (Index * ElfHeader->ProgramHeaderSize));
+  uintptr Address = (uintptr)(Table + (Index * ElfHeader->ProgramHeaderSize));
   return (elfProgramHeader*)(Address);
 
 }
@@ -45,7 +48,7 @@ elfProgramHeader* GetProgramHeader(uintptr Start, const elfHeader* ElfHeader, ui
 
 /* elfSectionHeader* GetSectionHeader()
 
-   Inputs: uintptr Start - The start of the file in memory;
+   Inputs: uintptr Table - The start of the section header table in memory;
            const elfHeader* ElfHeader - A pointer to the file's ELF header;
            uint16 Index - The index of the section header you want to get.
 
@@ -63,9 +66,12 @@ elfProgramHeader* GetProgramHeader(uintptr Start, const elfHeader* ElfHeader, ui
    It's assumed that ElfHeader redirects to a valid ELF header, and that
    Index is a valid index number (otherwise, this function will return 0).
 
+   (The table doesn't need to be part of a copy of the whole file; it can
+   just be read from disk on its own, which is what Stage 3 does.)
+
 */
 
-elfSectionHeader* GetSectionHeader(uintptr Start, const elfHeader* ElfHeader, uint16 Index) {
+elfSectionHeader* GetSectionHeader(uintptr Table, const elfHeader* ElfHeader, uint16 Index) {
 
   // First, does the index even make sense?
 
@@ -75,7 +81,7 @@ elfSectionHeader* GetSectionHeader(uintptr Start, const elfHeader* ElfHeader, ui
 
   // Find the address of the section header, and return it as a pointer.
 
-  uintptr Address = (uintptr)(Start + ElfHeader->SectionHeaderOffset + (Index * ElfHeader->SectionHeaderSize));
+  uintptr Address = (uintptr)(Table + (Index * ElfHeader->SectionHeaderSize));
   return (elfSectionHeader*)(Address);
 
 }
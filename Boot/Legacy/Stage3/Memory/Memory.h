@@ -80,6 +80,25 @@
   #define makePageEntry(Addr, Flags) ((uint64)pageAddress(Addr) | (uint64)Flags)
   #define ceilingDivide(Num, Divisor) ((Num + Divisor - 1) / Divisor)
 
+  #define hugePageAddress(Addr) ((uint64)Addr & 0x000FFFFFC0000000ULL) // (The address of a 1 GiB page, without PAT)
+  #define PageTableBatchSize 16 // (How many page tables are allocated (and cleared) at once)
+
+  typedef struct _pagingData {
+
+    bool Supports1GiBPages; // (Whether CPUID reports PDPE1GB support)
+
+    uintptr PoolStart; // (The next page table we can hand out)
+    uintptr PoolEnd; // (The end of the current batch of page tables)
+
+    uint32 NumTables; // (How many page tables have been created so far)
+    uint32 NumSplitPages; // (How many 1 GiB pages had to be split into 2 MiB ones)
+
+    uint64 NumPages[3]; // (How many 4 KiB, 2 MiB and 1 GiB pages have been mapped so far)
+
+  } pagingData;
+
+  extern pagingData PagingData;
+
   uint64 PageAlign(uint64 Address);
   uint64 AllocateFromMmap(uint64 Start, uint32 Size, bool Clear, usableMmapEntry* UsableMmap, uint8 NumUsableMmapEntries);
   uint64 InitializePageEntries(uint64 PhysAddress, uint64 VirtAddress, uint64 Size, uint64* Pml4, uint64 Flags, bool UseLargePages, bool UsePat, uint64 MmapOffset, usableMmapEntry* UsableMmap, uint16 NumUsableMmapEntries);
@@ -6,6 +6,12 @@
 #include "../../Graphics/Graphics.h"
 #include "../Memory.h"
 
+// (Keeps track of whether 1 GiB pages are supported, of the batch of
+// page tables we're currently handing out, and of how many tables and
+// pages InitializePageEntries() has created so far)
+
+pagingData PagingData = {0};
+
 /* uint64 PageAlign()
 
    Inputs: uint64 Address - The address you want to page-align.
@@ -150,6 +156,61 @@ uint64 AllocateFromMmap(uint64 Start, uint32 Size, bool Clear, usableMmapEntry*
 
 
 
+/* static uintptr AllocatePageTable()
+
+   Inputs: uint64* MmapOffset - A pointer to the memory map offset that
+           InitializePageEntries() is using (this is updated whenever a
+           new batch of page tables is allocated);
+
+           usableMmapEntry* UsableMmap - The usable memory map;
+
+           uint16 NumUsableMmapEntries - The number of entries in UsableMmap.
+
+   Outputs: uintptr - The address of a new (zeroed out) page table.
+
+   Allocating (and clearing) each page table separately means going
+   through AllocateFromMmap() - and scanning the memory map - every single
+   time, so instead, this function allocates PageTableBatchSize tables at
+   once, clears them all in one go, and hands them out one at a time.
+
+   Any tables that are left over from one call to InitializePageEntries()
+   are used by the next one; since the returned offset always comes after
+   the whole batch, nothing else can be allocated on top of them.
+
+*/
+
+static uintptr AllocatePageTable(uint64* MmapOffset, usableMmapEntry* UsableMmap, uint16 NumUsableMmapEntries) {
+
+  // (If we've run out of tables, allocate a new batch)
+
+  if (PagingData.PoolStart >= PagingData.PoolEnd) {
+
+    uint64 BatchEnd = AllocateFromMmap(*MmapOffset, (PageTableBatchSize * 4096), true, UsableMmap, NumUsableMmapEntries);
+
+    if (BatchEnd == 0) {
+      Panic("Unable to allocate enough memory for the page tables.", 0);
+    }
+
+    *MmapOffset = BatchEnd;
+
+    PagingData.PoolStart = (uintptr)(BatchEnd - (PageTableBatchSize * 4096));
+    PagingData.PoolEnd = (uintptr)BatchEnd;
+
+  }
+
+  // (Hand out the next table from the batch)
+
+  uintptr Table = PagingData.PoolStart;
+
+  PagingData.PoolStart += 4096;
+  PagingData.NumTables++;
+
+  return Table;
+
+}
+
+
+
 /* uint64 InitializePageEntries()
 
    Inputs: uint64 PhysAddress - The physical address you want to map *from*;
@@ -165,7 +226,8 @@ uint64 AllocateFromMmap(uint64 Start, uint32 Size, bool Clear, usableMmapEntry*
            uint64 Flags - The flags you want to use on your pages;
 
            bool UseLargePages - Whether you want to use large (2 MiB) pages
-           or not (4 KiB);
+           or not (4 KiB); if 1 GiB pages are supported, they're also used
+           wherever a whole (aligned) 1 GiB area is being mapped;
 
            bool UsePat - Whether you want to enable the PAT bit;
 
@@ -185,8 +247,11 @@ uint64 AllocateFromMmap(uint64 Start, uint32 Size, bool Clear, usableMmapEntry*
    The purpose of this function is to map a memory block (located within the
    physical address space) to another location in the virtual address space,
    using the long mode paging model. It dynamically allocates memory as
-   needed (from UsableMmap, not the page being mapped), and can deal
-   with overlapping regions.
+   needed (from UsableMmap, not the page being mapped, and in batches; see
+   AllocatePageTable()), and can deal with overlapping regions.
+
+   (If part of an existing 1 GiB page needs to be remapped, it's split up
+   into 2 MiB pages first, so the rest of it stays mapped the same way)
 
    Keep in mind that, due to the way this function works, it's implicitly
    assumed that *Pml4 only contains valid data, so always make sure to clear
@@ -233,10 +298,7 @@ uint64 InitializePageEntries(uint64 PhysAddress, uint64 VirtAddress, uint64 Size
     uintptr Pml3_Address = (uintptr)(pageAddress(Pml4[Pml4_Index]));
 
     if (Pml3_Address == 0) {
-
-      MmapOffset = AllocateFromMmap(MmapOffset, 4096, true, UsableMmap, NumUsableMmapEntries);
-      Pml3_Address = (MmapOffset - 4096);
-
+      Pml3_Address = AllocatePageTable(&MmapOffset, UsableMmap, NumUsableMmapEntries);
     }
 
     Pml4[Pml4_Index] = makePageEntry(Pml3_Address, Flags);
@@ -250,15 +312,55 @@ uint64 InitializePageEntries(uint64 PhysAddress, uint64 VirtAddress, uint64 Size
 
     for (uint16 Pml3_Index = Pml3_Start; Pml3_Index <= Pml3_End; Pml3_Index++) {
 
+      // Figure out which PML2 entries we'd need to fill out.
+
+      uint16 Pml2_Start = ((Pml4_Index == InitialPmls[0] && Pml3_Index == InitialPmls[1]) ? InitialPmls[2] : 0);
+      uint16 Pml2_End = ((Pml4_Index == FinalPmls[0] && Pml3_Index == FinalPmls[1]) ? FinalPmls[2] : 511);
+
+      // If we're using large pages, and we'd be filling out every single
+      // one of them anyway, then we can map this whole area with a 1 GiB
+      // page instead (as long as the physical address is aligned, and as
+      // long as there isn't already a page table here).
+
+      bool IsHugePage = ((Pml3[Pml3_Index] & pageSize) != 0);
+
+      if ((UseLargePages == true) && (PagingData.Supports1GiBPages == true)
+          && (Pml2_Start == 0) && (Pml2_End == 511) && ((PhysAddress % 0x40000000) == 0)
+          && ((Pml3[Pml3_Index] == 0) || (IsHugePage == true))) {
+
+        Pml3[Pml3_Index] = makePageEntry(PhysAddress, (Flags | pageSize | ((UsePat == true) ? pdePat : 0)));
+        PhysAddress += 0x40000000;
+
+        PagingData.NumPages[2]++;
+        continue;
+
+      }
+
       // Is this filled out already? (PML3 -> array of 512 PML2s)
       // If not, allocate a page for those PML2s.
 
       uintptr Pml2_Address = (uintptr)(pageAddress(Pml3[Pml3_Index]));
 
-      if (Pml2_Address == 0) {
+      if (IsHugePage == true) {
 
-        MmapOffset = AllocateFromMmap(MmapOffset, 4096, true, UsableMmap, NumUsableMmapEntries);
-        Pml2_Address = (MmapOffset - 4096);
+        // (If there's a 1 GiB page here, split it into 512 2 MiB pages
+        // that map the same area, with the same flags)
+
+        uint64 HugePage = Pml3[Pml3_Index];
+        uint64 HugePageFlags = (HugePage & ~hugePageAddress(~0ULL));
+
+        Pml2_Address = AllocatePageTable(&MmapOffset, UsableMmap, NumUsableMmapEntries);
+        uint64* Pml2 = (uint64*)Pml2_Address;
+
+        for (uint16 Pml2_Index = 0; Pml2_Index < 512; Pml2_Index++) {
+          Pml2[Pml2_Index] = (hugePageAddress(HugePage) + ((uint64)Pml2_Index * 0x200000)) | HugePageFlags;
+        }
+
+        PagingData.NumSplitPages++;
+
+      } else if (Pml2_Address == 0) {
+
+        Pml2_Address = AllocatePageTable(&MmapOffset, UsableMmap, NumUsableMmapEntries);
 
       }
 
@@ -266,9 +368,6 @@ uint64 InitializePageEntries(uint64 PhysAddress, uint64 VirtAddress, uint64 Size
 
       // Fill out PML2 entries.
 
-      uint16 Pml2_Start = ((Pml4_Index == InitialPmls[0] && Pml3_Index == InitialPmls[1]) ? InitialPmls[2] : 0);
-      uint16 Pml2_End = ((Pml4_Index == FinalPmls[0] && Pml3_Index == FinalPmls[1]) ? FinalPmls[2] : 511);
-
       uint64* Pml2 = (uint64*)Pml2_Address;
 
       for (uint16 Pml2_Index = Pml2_Start; Pml2_Index <= Pml2_End; Pml2_Index++) {
@@ -280,6 +379,8 @@ uint64 InitializePageEntries(uint64 PhysAddress, uint64 VirtAddress, uint64 Size
           Pml2[Pml2_Index] = makePageEntry(PhysAddress, (Flags | pageSize | ((UsePat == true) ? pdePat : 0)));
           PhysAddress += (4096 * 512);
 
+          PagingData.NumPages[1]++;
+
           continue;
 
         }
@@ -289,10 +390,7 @@ uint64 InitializePageEntries(uint64 PhysAddress, uint64 VirtAddress, uint64 Size
         uintptr Pte_Address = (uintptr)(pageAddress(Pml2[Pml2_Index]));
 
         if (Pte_Address == 0) {
-
-          MmapOffset = AllocateFromMmap(MmapOffset, 4096, true, UsableMmap, NumUsableMmapEntries);
-          Pte_Address = (MmapOffset - 4096);
-
+          Pte_Address = AllocatePageTable(&MmapOffset, UsableMmap, NumUsableMmapEntries);
         }
 
         Pml2[Pml2_Index] = makePageEntry(Pte_Address, Flags);
@@ -309,6 +407,8 @@ uint64 InitializePageEntries(uint64 PhysAddress, uint64 VirtAddress, uint64 Size
           Pte[Pte_Index] = makePageEntry(PhysAddress, (Flags | ((UsePat == true) ? ptePat : 0)));
           PhysAddress += 4096;
 
+          PagingData.NumPages[0]++;
+
         }
 
       }
@@ -0,0 +1,556 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+// (This file is compiled by both the 32-bit (Legacy) and the 64-bit (EFI)
+// bootloaders, so we need to pick the right Stdint.h)
+
+#if defined(__amd64__) || defined(__x86_64__)
+  #include "../../Boot/Efi/Stdint.h"
+#else
+  #include "../../Boot/Legacy/Shared/Stdint.h"
+#endif
+
+#include "Lz4.h"
+
+/* static inline uint32 ReadLe32()
+
+   Inputs: const uint8* Data - The location of the value you want to read.
+
+   Outputs: uint32 - The (little-endian) 32-bit value at that location.
+
+   LZ4 frames don't make any alignment guarantees, so we can't just
+   dereference a uint32* - instead, we read each byte on its own.
+
+*/
+
+static inline uint32 ReadLe32(const uint8* Data) {
+
+  return ((uint32)Data[0] | ((uint32)Data[1] << 8) | ((uint32)Data[2] << 16) | ((uint32)Data[3] << 24));
+
+}
+
+
+/* static inline void CopyVector()
+
+   Inputs: uint8* Destination - The location you want to copy to;
+           const uint8* Source - The location you want to copy from.
+
+   Outputs: (None, except for the 16 bytes copied to Destination)
+
+   This function copies exactly 16 bytes from Source to Destination, using
+   a single (unaligned) SSE2 register; it's what we use to speed up literal
+   and match copies.
+
+   Both bootloaders enable SSE before they get to the point of loading the
+   kernel, so this is always safe to use (*just not from Stage 2*).
+
+*/
+
+static inline void CopyVector(uint8* Destination, const uint8* Source) {
+
+  __asm__ __volatile__ ("movdqu (%1), %%xmm0;"
+                        "movdqu %%xmm0, (%0);"
+                        :: "r"(Destination), "r"(Source)
+                        : "memory", "xmm0");
+
+}
+
+
+/* static void CopyBytes(), WildCopy()
+
+   Inputs: uint8* Destination - The location you want to copy to;
+           const uint8* Source - The location you want to copy from;
+           uint32 Size - The number of bytes you want to copy.
+
+   Outputs: (None, except for the bytes copied to Destination)
+
+   These two functions copy data in 16-byte chunks (using CopyVector()),
+   with one important difference:
+
+   - CopyBytes() copies exactly Size bytes, finishing off any remainder
+   with a regular byte-by-byte copy;
+
+   - WildCopy() rounds Size up to the next multiple of 16, which means it
+   can read *and* write up to 15 bytes past the end of each buffer. This
+   is faster, but it's only safe when the caller knows there's enough
+   space left over.
+
+   (WildCopy() is also safe for overlapping match copies, as long as
+   Destination is at least 16 bytes after Source)
+
+*/
+
+static void CopyBytes(uint8* Destination, const uint8* Source, uint32 Size) {
+
+  while (Size >= 16) {
+
+    CopyVector(Destination, Source);
+
+    Destination += 16;
+    Source += 16;
+    Size -= 16;
+
+  }
+
+  while (Size > 0) {
+
+    *Destination++ = *Source++;
+    Size--;
+
+  }
+
+}
+
+static void WildCopy(uint8* Destination, const uint8* Source, uint32 Size) {
+
+  uint8* End = (Destination + Size);
+
+  do {
+
+    CopyVector(Destination, Source);
+
+    Destination += 16;
+    Source += 16;
+
+  } while (Destination < End);
+
+}
+
+
+/* static bool ReadLength()
+
+   Inputs: const uint8** Input - A pointer to the current input position;
+           const uint8* InputEnd - The end of the input buffer;
+           uint32* Length - The length you want to extend.
+
+   Outputs: bool - Whether the length could be read (true) or whether
+   the input ran out before it finished (false).
+
+   In the LZ4 block format, literal and match lengths of 15 or more are
+   extended by a series of extra bytes - each one is added to the length,
+   and a byte of 255 means that there's at least one more to come.
+
+*/
+
+static bool ReadLength(const uint8** Input, const uint8* InputEnd, uint32* Length) {
+
+  uint8 Extra;
+
+  do {
+
+    if (*Input >= InputEnd) {
+      return false;
+    }
+
+    Extra = *(*Input)++;
+    *Length += Extra;
+
+  } while (Extra == 255);
+
+  return true;
+
+}
+
+
+/* bool Lz4ReadFrameHeader()
+
+   Inputs: const void* Header - The start of the LZ4 frame (in memory);
+           uint32 Size - How many bytes of it are available (ideally, at
+           least Lz4MaxFrameHeaderSize);
+           lz4FrameInfo* Info - Where to save information about the frame.
+
+   Outputs: bool - Whether the frame header is valid (and supported).
+
+   This function parses the header of an LZ4 frame (as generated by the
+   `lz4` command-line tool), and fills out Info accordingly.
+
+   We don't support frames that depend on an external dictionary, and we
+   also don't verify any of the frame's checksums (the header checksum
+   included) - the data we decompress is always validated afterwards.
+
+   (If the frame specifies its content size, then BlockMaxSize is capped
+   to it, since no block can be larger than the frame itself; this keeps
+   the buffers callers allocate for small frames small as well)
+
+*/
+
+bool Lz4ReadFrameHeader(const void* Header, uint32 Size, lz4FrameInfo* Info) {
+
+  const uint8* Data = (const uint8*)Header;
+
+  // (Make sure we at least have the magic number and frame descriptor,
+  // and that they're actually valid)
+
+  if ((Size < 7) || (ReadLe32(Data) != Lz4FrameMagic)) {
+    return false;
+  }
+
+  uint8 Flags = Data[4];
+  uint8 Descriptor = Data[5];
+
+  if (((Flags >> 6) != 1) || ((Flags & 0x02) != 0) || ((Descriptor & 0x8F) != 0)) {
+    return false;
+  } else if ((Flags & 0x01) != 0) {
+    return false;
+  }
+
+  // (The block size ID can range from 4 (64 KiB) to 7 (4 MiB))
+
+  uint8 BlockSizeId = ((Descriptor >> 4) & 0x07);
+
+  if (BlockSizeId < 4) {
+    return false;
+  }
+
+  Info->BlockMaxSize = (1UL << (8 + (2 * BlockSizeId)));
+  Info->HasBlockChecksums = ((Flags & 0x10) != 0);
+  Info->HasContentChecksum = ((Flags & 0x04) != 0);
+  Info->HasLinkedBlocks = ((Flags & 0x20) == 0);
+
+  // (If the frame specifies its content size, then read it; otherwise,
+  // leave it as zero)
+
+  Info->ContentSize = 0;
+  Info->HeaderSize = 7;
+
+  if ((Flags & 0x08) != 0) {
+
+    Info->HeaderSize += 8;
+
+    if (Size < Info->HeaderSize) {
+      return false;
+    }
+
+    Info->ContentSize = ((uint64)ReadLe32(&Data[6]) | ((uint64)ReadLe32(&Data[10]) << 32));
+
+    if ((Info->ContentSize != 0) && (Info->ContentSize < Info->BlockMaxSize)) {
+      Info->BlockMaxSize = (uint32)Info->ContentSize;
+    }
+
+  }
+
+  return true;
+
+}
+
+
+/* bool Lz4DecompressBlock()
+
+   Inputs: const void* Source - The start of the compressed block;
+           uint32 SourceSize - The size of the compressed block, in bytes;
+           void* Destination - Where to decompress the block to;
+           uint32* DestinationSize - (In) how many bytes can be written to
+           Destination, and (out) how many bytes were actually written;
+           const void* Window - The earliest location that matches are
+           allowed to refer to (or NULL, for Destination itself).
+
+   Outputs: bool - Whether the block was successfully decompressed.
+
+   This function decompresses a single LZ4 block, which is made up of a
+   series of 'sequences' - each one is a run of literal bytes, followed by
+   a match (a copy of earlier output, up to 65535 bytes back).
+
+   Since blocks are allowed to refer back to previous blocks (as long as
+   they're in the same frame), Window should generally point to the start
+   of the decompressed data as a whole, not just to Destination.
+
+   Most of the time is spent copying literals and matches, so we copy
+   both in 16-byte chunks whenever there's enough space left over (see
+   WildCopy()), and only fall back to copying byte-by-byte near the end
+   of the buffer, or for short overlapping matches.
+
+*/
+
+bool Lz4DecompressBlock(const void* Source, uint32 SourceSize, void* Destination, uint32* DestinationSize, const void* Window) {
+
+  const uint8* Input = (const uint8*)Source;
+  const uint8* InputEnd = (Input + SourceSize);
+
+  uint8* Output = (uint8*)Destination;
+  uint8* OutputEnd = (Output + *DestinationSize);
+
+  const uint8* WindowStart = (Window != NULL) ? (const uint8*)Window : Output;
+
+  while (Input < InputEnd) {
+
+    // (Read the token; the upper 4 bits are the literal length, and the
+    // lower 4 bits are the match length (minus 4))
+
+    uint8 Token = *Input++;
+    uint32 LiteralSize = (Token >> 4);
+
+    if ((LiteralSize == 15) && (ReadLength(&Input, InputEnd, &LiteralSize) == false)) {
+      return false;
+    }
+
+    // (Copy the literals, making sure we don't go past the end of either
+    // buffer)
+
+    uint32 InputLeft = (uint32)(InputEnd - Input);
+    uint32 OutputLeft = (uint32)(OutputEnd - Output);
+
+    if ((LiteralSize > InputLeft) || (LiteralSize > OutputLeft)) {
+      return false;
+    }
+
+    if (((InputLeft - LiteralSize) >= 16) && ((OutputLeft - LiteralSize) >= 16)) {
+      WildCopy(Output, Input, LiteralSize);
+    } else {
+      CopyBytes(Output, Input, LiteralSize);
+    }
+
+    Input += LiteralSize;
+    Output += LiteralSize;
+
+    // (The last sequence of each block only has literals, so if we've
+    // reached the end of our input, we're done)
+
+    if (Input >= InputEnd) {
+      break;
+    }
+
+    // (Read the match offset, and make sure it doesn't point to anything
+    // before the start of our window)
+
+    if ((InputEnd - Input) < 2) {
+      return false;
+    }
+
+    uint32 MatchOffset = ((uint32)Input[0] | ((uint32)Input[1] << 8));
+    Input += 2;
+
+    if ((MatchOffset == 0) || (MatchOffset > (uintptr)(Output - WindowStart))) {
+      return false;
+    }
+
+    // (Read the match length, and copy the match itself)
+
+    uint32 MatchSize = (Token & 0x0F);
+
+    if ((MatchSize == 15) && (ReadLength(&Input, InputEnd, &MatchSize) == false)) {
+      return false;
+    }
+
+    MatchSize += 4;
+    OutputLeft = (uint32)(OutputEnd - Output);
+
+    if (MatchSize > OutputLeft) {
+      return false;
+    }
+
+    const uint8* Match = (Output - MatchOffset);
+
+    if ((MatchOffset >= 16) && ((OutputLeft - MatchSize) >= 16)) {
+
+      WildCopy(Output, Match, MatchSize);
+
+    } else {
+
+      for (uint32 Index = 0; Index < MatchSize; Index++) {
+        Output[Index] = Match[Index];
+      }
+
+    }
+
+    Output += MatchSize;
+
+  }
+
+  *DestinationSize = (uint32)(Output - (uint8*)Destination);
+  return true;
+
+}
+
+
+/* bool Lz4OpenStream()
+
+   Inputs: lz4Stream* Stream - Where to keep track of the frame's state;
+           const lz4FrameInfo* Info - The frame information, as returned by
+           Lz4ReadFrameHeader() (ContentSize must be non-zero);
+           lz4ReadFunction Read - The function used to read the file;
+           void* Context - A value that's passed through to Read;
+           void* Buffer - A temporary buffer for compressed blocks, which
+           must be at least (Info->BlockMaxSize + 8) bytes long;
+           void* Block - A temporary buffer for decompressed blocks, which
+           must be at least Info->BlockMaxSize bytes long.
+
+   Outputs: bool - Whether the frame can be decompressed with
+   Lz4ReadStream() (and if so, Stream is ready to use).
+
+   This function sets up Stream, and reads the size of the frame's first
+   block, so that Lz4ReadStream() can start decompressing it.
+
+   Since Lz4ReadStream() decompresses each block wherever it needs to go,
+   blocks can't refer back to each other - so frames have to be created
+   with independent blocks (which is what the `lz4` tool does by default,
+   unless it's given `-BD`).
+
+*/
+
+bool Lz4OpenStream(lz4Stream* Stream, const lz4FrameInfo* Info, lz4ReadFunction Read, void* Context, void* Buffer, void* Block) {
+
+  if ((Info->ContentSize == 0) || (Info->HasLinkedBlocks == true)) {
+    return false;
+  }
+
+  Stream->Info = *Info;
+
+  Stream->Read = Read;
+  Stream->Context = Context;
+
+  Stream->Buffer = (uint8*)Buffer;
+  Stream->Block = (uint8*)Block;
+
+  Stream->Position = Info->HeaderSize;
+  Stream->Produced = 0;
+
+  Stream->BlockStart = 0;
+  Stream->BlockLength = 0;
+
+  // (Read the size of the first block)
+
+  if (Read(Context, Stream->Position, Stream->Buffer, 4) == false) {
+    return false;
+  }
+
+  Stream->Position += 4;
+  Stream->NextBlockSize = ReadLe32(Stream->Buffer);
+
+  return true;
+
+}
+
+
+/* bool Lz4ReadStream()
+
+   Inputs: lz4Stream* Stream - The stream, as set up by Lz4OpenStream();
+           uint64 Position - The offset within the *decompressed* data to
+           start reading from;
+           void* Destination - Where to decompress the data to;
+           uint64 Size - The number of bytes we want to read.
+
+   Outputs: bool - Whether we were able to read Size bytes from the frame.
+
+   This function decompresses a specific byte range of the frame into
+   Destination, reading (and decompressing) each block only as it needs
+   it, so the frame never has to be decompressed into memory as a whole.
+
+   Whenever a block starts exactly where we're reading from, and all of it
+   fits in what's left of Destination, it's decompressed straight into
+   Destination; otherwise, it's decompressed into Stream->Block first,
+   and only the part we need is copied out. (The rest of the block stays
+   there, so the next call can use it as well.)
+
+   The frame can only be read *forwards*, though - Position can't be
+   earlier than the start of the last block that went through
+   Stream->Block, or before the end of the last block that didn't.
+
+*/
+
+bool Lz4ReadStream(lz4Stream* Stream, uint64 Position, void* Destination, uint64 Size) {
+
+  uint8* Output = (uint8*)Destination;
+  uint32 ChecksumSize = (Stream->Info.HasBlockChecksums == true) ? 4 : 0;
+
+  while (Size > 0) {
+
+    // (If the block in Stream->Block covers Position, then copy as much
+    // as we can from there)
+
+    uint64 BlockEnd = (Stream->BlockStart + Stream->BlockLength);
+
+    if ((Position >= Stream->BlockStart) && (Position < BlockEnd)) {
+
+      uint64 Count = (Size < (BlockEnd - Position)) ? Size : (BlockEnd - Position);
+      CopyBytes(Output, &Stream->Block[Position - Stream->BlockStart], (uint32)Count);
+
+      Output += Count;
+      Position += Count;
+      Size -= Count;
+
+      continue;
+
+    }
+
+    // (Otherwise, we need to read the next block - as long as Position
+    // isn't behind it, and we haven't reached the end of the frame)
+
+    if ((Position < Stream->Produced) || (Stream->NextBlockSize == 0)) {
+      return false;
+    }
+
+    uint32 BlockSize = (Stream->NextBlockSize & ~Lz4UncompressedBlock);
+    bool IsCompressed = ((Stream->NextBlockSize & Lz4UncompressedBlock) == 0);
+
+    if (BlockSize > Stream->Info.BlockMaxSize) {
+      return false;
+    }
+
+    // (Read the block together with its checksum (if any) and the size of
+    // the next block, so every block only needs a single call to Read)
+
+    uint32 ReadSize = (BlockSize + ChecksumSize + 4);
+
+    if (Stream->Read(Stream->Context, Stream->Position, Stream->Buffer, ReadSize) == false) {
+      return false;
+    }
+
+    Stream->Position += ReadSize;
+    Stream->NextBlockSize = ReadLe32(&Stream->Buffer[BlockSize + ChecksumSize]);
+
+    // (Every block except for the last one should be exactly BlockMaxSize
+    // bytes long, but the format doesn't guarantee that, so this is just
+    // the most that this block *could* decompress to)
+
+    uint64 Remaining = (Stream->Info.ContentSize - Stream->Produced);
+    uint32 Length = (Remaining < Stream->Info.BlockMaxSize) ? (uint32)Remaining : Stream->Info.BlockMaxSize;
+
+    if (Length == 0) {
+      return false;
+    }
+
+    // (Decide where to decompress the block to, and then do it)
+
+    bool IsDirect = ((Position == Stream->Produced) && (Size >= Length));
+    uint8* BlockOutput = (IsDirect == true) ? Output : Stream->Block;
+
+    if (IsCompressed == true) {
+
+      if (Lz4DecompressBlock(Stream->Buffer, BlockSize, BlockOutput, &Length, NULL) == false) {
+        return false;
+      }
+
+    } else {
+
+      if (BlockSize > Length) {
+        return false;
+      }
+
+      CopyBytes(BlockOutput, Stream->Buffer, BlockSize);
+      Length = BlockSize;
+
+    }
+
+    if (IsDirect == true) {
+
+      Output += Length;
+      Position += Length;
+      Size -= Length;
+
+      Stream->BlockLength = 0;
+
+    } else {
+
+      Stream->BlockStart = Stream->Produced;
+      Stream->BlockLength = Length;
+
+    }
+
+    Stream->Produced += Length;
+
+  }
+
+  return true;
+
+}
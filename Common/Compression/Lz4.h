@@ -0,0 +1,80 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#ifndef SERRA_LZ4_H
+#define SERRA_LZ4_H
+
+  // (This file is shared between the 32-bit (Legacy) and 64-bit (EFI)
+  // bootloaders, so it has to be included *after* the right Stdint.h)
+
+  // Magic numbers, used to detect whether a file is compressed or not.
+  // (Both are stored in little-endian, as the first 4 bytes of the file)
+
+  #define Lz4FrameMagic 0x184D2204
+  #define ZstdFrameMagic 0xFD2FB528
+
+  // (The largest possible LZ4 frame header is 19 bytes long - 4 for the
+  // magic number, 2 for the descriptor, 8 for the content size, 4 for
+  // the dictionary ID, and 1 for the header checksum)
+
+  #define Lz4MaxFrameHeaderSize 19
+
+  // (This flag is set in the size field of blocks that are stored
+  // uncompressed; a size of zero marks the end of the frame)
+
+  #define Lz4UncompressedBlock (1UL << 31)
+
+
+  // LZ4 frame-related structures, from Lz4.c
+
+  typedef struct _lz4FrameInfo {
+
+    uint64 ContentSize; // (The total size of the decompressed data)
+
+    uint32 HeaderSize; // (The size of the frame header, in bytes)
+    uint32 BlockMaxSize; // (The maximum size of a single block, in bytes)
+
+    bool HasBlockChecksums; // (Does each block have a trailing checksum?)
+    bool HasContentChecksum; // (Does the frame have a trailing checksum?)
+    bool HasLinkedBlocks; // (Can blocks refer back to previous blocks?)
+
+  } lz4FrameInfo;
+
+  // (Callback used by Lz4ReadStream() to read a part of the
+  // compressed file; it should return false on failure)
+
+  typedef bool (*lz4ReadFunction)(void* Context, uint64 Position, void* Buffer, uint32 Size);
+
+  // (The state of a frame that's being decompressed as it's read, by
+  // Lz4ReadStream(); everything here is managed by Lz4.c)
+
+  typedef struct _lz4Stream {
+
+    lz4FrameInfo Info; // (The frame information, from Lz4ReadFrameHeader())
+
+    lz4ReadFunction Read; // (The function used to read the compressed file)
+    void* Context; // (The value that's passed through to Read)
+
+    uint8* Buffer; // (Where each compressed block is read to; BlockMaxSize + 8 bytes)
+    uint8* Block; // (Where blocks that can't go straight to their destination are decompressed to; BlockMaxSize bytes)
+
+    uint64 Position; // (The position of the next block within the compressed file)
+    uint64 Produced; // (How many bytes of decompressed data we've gone through so far)
+
+    uint64 BlockStart; // (Which part of the decompressed data is currently in Block)
+    uint32 BlockLength;
+
+    uint32 NextBlockSize; // (The size field of the next block, or 0 if we're at the end)
+
+  } lz4Stream;
+
+
+  // Functions from Lz4.c
+
+  bool Lz4ReadFrameHeader(const void* Header, uint32 Size, lz4FrameInfo* Info);
+  bool Lz4DecompressBlock(const void* Source, uint32 SourceSize, void* Destination, uint32* DestinationSize, const void* Window);
+  bool Lz4OpenStream(lz4Stream* Stream, const lz4FrameInfo* Info, lz4ReadFunction Read, void* Context, void* Buffer, void* Block);
+  bool Lz4ReadStream(lz4Stream* Stream, uint64 Position, void* Destination, uint64 Size);
+
+#endif
@@ -0,0 +1,101 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+// (This file is compiled by both the 32-bit (Legacy) and the 64-bit (EFI)
+// bootloaders, so we need to pick the right Stdint.h)
+
+#if defined(__amd64__) || defined(__x86_64__)
+  #include "../../Boot/Efi/Stdint.h"
+#else
+  #include "../../Boot/Legacy/Shared/Stdint.h"
+#endif
+
+#include "Relocations.h"
+
+/* bool ApplyPackedRelocations()
+
+   Inputs: uintptr Base - The start of the kernel area in memory;
+           uint64 Size - The size of the kernel area, in bytes;
+           const uint64* Table - The start of the `.relr.dyn` section;
+           uint64 NumEntries - The number of entries in that section;
+           uint64* NumRelocations - Where to save the number of relocations applied.
+
+   Outputs: bool - Whether every relocation was within the kernel area.
+
+   Position-independent executables usually have thousands of relative
+   relocations, which (in `.rela.dyn`) take up 24 bytes each; the packed
+   (DT_RELR) format gets that down to a fraction of the size, by encoding
+   them as a series of addresses and bitmaps:
+
+   - An even entry is the offset of a 64-bit word that needs to be
+   relocated (which, for relative relocations, just means adding Base).
+
+   - An odd entry is a bitmap of the next 63 words; if bit N is set (after
+   shifting out the lowest bit), then the Nth word needs to be relocated.
+
+   (Unlike with `.rela.dyn`, the addend is stored in the word itself, so
+   we add Base to it, instead of overwriting it.)
+
+*/
+
+bool ApplyPackedRelocations(uintptr Base, uint64 Size, const uint64* Table, uint64 NumEntries, uint64* NumRelocations) {
+
+  uint64 Where = 0;
+  *NumRelocations = 0;
+
+  if (Size < sizeof(uint64)) {
+    return false;
+  }
+
+  for (uint64 Index = 0; Index < NumEntries; Index++) {
+
+    uint64 Entry = Table[Index];
+
+    if ((Entry & 1) == 0) {
+
+      // (This is an address entry, so relocate that word, and start
+      // the next bitmap right after it)
+
+      if (Entry > (Size - sizeof(uint64))) {
+        return false;
+      }
+
+      *(uint64*)(Base + (uintptr)Entry) += Base;
+      (*NumRelocations)++;
+
+      Where = (Entry + sizeof(uint64));
+
+    } else {
+
+      // (This is a bitmap entry, so relocate every word with a set bit,
+      // and then move onto the next 63 words)
+
+      uint64 Offset = Where;
+
+      for (uint64 Bitmap = (Entry >> 1); Bitmap != 0; Bitmap >>= 1) {
+
+        if ((Bitmap & 1) != 0) {
+
+          if (Offset > (Size - sizeof(uint64))) {
+            return false;
+          }
+
+          *(uint64*)(Base + (uintptr)Offset) += Base;
+          (*NumRelocations)++;
+
+        }
+
+        Offset += sizeof(uint64);
+
+      }
+
+      Where += (63 * sizeof(uint64));
+
+    }
+
+  }
+
+  return true;
+
+}
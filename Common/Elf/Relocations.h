@@ -0,0 +1,15 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#ifndef SERRA_RELOCATIONS_H
+#define SERRA_RELOCATIONS_H
+
+  // (This file is shared between the 32-bit (Legacy) and 64-bit (EFI)
+  // bootloaders, so it has to be included *after* the right Stdint.h)
+
+  // Functions from Relocations.c
+
+  bool ApplyPackedRelocations(uintptr Base, uint64 Size, const uint64* Table, uint64 NumEntries, uint64* NumRelocations);
+
+#endif
@@ -0,0 +1,59 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "Host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// This program runs the memory routine benchmark (from Benchmark.c) as a
+// regular Linux program, so that the routines in x64/ (and the dispatch
+// table thresholds in Memory.c) can be measured without booting anything.
+
+// Usage: ./Bench [-m heap size, in MiB]
+
+// The heap needs to fit two buffers of up to 64 MiB each (along with
+// the allocator's own metadata); if it doesn't, the benchmark uses
+// smaller buffers instead.
+
+int main(int argc, char** argv) {
+
+  uint64 HeapSize = 256;
+  int Option;
+
+  while ((Option = getopt(argc, argv, "m:")) != -1) {
+
+    switch (Option) {
+
+      case 'm':
+        HeapSize = strtoull(optarg, NULL, 0);
+        break;
+
+      default:
+        fprintf(stderr, "Usage: %s [-m heap MiB]\n", argv[0]);
+        return 2;
+
+    }
+
+  }
+
+  // (Set up the CPU features (so we know which routines we can run, and
+  // what the dispatch table should look like), and then the memory
+  // management subsystem, so the benchmark can allocate its buffers)
+
+  InitializeHostCpuFeatures();
+
+  if (InitializeHostHeap((HeapSize * 1024 * 1024), 1) == false) {
+    fprintf(stderr, "Couldn't set up a %llu MiB heap.\n", (unsigned long long)HeapSize);
+    return 1;
+  }
+
+  Message(Info, "Detected a %d KiB L1d cache, a %d KiB L2 cache, and a %d KiB last-level cache",
+                (CpuCacheInfo.L1dSize / 1024), (CpuCacheInfo.L2Size / 1024), (CpuCacheInfo.LlcSize / 1024));
+
+  BenchmarkMemoryRoutines();
+  return 0;
+
+}
@@ -0,0 +1,103 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "Host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// This program runs the allocator's stress test (from Mm.c) as a regular
+// Linux program, against a made-up memory map, so that changes to the
+// allocator can be fuzzed and measured without having to boot anything.
+
+// Usage: ./Fuzz [-n operations] [-s seed] [-m heap size, in MiB]
+//               [-e number of memory map entries]
+
+// A seed of 0 (the default) picks a new one each time; every run shows
+// the seed it used, so failures can be reproduced with `-s`.
+
+int main(int argc, char** argv) {
+
+  uint64 NumOperations = 100000;
+  uint64 Seed = 0;
+  uint64 HeapSize = 256;
+  uint64 NumEntries = 4;
+
+  int Option;
+
+  while ((Option = getopt(argc, argv, "n:s:m:e:")) != -1) {
+
+    switch (Option) {
+
+      case 'n':
+        NumOperations = strtoull(optarg, NULL, 0);
+        break;
+      case 's':
+        Seed = strtoull(optarg, NULL, 0);
+        break;
+      case 'm':
+        HeapSize = strtoull(optarg, NULL, 0);
+        break;
+      case 'e':
+        NumEntries = strtoull(optarg, NULL, 0);
+        break;
+
+      default:
+        fprintf(stderr, "Usage: %s [-n operations] [-s seed] [-m heap MiB] [-e mmap entries]\n", argv[0]);
+        return 2;
+
+    }
+
+  }
+
+  if ((NumOperations == 0) || (NumOperations > 0xFFFFFFFF)) {
+    fprintf(stderr, "The number of operations must be between 1 and %u.\n", 0xFFFFFFFF);
+    return 2;
+  }
+
+  // (Set up the CPU features (so Memset() and Memcpy() work), and then
+  // the memory management subsystem itself)
+
+  InitializeHostCpuFeatures();
+
+  if (InitializeHostHeap((HeapSize * 1024 * 1024), (uint16)NumEntries) == false) {
+    fprintf(stderr, "Couldn't set up a %llu MiB heap with %llu entries.\n", (unsigned long long)HeapSize, (unsigned long long)NumEntries);
+    return 1;
+  }
+
+  Message(Info, "Managing %d KiB of memory in %d regions (%d KiB of metadata)",
+                (MmSubsystemData.ManagedSize / 1024), (uint64)MmSubsystemData.NumRegions,
+                (MmSubsystemData.MetadataSize / 1024));
+
+  if (VerifyMemoryManagementSubsystem(SystemPageSize) == false) {
+    Message(Fail, "VerifyMemoryManagementSubsystem() failed.");
+    return 1;
+  }
+
+  // (Run the stress test, and show how long it took overall - this also
+  // counts the checks, unlike the numbers for each workload)
+
+  uint64 Start = GetHostTime();
+  bool Result = StressTestMemoryManagementSubsystem((uint32)NumOperations, Seed);
+  uint64 Elapsed = (GetHostTime() - Start);
+
+  if (Elapsed == 0) {
+    Elapsed = 1;
+  }
+
+  Message(Info, "Took %d ms in total (%d operations per second, including checks)",
+                (Elapsed / 1000000), (((NumOperations * NumStressTestWorkloads) * 1000000000) / Elapsed));
+
+  PrintFragmentationReport();
+
+  if (Result == false) {
+    Message(Fail, "The stress test failed.");
+    return 1;
+  }
+
+  Message(Ok, "The stress test passed.");
+  return 0;
+
+}
@@ -0,0 +1,277 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "Host.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <time.h>
+
+// The kernel's memory management code (Mm.c, Memory.c, and so on) doesn't
+// depend on anything that only exists at boot, so it can also be built
+// and run as a regular Linux program; this file provides the handful of
+// things it needs from the rest of the kernel.
+
+// That means console output (which just goes to stdout here), CPU feature
+// detection (since InitializeCpuFeatures() needs to modify control
+// registers, which we can't do from user space), and a memory map, which
+// we make up by reserving memory with mmap().
+
+static usableMmapEntry HostMmap[MaxHostMmapEntries];
+
+
+
+// (Console output; these work the same way as the kernel's, except that
+// they ignore colors, and don't care whether the message is important)
+
+void Putchar(const char Character, [[maybe_unused]] bool Important, [[maybe_unused]] uint8 Attribute) {
+  putchar(Character);
+}
+
+void Print(const char* String, [[maybe_unused]] bool Important, [[maybe_unused]] uint8 Attribute) {
+  fputs(String, stdout);
+}
+
+// (This supports the same format specifiers as the kernel's vPrintf() -
+// %c, %s, %b, %d, %i and %x - which, unlike the standard library, always
+// take 64-bit integers)
+
+void vPrintf(const char* String, [[maybe_unused]] bool Important, [[maybe_unused]] uint8 Color, va_list Arguments) {
+
+  for (; *String != '\0'; String++) {
+
+    if (*String != '%') {
+      putchar(*String);
+      continue;
+    }
+
+    String++;
+
+    switch (*String) {
+
+      case 'c':
+        putchar((char)va_arg(Arguments, int));
+        break;
+
+      case 's':
+        fputs(va_arg(Arguments, const char*), stdout);
+        break;
+
+      case 'b': {
+
+        uint64 Value = va_arg(Arguments, unsigned long long);
+        int Bit = 63;
+
+        while ((Bit > 0) && (((Value >> Bit) & 1) == 0)) {
+          Bit--;
+        }
+
+        for (; Bit >= 0; Bit--) {
+          putchar((((Value >> Bit) & 1) != 0) ? '1' : '0');
+        }
+
+        break;
+
+      }
+
+      case 'd':
+        [[fallthrough]];
+      case 'i':
+        printf("%llu", va_arg(Arguments, unsigned long long));
+        break;
+
+      case 'x':
+        printf("%llX", va_arg(Arguments, unsigned long long));
+        break;
+
+      case '\0':
+        putchar('%');
+        return;
+
+      case '%':
+        putchar('%');
+        break;
+
+      default:
+        (void)va_arg(Arguments, int);
+        break;
+
+    }
+
+  }
+
+}
+
+void Printf(const char* String, bool Important, uint8 Color, ...) {
+
+  va_list Arguments;
+  va_start(Arguments, Color);
+
+  vPrintf(String, Important, Color, Arguments);
+  va_end(Arguments);
+
+}
+
+void Message(messageType Type, const char* String, ...) {
+
+  const char* Names[] = {"Info", "Kernel", "Ok", "Fail", "Warning", "Error"};
+
+  if ((Type >= 0) && (Type <= Error)) {
+    printf("[%s] ", Names[Type]);
+  } else {
+    printf("[Unknown] ");
+  }
+
+  va_list Arguments;
+  va_start(Arguments, String);
+
+  vPrintf(String, false, 0x07, Arguments);
+  va_end(Arguments);
+
+  putchar('\n');
+
+}
+
+
+
+/* void InitializeHostCpuFeatures()
+
+   Inputs: (None)
+   Outputs: (modifies CpuFeaturesAvailable{}, CpuCacheInfo{} and
+            MemoryDispatchTable{})
+
+   This function does the same job as InitializeCpuFeatures(), except
+   that it doesn't enable anything; instead, it checks which features the
+   CPU supports (in CPUID leaves 01h and 07h), and which of those the
+   operating system has already enabled (in XCR0).
+
+*/
+
+void InitializeHostCpuFeatures(void) {
+
+  cpuidRegisterTable Leaf1 = QueryCpuid(1, 0);
+  cpuidRegisterTable Leaf7 = {0};
+
+  if (QueryCpuid(0, 0).Rax >= 7) {
+    Leaf7 = QueryCpuid(7, 0);
+  }
+
+  CpuFeaturesAvailable.Fxsave = ((Leaf1.Rdx & (1ULL << 24)) != 0);
+  CpuFeaturesAvailable.Sse = ((Leaf1.Rdx & (1ULL << 25)) != 0);
+  CpuFeaturesAvailable.Sse2 = ((Leaf1.Rdx & (1ULL << 26)) != 0);
+
+  CpuFeaturesAvailable.Sse3 = ((Leaf1.Rcx & (1ULL << 0)) != 0);
+  CpuFeaturesAvailable.Ssse3 = ((Leaf1.Rcx & (1ULL << 9)) != 0);
+  CpuFeaturesAvailable.Sse4 = ((Leaf1.Rcx & ((1ULL << 19) | (1ULL << 20))) == ((1ULL << 19) | (1ULL << 20)));
+
+  CpuFeaturesAvailable.Erms = ((Leaf7.Rbx & (1ULL << 9)) != 0);
+
+  // AVX and AVX-512 can only be used if the operating system saves their
+  // registers, which it tells us through XCR0 (bits 1 and 2 for AVX, and
+  // bits 5 to 7 for AVX-512); that's only readable if OSXSAVE is set.
+
+  uint64 Xcr0 = 0;
+
+  if ((Leaf1.Rcx & (1ULL << 27)) != 0) {
+
+    uint32 Eax, Edx;
+    __asm__ __volatile__ ("xgetbv" : "=a"(Eax), "=d"(Edx) : "c"(0));
+
+    Xcr0 = (((uint64)Edx << 32) | Eax);
+    CpuFeaturesAvailable.Xsave = true;
+
+  }
+
+  bool HasAvxState = ((Xcr0 & 0x06) == 0x06);
+  bool HasAvx512State = ((Xcr0 & 0xE6) == 0xE6);
+
+  CpuFeaturesAvailable.Avx = (HasAvxState && ((Leaf1.Rcx & (1ULL << 28)) != 0));
+  CpuFeaturesAvailable.Avx2 = (CpuFeaturesAvailable.Avx && ((Leaf7.Rbx & (1ULL << 5)) != 0));
+  CpuFeaturesAvailable.Avx512f = (HasAvx512State && ((Leaf7.Rbx & (1ULL << 16)) != 0));
+  CpuFeaturesAvailable.Avx512bw = (CpuFeaturesAvailable.Avx512f && ((Leaf7.Rbx & (1ULL << 30)) != 0));
+
+  // (Now that we know what we can use, set up the cache sizes and the
+  // dispatch table, like InitializeCpuFeatures() would)
+
+  DetectCacheTopology();
+  InitializeMemoryDispatchTable();
+
+}
+
+
+
+/* bool InitializeHostHeap()
+
+   Inputs: uint64 Size - How much memory the allocator should manage, in
+           bytes (this is rounded down to a multiple of 2 MiB).
+
+           uint16 NumEntries - How many usable memory map entries to split
+           that memory into (at most MaxHostMmapEntries).
+
+   Outputs: bool - Whether we were able to set up the memory management
+            subsystem.
+
+   This function reserves `Size` bytes with mmap(), splits them into a
+   made-up usable memory map, and initializes the memory management
+   subsystem with it, the same way the kernel does with the real one.
+
+   Each entry is followed by an inaccessible 2 MiB gap, so that anything
+   that writes past the end of an entry crashes straight away, and so
+   that blocks from different entries can never look like buddies.
+
+*/
+
+bool InitializeHostHeap(uint64 Size, uint16 NumEntries) {
+
+  const uint64 Granularity = 0x200000;
+
+  if ((NumEntries == 0) || (NumEntries > MaxHostMmapEntries)) {
+    return false;
+  }
+
+  uint64 EntrySize = ((Size / NumEntries) & ~(Granularity - 1));
+
+  if (EntrySize < MmapEntryMemoryLimit) {
+    return false;
+  }
+
+  // (Reserve everything at once, with an extra 2 MiB at the start so we
+  // can align it, and then make the gaps between entries inaccessible)
+
+  uint64 Stride = (EntrySize + Granularity);
+  uint64 Reserved = ((Stride * NumEntries) + Granularity);
+
+  void* Mapping = mmap(NULL, Reserved, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE), -1, 0);
+
+  if (Mapping == MAP_FAILED) {
+    return false;
+  }
+
+  uintptr Base = (((uintptr)Mapping + Granularity - 1) & ~(Granularity - 1));
+
+  for (uint16 Entry = 0; Entry < NumEntries; Entry++) {
+
+    HostMmap[Entry].Base = (Base + (Entry * Stride));
+    HostMmap[Entry].Limit = EntrySize;
+
+    mprotect((void*)(HostMmap[Entry].Base + EntrySize), Granularity, PROT_NONE);
+
+  }
+
+  return InitializeMemoryManagementSubsystem((void*)HostMmap, NumEntries);
+
+}
+
+
+
+// (Get the current time, in nanoseconds, from a monotonic clock)
+
+uint64 GetHostTime(void) {
+
+  struct timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+
+  return (((uint64)Time.tv_sec * 1000000000) + (uint64)Time.tv_nsec);
+
+}
@@ -0,0 +1,28 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#ifndef SERRA_HOST_H
+#define SERRA_HOST_H
+
+  // (The kernel's own headers need to be included before any of the host's
+  // headers, since they define a few things (like NULL) differently)
+
+  #include "../Kernel/Libraries/Stdint.h"
+  #include "../Kernel/Libraries/Stdio.h"
+  #include "../Kernel/System/System.h"
+  #include "../Kernel/Memory/Memory.h"
+  #include "../Common.h"
+
+  // Include definitions from Host.c
+
+  #define MaxHostMmapEntries 16 // (The most usable memory map entries InitializeHostHeap() can make up)
+
+  // Include functions from Host.c
+
+  void InitializeHostCpuFeatures(void);
+  bool InitializeHostHeap(uint64 Size, uint16 NumEntries);
+
+  uint64 GetHostTime(void);
+
+#endif
@@ -235,29 +235,54 @@ void KernelCore(commonInfoTable* InfoTable) {
 
   // (Show memory allocation nodes and such)
 
-  for (uint16 Limit = MmSubsystemData.Limits[0]; Limit < MmSubsystemData.Limits[1]; Limit++) {
+  Message(Info, "Managing %d KiB of memory (%d KiB of metadata, %d KiB reclaimed)",
+                (MmSubsystemData.ManagedSize / 1024), (MmSubsystemData.MetadataSize / 1024),
+                (MmSubsystemData.ReclaimedSize / 1024));
 
-    uint64 Num = 0;
-    allocationNode* Node = MmSubsystemData.Nodes[Limit];
+  if (MmSubsystemData.NumDroppedRegions != 0) {
 
-    while (Node != NULL) {
+    Message(Warning, "Couldn't manage %d KiB of memory in %d region(s); there are more than %d regions",
+                     (MmSubsystemData.DroppedSize / 1024), (uint64)MmSubsystemData.NumDroppedRegions,
+                     (uint64)MaxMemoryRegions);
 
-      Message(Info, "Found a %xh-sized block (at %xh) that represents (%xh, %xh) | (prevS=%xh)",
-                    (1ULL << Limit), ((uintptr)Node),
-                    (uintptr)Node->Pointer, ((uintptr)Node->Pointer + (1ULL << Limit)),
-                    (uintptr)Node->Size.Previous);
+    Message(Warning, "The first region that was dropped is from %xh to %xh (%d KiB)",
+                     MmSubsystemData.DroppedBase, MmSubsystemData.DroppedLimit,
+                     ((MmSubsystemData.DroppedLimit - MmSubsystemData.DroppedBase) / 1024));
 
-      Node = Node->Size.Previous;
-      Num++;
+  }
 
-    }
+  PrintFragmentationReport();
 
-    if (Num != 0) {
-      Message(Info, "Found %d nodes at logarithm level [%d]", Num, (uint64)Limit);
-    }
+  if (FrameAllocatorData.IsEnabled == true) {
+
+    Message(Info, "Frame allocator has %d free 4 KiB frames, %d free 2 MiB frames, and %d free 1 GiB frames",
+                  FrameAllocatorData.NumFree[FrameOrder_4KiB], FrameAllocatorData.NumFree[FrameOrder_2MiB],
+                  FrameAllocatorData.NumFree[FrameOrder_1GiB]);
+
+  }
+
+  if (PagingSubsystemData.IsEnabled == true) {
+
+    Message(Info, "Paging subsystem @ (NumTables = %d, NumSplitPages = %d, NumPromotedPages = %d)",
+                  PagingSubsystemData.NumTables, PagingSubsystemData.NumSplitPages,
+                  PagingSubsystemData.NumPromotedPages);
+
+    Message(Info, "Paging subsystem @ (SupportsPat = `%s`, Supports1GiBPages = `%s`)",
+                  (PagingSubsystemData.SupportsPat == true ? "true" : "false"),
+                  (PagingSubsystemData.Supports1GiBPages == true ? "true" : "false"));
 
   }
 
+  #ifdef StressTestAllocator
+    if (StressTestMemoryManagementSubsystem(5000, StressTestAllocatorSeed) == false) {
+      Message(Fail, "The memory management subsystem failed its stress test.");
+    }
+  #endif
+
+  #ifdef BenchmarkMemory
+    BenchmarkMemoryRoutines();
+  #endif
+
 
   // (Initialize the filesystem/partition subsystem - it's still not ready,
   // so we initialize it here rather than in Entry.c to catch error
@@ -266,6 +291,11 @@ void KernelCore(commonInfoTable* InfoTable) {
   Print("\n\r", false, 0x0F);
   [[maybe_unused]] bool Thing2 = InitializeFsSubsystem();
 
+  // (Show any allocations that haven't been freed yet; this only shows
+  // anything useful if TraceAllocations is enabled)
+
+  PrintAllocationTrace();
+
 
   // (This used to have the graphical demo - for now this is just a
   // placeholder until the boot manager is actually up and running.)
@@ -284,19 +314,39 @@ void KernelCore(commonInfoTable* InfoTable) {
     Print("\n\r", true, 0x07);
     Message(Warning, "Press any key to return.");
 
+    // (While we're waiting, refill the pool of pre-zeroed blocks that
+    // AllocateZeroed() uses, since we'd be doing nothing otherwise)
+
     efiInputKey PhantomKey;
-    while (gST->ConIn->ReadKeyStroke(gST->ConIn, &PhantomKey) == EfiNotReady);
+
+    while (gST->ConIn->ReadKeyStroke(gST->ConIn, &PhantomKey) == EfiNotReady) {
+      [[maybe_unused]] bool Result = RefillZeroPool();
+    }
 
   } else {
 
-    // (Do a lot of NOPs to stall the system)
+    // (Do a lot of NOPs to stall the system, refilling the pool of
+    // pre-zeroed blocks whenever it isn't full yet)
+
+    bool IsRefilling = true;
 
     for (uint64 Count = 0; Count < 20000000000; Count++) {
+
+      if (IsRefilling == true) {
+        IsRefilling = RefillZeroPool();
+      }
+
       __asm__ __volatile__ ("nop");
+
     }
 
   }
 
+  // (Give the pool of pre-zeroed blocks back to the heap, now that
+  // nothing else is going to allocate from it)
+
+  DrainZeroPool();
+
   // (Return.)
 
   return;
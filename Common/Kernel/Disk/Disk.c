@@ -356,7 +356,7 @@ bool TerminateDiskSubsystem(void) {
       // (Allocate a temporary buffer to store the first sector in)
 
       const uintptr TempSize = Volume->BytesPerSector;
-      void* Temp = Allocate(&TempSize);
+      void* Temp = AllocateSmall(&TempSize);
 
       if (Temp == NULL) {
         return false;
@@ -397,7 +397,7 @@ bool TerminateDiskSubsystem(void) {
 
       CleanupStart:
 
-      if (Free(Temp, &TempSize) == true) {
+      if (FreeSmall(Temp, &TempSize) == true) {
         return Status;
       } else {
         return false;
@@ -417,33 +417,20 @@ bool TerminateDiskSubsystem(void) {
     // *so we can't read data to it directly*.
 
     // Instead, we'll need to allocate a temporary buffer to read
-    // to, like this:
+    // to, that *does* meet those requirements, like this:
 
-    const uintptr TempSize = Alignment + (NumSectors * Volume->BytesPerSector);
-    void* TempPointer = Allocate(&TempSize);
+    const uintptr TempSize = (NumSectors * Volume->BytesPerSector);
+    void* TempBuffer = AllocateEx(&TempSize, Alignment, 0, AllocateFlag_None);
 
     // (Make sure that the allocation succeeded, and declare a status
     // variable, so we can jump to `CleanupBuffer`)
 
-    if (TempPointer == NULL) {
+    if (TempBuffer == NULL) {
       return false;
     }
 
     bool Status = true;
 
-    // Now that we have a buffer, we need to update the pointer so that
-    // it also fits alignment requirements.
-
-    // (`TempBuffer` is guaranteed to be aligned, but not `TempPointer`)
-
-    uintptr TempAddress = (uintptr)TempPointer;
-
-    if ((TempAddress % Alignment) > 0) {
-      TempAddress += (Alignment - (TempAddress % Alignment));
-    }
-
-    void* TempBuffer = (void*)TempAddress;
-
     // Finally, now that we have a buffer we can read into, let's do that:
     // (We also want to check if the read was successful)
 
@@ -456,16 +443,14 @@ bool TerminateDiskSubsystem(void) {
     // Now that we've read it, we can copy our transfer buffer's contents
     // to `Buffer`, using Memmove():
 
-    TempBuffer = (void*)(TempAddress + StartOffset);
-
-    Memmove(Buffer, TempBuffer, Size);
+    Memmove(Buffer, (const void*)((uintptr)TempBuffer + StartOffset), Size);
     goto CleanupBuffer;
 
     // (No matter what, we *have* to free the buffer we allocated)
 
     CleanupBuffer:
 
-    if (Free(TempPointer, &TempSize) == true) {
+    if (Free(TempBuffer, &TempSize) == true) {
       return Status;
     } else {
       return false;
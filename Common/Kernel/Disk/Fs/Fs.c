@@ -272,9 +272,9 @@ static uint16 ConvertGptPartitionType(const genericUuid PartitionType) [[reprodu
   // another partition type (defined as `genericUuid`))
 
   // C doesn't allow you to directly compare structures, and since UUIDs
-  // are represented as such, we need to use Memcmp(), like this:
+  // are represented as such, we need to use UuidsAreEqual(), like this:
 
-  #define MatchesPartitionType(Type) ((Memcmp(&Type, &PartitionType, sizeof(genericUuid)) == 0) ? true : false)
+  #define MatchesPartitionType(Type) UuidsAreEqual(&Type, &PartitionType)
 
   // (EFI System Partitions are always `VolumeType_Partition_Fat`)
 
@@ -414,7 +414,10 @@ static uint16 ConvertGptPartitionType(const genericUuid PartitionType) [[reprodu
 // partitions (obviously) - in a for loop, you'd do something like:
 // `for (uint16 Index = ReturnVal; Index < NumVolumes; Index++)`
 
-static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
+// (Any temporary buffers are allocated from `Arena`, so they're freed
+// by the caller, once it's done with the volume)
+
+static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum, memoryArena* Arena) {
 
   // Before we do anything else, let's see if the disk is MBR- or
   // GPT-formatted, by checking for the existence of a GPT
@@ -458,8 +461,8 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
 
     // (Allocate space for `PrimaryGptHeader` and `BackupGptHeader`)
 
-    PrimaryGptHeader = (gptHeader*)(Allocate(&SectorSize));
-    BackupGptHeader = (gptHeader*)(Allocate(&SectorSize));
+    PrimaryGptHeader = (gptHeader*)(ArenaAlloc(Arena, SectorSize));
+    BackupGptHeader = (gptHeader*)(ArenaAlloc(Arena, SectorSize));
 
     if ((PrimaryGptHeader == NULL) || (BackupGptHeader == NULL)) {
       goto Cleanup;
@@ -524,7 +527,7 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
     // allocate a buffer of that size)
 
     GptPartitionArraySize = (Header->NumPartitions * Header->PartitionEntrySize);
-    GptPartitionArray = (gptPartition*)(Allocate(&GptPartitionArraySize));
+    GptPartitionArray = (gptPartition*)(ArenaAlloc(Arena, GptPartitionArraySize));
 
     // (Check if the allocation was successful)
 
@@ -539,7 +542,7 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
                                           GptPartitionArraySize, VolumeNum);
 
     if (ReadGptPartitionArray == false) {
-      goto CleanupPartition;
+      goto Cleanup;
     }
 
     // (Calculate the CRC-32 checksum of the partition entry array in
@@ -548,7 +551,7 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
     auto Checksum = CalculateCrc32(GptPartitionArray, GptPartitionArraySize);
 
     if (Checksum != Header->PartitionCrc32) {
-      goto CleanupPartition;
+      goto Cleanup;
     }
 
     // Now that we *know* we have a valid partition table array, we can
@@ -564,7 +567,7 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
       // If this partition entry is empty (`GptPartitionType_None`),
       // then move onto the next entry.
 
-      if (Memcmp(&Type, &GptPartitionType_None, sizeof(genericUuid)) == 0) {
+      if (UuidsAreEqual(&Type, &GptPartitionType_None) == true) {
         continue;
       }
 
@@ -609,14 +612,6 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
 
     }
 
-    // (Free the buffer we allocated for the partition array, if applicable)
-
-    CleanupPartition:
-
-    if (GptPartitionArray != NULL) {
-      [[maybe_unused]] bool Result = Free((void*)GptPartitionArray, &GptPartitionArraySize);
-    }
-
     goto Cleanup;
 
   } else {
@@ -688,18 +683,11 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
     Volume->Type = VolumeType_Mbr;
   }
 
-  // (No matter what, we *have* to free what we allocated)
+  // (Everything we allocated came from `Arena`, so there's nothing for
+  // us to free here; the caller takes care of that)
 
   Cleanup:
 
-  if (PrimaryGptHeader != NULL) {
-    [[maybe_unused]] bool Result = Free((void*)PrimaryGptHeader, &SectorSize);
-  }
-
-  if (BackupGptHeader != NULL) {
-    [[maybe_unused]] bool Result = Free((void*)BackupGptHeader, &SectorSize);
-  }
-
   return SaveNumVolumes;
 
 }
@@ -724,6 +712,15 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
   // Next, we need to iterate through each applicable volume on the
   // system, and attempt to identify its type.
 
+  // (Any temporary buffers we need while processing a volume are
+  // allocated from an arena, and freed all at once afterwards)
+
+  memoryArena Arena;
+
+  if (ArenaCreate(&Arena, 0) == false) {
+    return false;
+  }
+
   auto NumUsableVolumes = 0;
   const uint16 VolumeLimit = NumVolumes;
 
@@ -761,7 +758,10 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
 
       Message(Kernel, "Preparing to process volume (%d).", (uint64)Index);
 
-      uint16 OldNumVolumes = DetectPartitionMap(Mbr, Index);
+      arenaMark Mark = ArenaMark(&Arena);
+      uint16 OldNumVolumes = DetectPartitionMap(Mbr, Index, &Arena);
+
+      ArenaReset(&Arena, Mark);
 
       Message(Info, "Volume (%d) uses %s partition map.", (uint64)Index,
                     ((VolumeList[Index].Type == VolumeType_Mbr) ? "an MBR" : "a GPT"));
@@ -800,6 +800,10 @@ static uint16 DetectPartitionMap(mbrHeader* Mbr, uint16 VolumeNum) {
 
   }
 
+  // (Free anything that's still left in the arena)
+
+  ArenaDestroy(&Arena);
+
   // If we didn't find any usable volumes, then we should return
   // false.
 
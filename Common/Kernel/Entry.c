@@ -233,52 +233,38 @@ entrypointReturnStatus Entrypoint(commonInfoTable* InfoTable) {
     return EntrypointMemoryMapIsNull;
   }
 
-  // (Check that no entries within the 'usable' memory map overlap)
+  // (Check that the 'usable' memory map is in the same format that
+  // NormalizeMmap() produces - sorted, with no overlapping entries, and
+  // with every entry aligned to page size boundaries *and* at least
+  // `MmapEntryMemoryLimit` bytes long)
 
   usableMmapEntry* UsableMmap = InfoTable->Memory.List.Pointer;
 
-  for (auto Index = 1; Index < InfoTable->Memory.NumEntries; Index++) {
+  switch (VerifyUsableMmap(UsableMmap, InfoTable->Memory.NumEntries, SystemPageSize, MmapEntryMemoryLimit)) {
 
-    // (Check if any entries overlap)
+    case MmapIsValid:
+      break;
 
-    auto EndOfLastEntry = (UsableMmap[Index - 1].Base + UsableMmap[Index - 1].Limit);
-    auto StartOfThisEntry = UsableMmap[Index].Base;
+    case MmapHasNoEntries:
+      return EntrypointMemoryMapHasNoEntries;
 
-    if (StartOfThisEntry < EndOfLastEntry) {
+    case MmapHasOverlappingEntries:
       return EntrypointMemoryMapHasOverlappingEntries;
-    }
+
+    case MmapIsNotAligned:
+      return EntrypointMemoryMapNotPageAligned;
+
+    default:
+      return EntrypointMemoryMapEntryUnderMinSize;
 
   }
 
-  // (Scan through the usable memory map, calculating the amount available
-  // to the kernel, and checking that all entries are aligned to page
-  // size boundaries *and* are at least `MmapEntryMemoryLimit` bytes)
+  // (Calculate the amount of memory available to the kernel)
 
   uint64 UsableMemoryAvailable = 0;
 
   for (auto Index = 0; Index < InfoTable->Memory.NumEntries; Index++) {
-
-    // (Add this entry's size to UsableMemoryAvailable)
-
-    auto Start = UsableMmap[Index].Base;
-    auto End = (Start + UsableMmap[Index].Limit);
-
-    UsableMemoryAvailable += (End - Start);
-
-    // (Check if any of the entries are not page aligned)
-
-    if ((Start % SystemPageSize) != 0) {
-      return EntrypointMemoryMapNotPageAligned;
-    } else if ((End % SystemPageSize) != 0) {
-      return EntrypointMemoryMapNotPageAligned;
-    }
-
-    // (Check if the entry size is at least `MmapEntryMemoryLimit`)
-
-    if ((End - Start) < MmapEntryMemoryLimit) {
-      return EntrypointMemoryMapEntryUnderMinSize;
-    }
-
+    UsableMemoryAvailable += UsableMmap[Index].Limit;
   }
 
   // (If the amount of memory available to the kernel is under
@@ -556,6 +542,24 @@ entrypointReturnStatus Entrypoint(commonInfoTable* InfoTable) {
 
   }
 
+  // (Set up the page frame allocator, which takes a share of the heap's
+  // memory; if it fails, the paging subsystem just takes its page tables
+  // from the regular heap instead)
+
+  [[maybe_unused]] bool HasFrameAllocator = InitializeFrameAllocator();
+
+  // (Take over the page tables from the bootloader (or firmware), so we
+  // can change the cache type of things like the framebuffer; if it fails,
+  // we keep running on the bootloader's tables, with their cache types)
+
+  [[maybe_unused]] bool HasPaging = InitializePagingSubsystem();
+
+  // (Fill the pool of pre-zeroed blocks that AllocateZeroed() uses, now,
+  // before anything else needs them; this is bounded by the size of the
+  // pool, and just stops early if we're low on memory)
+
+  while (RefillZeroPool() == true);
+
   // (TODO - Initialize the ACPI subsystem)
 
   // (TODO - Initialize the PCI/PCIe subsystem)
@@ -11,6 +11,7 @@
   #include "Libraries/String.h"
   #include "Libraries/Stdio.h"
   #include "../Common.h"
+  #include "../Memory/Mmap.h"
 
   // Import disk- and filesystem-specific headers.
 
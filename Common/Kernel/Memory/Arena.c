@@ -0,0 +1,158 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "../Libraries/Stdint.h"
+#include "../Libraries/String.h"
+#include "../System/System.h"
+#include "../../Common.h"
+#include "Memory.h"
+
+// A lot of boot-time work (scanning partitions, parsing configuration
+// files, etc.) makes many short-lived allocations that all stop being
+// needed at the same time. Instead of allocating and freeing each one
+// separately, this file implements a simple arena (or 'bump') allocator
+// on top of Allocate() - memory is handed out from large chunks, and
+// freed all at once with ArenaReset() or ArenaDestroy().
+
+
+
+// (Set up an arena, which allocates chunks of at least `ChunkSize` bytes
+// (or DefaultArenaChunkSize, if zero); this doesn't allocate any memory
+// by itself)
+
+bool ArenaCreate(memoryArena* Arena, uintptr ChunkSize) {
+
+  if (Arena == NULL) {
+    return false;
+  }
+
+  if (ChunkSize == 0) {
+    ChunkSize = DefaultArenaChunkSize;
+  }
+
+  if ((ChunkSize % SystemPageSize) != 0) {
+    ChunkSize += (SystemPageSize - (ChunkSize % SystemPageSize));
+  }
+
+  Arena->Chunk = NULL;
+  Arena->Offset = 0;
+  Arena->ChunkSize = ChunkSize;
+
+  return true;
+
+}
+
+
+
+// (Allocate `Size` bytes from an arena, aligned to ArenaAlignment bytes;
+// returns NULL if we're out of memory)
+
+[[nodiscard]] void* ArenaAlloc(memoryArena* Arena, uintptr Size) {
+
+  if (Arena == NULL) {
+    return NULL;
+  } else if (Size == 0) {
+    return NULL;
+  }
+
+  Size = ((Size + ArenaAlignment - 1) & ~((uintptr)ArenaAlignment - 1));
+
+  // If there's enough space left in the current chunk, then we can just
+  // bump the offset and return; this is the case most of the time.
+
+  if ((Arena->Chunk != NULL) && ((Arena->Chunk->Size - Arena->Offset) >= Size)) {
+
+    void* Pointer = (void*)((uintptr)Arena->Chunk + Arena->Offset);
+    Arena->Offset += Size;
+
+    return Pointer;
+
+  }
+
+  // Otherwise, we need to allocate a new chunk - usually `ChunkSize`
+  // bytes, unless this allocation wouldn't fit in that - and make it
+  // the current one.
+
+  // (The rest of the old chunk goes unused, but it'll still be freed
+  // along with everything else)
+
+  uintptr Header = ((sizeof(arenaChunk) + ArenaAlignment - 1) & ~((uintptr)ArenaAlignment - 1));
+  uintptr ChunkSize = Arena->ChunkSize;
+
+  if ((Header + Size) > ChunkSize) {
+    ChunkSize = (Header + Size);
+  }
+
+  arenaChunk* Chunk = (arenaChunk*)Allocate(&ChunkSize);
+
+  if (Chunk == NULL) {
+    return NULL;
+  }
+
+  Chunk->Previous = Arena->Chunk;
+  Chunk->Size = ChunkSize;
+
+  Arena->Chunk = Chunk;
+  Arena->Offset = (Header + Size);
+
+  return (void*)((uintptr)Chunk + Header);
+
+}
+
+
+
+// (Take a snapshot of an arena's current position, which can later be
+// passed to ArenaReset() to free everything allocated after it)
+
+arenaMark ArenaMark(const memoryArena* Arena) {
+
+  arenaMark Mark = {0};
+
+  if (Arena != NULL) {
+
+    Mark.Chunk = Arena->Chunk;
+    Mark.Offset = Arena->Offset;
+
+  }
+
+  return Mark;
+
+}
+
+
+
+// (Free everything that was allocated from an arena after `Mark` was
+// taken; chunks that were allocated after that point go back to Free())
+
+void ArenaReset(memoryArena* Arena, arenaMark Mark) {
+
+  if (Arena == NULL) {
+    return;
+  }
+
+  while ((Arena->Chunk != NULL) && (Arena->Chunk != Mark.Chunk)) {
+
+    arenaChunk* Chunk = Arena->Chunk;
+    const uintptr Size = Chunk->Size;
+
+    Arena->Chunk = Chunk->Previous;
+    [[maybe_unused]] bool Result = Free((void*)Chunk, &Size);
+
+  }
+
+  Arena->Offset = ((Arena->Chunk != NULL) ? Mark.Offset : 0);
+
+}
+
+
+
+// (Free everything that was ever allocated from an arena; the arena can
+// still be used afterwards, as if it had just been created)
+
+void ArenaDestroy(memoryArena* Arena) {
+
+  arenaMark Mark = {0};
+  ArenaReset(Arena, Mark);
+
+}
@@ -0,0 +1,371 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "../Libraries/Stdint.h"
+#include "../Libraries/String.h"
+#include "../System/System.h"
+#include "../../Common.h"
+#include "Memory.h"
+#include "../Libraries/Stdio.h"
+
+#if defined(BenchmarkMemory) && (defined(__amd64__) || defined(__x86_64__))
+
+  // When BenchmarkMemory is defined (see makefile.config), the kernel
+  // times every Memcpy() and Memset() routine in x64/ at boot, across a
+  // range of sizes (from 1 byte up to 64 MiB) and alignments, and shows
+  // how fast each one was. This is mostly useful for tuning the size
+  // class thresholds in InitializeMemoryDispatchTable() on a specific
+  // CPU; without it, none of this is compiled in.
+
+  #define MaxBenchmarkSize 0x4000000 // (The largest size we try to benchmark, 64 MiB)
+  #define BenchmarkBytes 0x1000000 // (How many bytes each measurement should copy or fill, 16 MiB)
+
+  #define MinBenchmarkIterations 2
+  #define MaxBenchmarkIterations 65536
+
+  // (Platform-specific memory functions, from x64/Memcpy.asm and
+  // x64/Memset.asm)
+
+  extern void Memcpy_RepMovsb(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Sse2(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Avx(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Avx512f(void* Destination, const void* Source, uint64 Size);
+
+  extern void Memcpy_Sse2Temporal(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_AvxTemporal(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Avx2Temporal(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Avx512fTemporal(void* Destination, const void* Source, uint64 Size);
+
+  extern void Memset_RepStosb(void* Buffer, uint8 Value, uint64 Size);
+  extern void Memset_Sse2(void* Buffer, uint8 Value, uint64 Size);
+  extern void Memset_Avx(void* Buffer, uint8 Value, uint64 Size);
+  extern void Memset_Avx2(void* Buffer, uint8 Value, uint64 Size);
+  extern void Memset_Avx512f(void* Buffer, uint8 Value, uint64 Size);
+
+  extern void Memset_NonTemporal(void* Buffer, uint8 Value, uint64 Size);
+
+  // (Wrappers around Memcpy() and Memset() themselves, so we can see
+  // what the dispatch table actually picks for each size)
+
+  static void DispatchedMemcpy(void* Destination, const void* Source, uint64 Size) {
+    Memcpy(Destination, Source, Size);
+  }
+
+  static void DispatchedMemset(void* Buffer, uint8 Value, uint64 Size) {
+    Memset(Buffer, Value, Size);
+  }
+
+  // (Every routine we benchmark, along with the smallest size it can
+  // handle, and the CPU features it needs; most of these align the
+  // destination first, so they need at least one vector's worth of data,
+  // and the non-temporal Memcpy() routines need more than that)
+
+  typedef enum _benchmarkRequirement : uint8 {
+
+    Requires_None = 0,
+    Requires_Avx = 1,
+    Requires_Avx2 = 2,
+    Requires_Avx512f = 3
+
+  } benchmarkRequirement;
+
+  typedef struct _memoryBenchmarkRoutine {
+
+    const char* Name;
+
+    memoryCopyFunction Copy; // (Only one of these should be set)
+    memoryFillFunction Fill;
+
+    uint64 MinSize; // (The smallest `Size` the routine accepts)
+    benchmarkRequirement Requires; // (The CPU features the routine needs)
+
+  } memoryBenchmarkRoutine;
+
+  static const memoryBenchmarkRoutine CopyRoutines[] = {
+
+    {.Name = "RepMovsb", .Copy = Memcpy_RepMovsb},
+    {.Name = "Sse2", .Copy = Memcpy_Sse2, .MinSize = 256},
+    {.Name = "Sse2Temporal", .Copy = Memcpy_Sse2Temporal, .MinSize = 16},
+    {.Name = "Avx", .Copy = Memcpy_Avx, .MinSize = 512, .Requires = Requires_Avx},
+    {.Name = "AvxTemporal", .Copy = Memcpy_AvxTemporal, .MinSize = 32, .Requires = Requires_Avx},
+    {.Name = "Avx2Temporal", .Copy = Memcpy_Avx2Temporal, .MinSize = 64, .Requires = Requires_Avx2},
+    {.Name = "Avx512f", .Copy = Memcpy_Avx512f, .MinSize = 2048, .Requires = Requires_Avx512f},
+    {.Name = "Avx512fTemporal", .Copy = Memcpy_Avx512fTemporal, .MinSize = 64, .Requires = Requires_Avx512f},
+    {.Name = "Memcpy()", .Copy = DispatchedMemcpy}
+
+  };
+
+  static const memoryBenchmarkRoutine FillRoutines[] = {
+
+    {.Name = "RepStosb", .Fill = Memset_RepStosb},
+    {.Name = "Sse2", .Fill = Memset_Sse2, .MinSize = 16},
+    {.Name = "Avx", .Fill = Memset_Avx, .MinSize = 32, .Requires = Requires_Avx},
+    {.Name = "Avx2", .Fill = Memset_Avx2, .MinSize = 32, .Requires = Requires_Avx2},
+    {.Name = "Avx512f", .Fill = Memset_Avx512f, .MinSize = 64, .Requires = Requires_Avx512f},
+    {.Name = "NonTemporal", .Fill = Memset_NonTemporal},
+    {.Name = "Memset()", .Fill = DispatchedMemset}
+
+  };
+
+  #define NumCopyRoutines (sizeof(CopyRoutines) / sizeof(memoryBenchmarkRoutine))
+  #define NumFillRoutines (sizeof(FillRoutines) / sizeof(memoryBenchmarkRoutine))
+
+  // (The (destination, source) offsets we try for each size, relative to
+  // a 64-byte boundary; fills only use the ones with a source offset of 0)
+
+  static const uint8 BenchmarkOffsets[][2] = {{0, 0}, {0, 5}, {5, 0}, {3, 7}};
+  #define NumBenchmarkOffsets (sizeof(BenchmarkOffsets) / sizeof(BenchmarkOffsets[0]))
+
+
+
+  // (Check whether the CPU supports everything a routine needs)
+
+  static bool IsRoutineAvailable(const memoryBenchmarkRoutine* Routine) {
+
+    switch (Routine->Requires) {
+
+      case Requires_Avx:
+        return CpuFeaturesAvailable.Avx;
+      case Requires_Avx2:
+        return CpuFeaturesAvailable.Avx2;
+      case Requires_Avx512f:
+        return CpuFeaturesAvailable.Avx512f;
+
+      default:
+        return true;
+
+    }
+
+  }
+
+  // (Calculate how many times we should call a routine for a given size,
+  // so that each measurement moves around BenchmarkBytes bytes)
+
+  static inline uint64 GetBenchmarkIterations(uint64 Size) {
+
+    uint64 Iterations = (BenchmarkBytes / Size);
+
+    if (Iterations < MinBenchmarkIterations) {
+      Iterations = MinBenchmarkIterations;
+    } else if (Iterations > MaxBenchmarkIterations) {
+      Iterations = MaxBenchmarkIterations;
+    }
+
+    return Iterations;
+
+  }
+
+  // (Time a single routine, after calling it once to warm up the cache
+  // and TLB; returns the number of ticks it took)
+
+  static uint64 TimeRoutine(const memoryBenchmarkRoutine* Routine, void* Destination, const void* Source, uint64 Size, uint64 Iterations) {
+
+    if (Routine->Copy != NULL) {
+
+      Routine->Copy(Destination, Source, Size);
+      uint64 Start = ReadTimestampCounter();
+
+      for (uint64 Iteration = 0; Iteration < Iterations; Iteration++) {
+        Routine->Copy(Destination, Source, Size);
+      }
+
+      return (ReadTimestampCounter() - Start);
+
+    } else {
+
+      Routine->Fill(Destination, 0xA5, Size);
+      uint64 Start = ReadTimestampCounter();
+
+      for (uint64 Iteration = 0; Iteration < Iterations; Iteration++) {
+        Routine->Fill(Destination, 0xA5, Size);
+      }
+
+      return (ReadTimestampCounter() - Start);
+
+    }
+
+  }
+
+  // (Show the throughput of a routine, in hundredths of a GB/s if we know
+  // the timestamp counter frequency, or hundredths of a byte per tick if
+  // we don't)
+
+  static void ShowThroughput(uint64 Bytes, uint64 Ticks, uint64 Frequency) {
+
+    if (Ticks == 0) {
+      Ticks = 1;
+    }
+
+    uint64 Throughput;
+
+    if (Frequency != 0) {
+      Throughput = ((Bytes * (Frequency / 10000000)) / Ticks);
+    } else {
+      Throughput = ((Bytes * 100) / Ticks);
+    }
+
+    Printf(" %d.%d%d", true, 0x0F, (Throughput / 100), ((Throughput / 10) % 10), (Throughput % 10));
+
+  }
+
+
+
+  // (Run every routine in `Routines` across each size and offset, and
+  // show one line per size and offset; routines the CPU doesn't support
+  // are left out entirely, and sizes a routine can't handle show `-`)
+
+  static void RunBenchmarkSweep(const char* Name, const memoryBenchmarkRoutine* Routines, uint8 NumRoutines, uint8* Destination, const uint8* Source, uint64 MaxSize, uint64 Frequency) {
+
+    // (Show which column belongs to which routine)
+
+    Message(Info, "Benchmarking %s routines, in %s:", Name, ((Frequency != 0) ? "GB/s" : "bytes per tick"));
+    Printf("  (Size, +Destination/+Source):", true, 0x07);
+
+    for (uint8 Index = 0; Index < NumRoutines; Index++) {
+
+      if (IsRoutineAvailable(&Routines[Index]) == true) {
+        Printf(" %s", true, 0x07, Routines[Index].Name);
+      }
+
+    }
+
+    Print("\n\r", true, 0x07);
+
+    // (Go through each size and offset, and time every routine that's
+    // available and can handle that size; `MaxSize` itself doesn't have
+    // to be a power of two, and is always the last size we try)
+
+    for (uint64 Step = 1; Step < (MaxSize * 2); Step *= 2) {
+
+      uint64 Size = ((Step > MaxSize) ? MaxSize : Step);
+      uint64 Iterations = GetBenchmarkIterations(Size);
+
+      for (uint8 Offset = 0; Offset < NumBenchmarkOffsets; Offset++) {
+
+        uint8 DestinationOffset = BenchmarkOffsets[Offset][0];
+        uint8 SourceOffset = BenchmarkOffsets[Offset][1];
+
+        if ((Routines[0].Fill != NULL) && (SourceOffset != 0)) {
+          continue;
+        }
+
+        Printf("  %d B, +%d/+%d:", true, 0x07, Size, (uint64)DestinationOffset, (uint64)SourceOffset);
+
+        for (uint8 Index = 0; Index < NumRoutines; Index++) {
+
+          if (IsRoutineAvailable(&Routines[Index]) == false) {
+            continue;
+          } else if (Size < Routines[Index].MinSize) {
+            Print(" -", true, 0x08);
+            continue;
+          }
+
+          uint64 Ticks = TimeRoutine(&Routines[Index], &Destination[DestinationOffset],
+                                     &Source[SourceOffset], Size, Iterations);
+
+          ShowThroughput((Size * Iterations), Ticks, Frequency);
+
+        }
+
+        Print("\n\r", true, 0x07);
+
+      }
+
+    }
+
+  }
+
+
+
+  /* void BenchmarkMemoryRoutines()
+
+     Inputs: (None)
+     Outputs: (None)
+
+     This function benchmarks every platform-specific Memcpy() and
+     Memset() routine that the CPU supports (plus Memcpy() and Memset()
+     themselves), for every power-of-two size from 1 byte to just under
+     64 MiB, and with a few different alignments, showing the results on
+     screen.
+
+     The buffers themselves are exactly 64 MiB (so the heap doesn't have
+     to round them up to the next power of two), which means the largest
+     size we try is 64 bytes smaller, to leave room for the offsets. If
+     there isn't enough memory for two 64 MiB buffers, the buffer size is
+     halved until there is.
+
+  */
+
+  void BenchmarkMemoryRoutines(void) {
+
+    // First, let's allocate our source and destination buffers; these
+    // are exactly `MaxSize` bytes long, since anything larger would be
+    // rounded up to twice the size.
+
+    uint64 MaxSize = MaxBenchmarkSize;
+    uintptr Length;
+
+    uint8* Destination = NULL;
+    uint8* Source = NULL;
+
+    while (MaxSize >= 0x10000) {
+
+      Length = MaxSize;
+
+      Destination = (uint8*)Allocate(&Length);
+      Source = (uint8*)Allocate(&Length);
+
+      if ((Destination != NULL) && (Source != NULL)) {
+        break;
+      }
+
+      if (Destination != NULL) {
+        [[maybe_unused]] bool Status = Free(Destination, &Length);
+      }
+
+      if (Source != NULL) {
+        [[maybe_unused]] bool Status = Free(Source, &Length);
+      }
+
+      Destination = NULL;
+      Source = NULL;
+
+      MaxSize /= 2;
+
+    }
+
+    if ((Destination == NULL) || (Source == NULL)) {
+      Message(Warning, "Couldn't allocate enough memory to benchmark memory routines.");
+      return;
+    }
+
+    Memset(Source, 0x5A, Length);
+    Memset(Destination, 0, Length);
+
+    // (Leave room for the largest offset in BenchmarkOffsets[], so every
+    // access stays within our buffers)
+
+    MaxSize -= 64;
+
+    // Now that we have our buffers, run both sweeps, and free our buffers.
+
+    uint64 Frequency = GetTimestampFrequency();
+
+    if (Frequency != 0) {
+      Message(Info, "Timestamp counter runs at %d MHz; benchmarking sizes up to %d KiB", (Frequency / 1000000), (MaxSize / 1024));
+    } else {
+      Message(Info, "Timestamp counter frequency is unknown; benchmarking sizes up to %d KiB", (MaxSize / 1024));
+    }
+
+    RunBenchmarkSweep("Memcpy()", CopyRoutines, NumCopyRoutines, Destination, Source, MaxSize, Frequency);
+    RunBenchmarkSweep("Memset()", FillRoutines, NumFillRoutines, Destination, Source, MaxSize, Frequency);
+
+    [[maybe_unused]] bool Status = Free(Destination, &Length);
+    Status = Free(Source, &Length);
+
+    return;
+
+  }
+
+#endif
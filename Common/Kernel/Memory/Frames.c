@@ -0,0 +1,497 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "../Libraries/Stdint.h"
+#include "../Libraries/String.h"
+#include "../System/System.h"
+#include "../../Common.h"
+#include "Memory.h"
+
+// Some things (framebuffer backbuffers, DMA rings, large decompression
+// buffers) need physically contiguous memory that's aligned to a large
+// page boundary - 2 MiB or even 1 GiB. Allocate() can technically do
+// that, but every request like that splits (and fragments) the heap.
+
+// Instead, this file implements a separate page frame allocator, which
+// takes memory from the heap in large, naturally aligned blocks (areas),
+// and hands out 4 KiB, 2 MiB and 1 GiB frames from them. It starts out
+// with a single 2 MiB area, and only takes more (each one twice as large
+// as the last, up to 1 GiB) once it runs out of frames of a given size,
+// so memory nobody asks for stays in the heap.
+// Each area keeps a bitmap of free 4 KiB frames, plus a summary of which
+// 2 MiB superframes are completely or partially free, so that finding a
+// frame of any size only needs to look at a few words.
+
+frameAllocatorData FrameAllocatorData = {0};
+
+
+
+// (Calculate the size of a frame of a given order)
+
+static inline uintptr GetFrameSize(frameOrder Order) {
+  return (SystemPageSize << (9 * Order));
+}
+
+
+
+// (Find the area that `Address` belongs to, or NULL if there isn't one)
+
+static inline frameArea* FindArea(uintptr Address) {
+
+  for (uint16 Index = 0; Index < FrameAllocatorData.NumAreas; Index++) {
+
+    frameArea* Area = &FrameAllocatorData.Areas[Index];
+
+    if ((Address >= Area->Base) && ((Address - Area->Base) < Area->Size)) {
+      return Area;
+    }
+
+  }
+
+  return NULL;
+
+}
+
+
+
+// (Check whether an area is a single 1 GiB frame that's completely free)
+
+static inline bool IsGigaframeFree(const frameArea* Area) {
+
+  return ((Area->NumSuperframes == SuperframesPerGigaframe)
+          && (Area->NumFullSuperframes == SuperframesPerGigaframe));
+
+}
+
+
+
+// (Update the number of free 4 KiB frames in a superframe, and keep the
+// summary bitmaps and FrameAllocatorData.NumFree[] in sync with it)
+
+static void SetSuperframeFree(frameArea* Area, uint32 Index, uint16 NumFree) {
+
+  uint16 OldNumFree = Area->SuperframeFree[Index];
+  bool WasGigaframeFree = IsGigaframeFree(Area);
+
+  uint64 Bit = (1ULL << (Index % 64));
+
+  Area->SuperframeFree[Index] = NumFree;
+  FrameAllocatorData.NumFree[FrameOrder_4KiB] += NumFree;
+  FrameAllocatorData.NumFree[FrameOrder_4KiB] -= OldNumFree;
+
+  // (Update the full and partial superframe bitmaps)
+
+  if (OldNumFree == FramesPerSuperframe) {
+
+    Area->FullSuperframes[Index / 64] &= ~Bit;
+    Area->NumFullSuperframes--;
+    FrameAllocatorData.NumFree[FrameOrder_2MiB]--;
+
+  } else if (OldNumFree != 0) {
+
+    Area->PartialSuperframes[Index / 64] &= ~Bit;
+
+  }
+
+  if (NumFree == FramesPerSuperframe) {
+
+    Area->FullSuperframes[Index / 64] |= Bit;
+    Area->NumFullSuperframes++;
+    FrameAllocatorData.NumFree[FrameOrder_2MiB]++;
+
+  } else if (NumFree != 0) {
+
+    Area->PartialSuperframes[Index / 64] |= Bit;
+
+  }
+
+  // (Update the number of free 1 GiB frames, if that changed)
+
+  bool IsNowGigaframeFree = IsGigaframeFree(Area);
+
+  if ((WasGigaframeFree == true) && (IsNowGigaframeFree == false)) {
+    FrameAllocatorData.NumFree[FrameOrder_1GiB]--;
+  } else if ((WasGigaframeFree == false) && (IsNowGigaframeFree == true)) {
+    FrameAllocatorData.NumFree[FrameOrder_1GiB]++;
+  }
+
+}
+
+
+
+// (Find the first set bit in a superframe summary bitmap, across every
+// area; if `AvoidGigaframes` is true, areas that are still a free 1 GiB
+// frame are skipped, so we don't break them up unless we have to)
+
+static bool FindSuperframe(bool Partial, bool AvoidGigaframes, frameArea** Area, uint32* Index) {
+
+  for (uint16 AreaIndex = 0; AreaIndex < FrameAllocatorData.NumAreas; AreaIndex++) {
+
+    frameArea* Candidate = &FrameAllocatorData.Areas[AreaIndex];
+
+    if ((AvoidGigaframes == true) && (IsGigaframeFree(Candidate) == true)) {
+      continue;
+    } else if ((Partial == false) && (Candidate->NumFullSuperframes == 0)) {
+      continue;
+    }
+
+    const uint64* Bitmap = ((Partial == true) ? Candidate->PartialSuperframes : Candidate->FullSuperframes);
+
+    for (uint32 Word = 0; Word < ((Candidate->NumSuperframes + 63) / 64); Word++) {
+
+      if (Bitmap[Word] != 0) {
+
+        *Area = Candidate;
+        *Index = ((Word * 64) + (uint32)__builtin_ctzll(Bitmap[Word]));
+
+        return true;
+
+      }
+
+    }
+
+  }
+
+  return false;
+
+}
+
+
+
+// (Take a new area of a given size from the heap, and add it to Areas[];
+// returns false if we couldn't allocate it, or its metadata)
+
+static bool AddFrameArea(uintptr Size) {
+
+  if (FrameAllocatorData.NumAreas >= MaxFrameAreas) {
+    return false;
+  }
+
+  void* Block = AllocateEx(&Size, Size, 0, AllocateFlag_None);
+
+  if (Block == NULL) {
+    return false;
+  }
+
+  // (Allocate space for this area's bitmaps, and lay them out)
+
+  uint32 NumSuperframes = (uint32)(Size / GetFrameSize(FrameOrder_2MiB));
+  uint32 NumSummaryWords = ((NumSuperframes + 63) / 64);
+
+  uintptr FramesSize = ((NumSuperframes * FramesPerSuperframe) / 8);
+  uintptr SummarySize = (NumSummaryWords * sizeof(uint64));
+
+  const uintptr MetadataSize = (FramesSize + (3 * SummarySize) + (NumSuperframes * sizeof(uint16)));
+  uint8* Metadata = (uint8*)AllocateSmall(&MetadataSize);
+
+  if (Metadata == NULL) {
+
+    [[maybe_unused]] bool Result = Free(Block, &Size);
+    return false;
+
+  }
+
+  Memset((void*)Metadata, 0, MetadataSize);
+
+  frameArea* Area = &FrameAllocatorData.Areas[FrameAllocatorData.NumAreas];
+
+  Area->Base = (uintptr)Block;
+  Area->Size = Size;
+
+  Area->Frames = (uint64*)Metadata;
+  Area->FullSuperframes = (uint64*)(Metadata + FramesSize);
+  Area->PartialSuperframes = (uint64*)(Metadata + FramesSize + SummarySize);
+  Area->WholeSuperframes = (uint64*)(Metadata + FramesSize + (2 * SummarySize));
+  Area->SuperframeFree = (uint16*)(Metadata + FramesSize + (3 * SummarySize));
+
+  Area->IsGigaframeAllocated = false;
+  Area->NumSuperframes = NumSuperframes;
+  Area->NumFullSuperframes = 0;
+
+  FrameAllocatorData.NumAreas++;
+  FrameAllocatorData.TotalSize += Size;
+
+  // (Mark every frame in this area as free)
+
+  Memset((void*)Area->Frames, 0xFF, FramesSize);
+
+  for (uint32 Index = 0; Index < NumSuperframes; Index++) {
+    SetSuperframeFree(Area, Index, FramesPerSuperframe);
+  }
+
+  return true;
+
+}
+
+
+
+// (Grow the frame allocator by one area, large enough to hold at least
+// one frame of the given order; areas double in size each time (up to 1
+// GiB), but we try smaller ones if the heap can't give us that much, and
+// we never take more than 1/FrameAllocatorShare of the heap in total)
+
+static bool GrowFrameAllocator(frameOrder Order) {
+
+  uintptr MinSize = GetFrameSize(Order);
+
+  if (MinSize < GetFrameSize(FrameOrder_2MiB)) {
+    MinSize = GetFrameSize(FrameOrder_2MiB);
+  }
+
+  uintptr Size = FrameAllocatorData.NextAreaSize;
+
+  if (Size < MinSize) {
+    Size = MinSize;
+  } else if (Size > GetFrameSize(FrameOrder_1GiB)) {
+    Size = GetFrameSize(FrameOrder_1GiB);
+  }
+
+  const uint64 MaxTotalSize = (MmSubsystemData.ManagedSize / FrameAllocatorShare);
+
+  for (; Size >= MinSize; Size >>= 1) {
+
+    if ((FrameAllocatorData.TotalSize + Size) > MaxTotalSize) {
+      continue;
+    } else if (AddFrameArea(Size) == false) {
+      continue;
+    }
+
+    FrameAllocatorData.NextAreaSize = (Size << 1);
+    return true;
+
+  }
+
+  return false;
+
+}
+
+
+
+// (Set up the frame allocator, with a single 2 MiB area to begin with;
+// more areas are added by AllocateFrame() as they're needed, so this
+// returns false if we couldn't even get that)
+
+bool InitializeFrameAllocator(void) {
+
+  if (MmSubsystemData.IsEnabled == false) {
+    return false;
+  }
+
+  FrameAllocatorData.NumAreas = 0;
+  FrameAllocatorData.TotalSize = 0;
+  FrameAllocatorData.NextAreaSize = GetFrameSize(FrameOrder_2MiB);
+
+  for (auto Order = 0; Order < NumFrameOrders; Order++) {
+    FrameAllocatorData.NumFree[Order] = 0;
+  }
+
+  [[maybe_unused]] bool Result = GrowFrameAllocator(FrameOrder_2MiB);
+
+  FrameAllocatorData.IsEnabled = (FrameAllocatorData.NumAreas != 0);
+  return FrameAllocatorData.IsEnabled;
+
+}
+
+
+
+// (Allocate a single frame of a given order, aligned to its own size;
+// returns NULL if there aren't any left)
+
+[[nodiscard]] void* AllocateFrame(frameOrder Order) {
+
+  if (FrameAllocatorData.IsEnabled == false) {
+    return NULL;
+  } else if (Order >= NumFrameOrders) {
+    return NULL;
+  }
+
+  // (If we don't have any frames of this size left, try to take another
+  // area from the heap first)
+
+  if (FrameAllocatorData.NumFree[Order] == 0) {
+
+    if (GrowFrameAllocator(Order) == false) {
+      return NULL;
+    }
+
+  }
+
+  frameArea* Area = NULL;
+  uint32 Index = 0;
+
+  // If we need a 1 GiB frame, then we need an area that's completely
+  // free, and that's exactly 1 GiB long.
+
+  if (Order == FrameOrder_1GiB) {
+
+    for (uint16 AreaIndex = 0; AreaIndex < FrameAllocatorData.NumAreas; AreaIndex++) {
+
+      Area = &FrameAllocatorData.Areas[AreaIndex];
+
+      if (IsGigaframeFree(Area) == true) {
+        break;
+      }
+
+    }
+
+    Memset((void*)Area->Frames, 0, ((Area->NumSuperframes * FramesPerSuperframe) / 8));
+
+    for (Index = 0; Index < Area->NumSuperframes; Index++) {
+      SetSuperframeFree(Area, Index, 0);
+    }
+
+    Area->IsGigaframeAllocated = true;
+    return (void*)Area->Base;
+
+  }
+
+  // If we need a 2 MiB frame, then we need a superframe that's completely
+  // free (preferably one that isn't part of a free 1 GiB frame).
+
+  if (Order == FrameOrder_2MiB) {
+
+    if (FindSuperframe(false, true, &Area, &Index) == false) {
+      [[maybe_unused]] bool Result = FindSuperframe(false, false, &Area, &Index);
+    }
+
+    Memset((void*)&Area->Frames[Index * (FramesPerSuperframe / 64)], 0, (FramesPerSuperframe / 8));
+    SetSuperframeFree(Area, Index, 0);
+
+    Area->WholeSuperframes[Index / 64] |= (1ULL << (Index % 64));
+    return (void*)(Area->Base + (Index * GetFrameSize(FrameOrder_2MiB)));
+
+  }
+
+  // Otherwise, we need a 4 KiB frame, which should come from a superframe
+  // that's already partially used if possible, so we don't break up any
+  // more superframes than we need to.
+
+  if (FindSuperframe(true, false, &Area, &Index) == false) {
+
+    if (FindSuperframe(false, true, &Area, &Index) == false) {
+      [[maybe_unused]] bool Result = FindSuperframe(false, false, &Area, &Index);
+    }
+
+  }
+
+  uint64* Words = &Area->Frames[Index * (FramesPerSuperframe / 64)];
+
+  for (uint32 Word = 0; Word < (FramesPerSuperframe / 64); Word++) {
+
+    if (Words[Word] != 0) {
+
+      uint32 Bit = (uint32)__builtin_ctzll(Words[Word]);
+
+      Words[Word] &= ~(1ULL << Bit);
+      SetSuperframeFree(Area, Index, (Area->SuperframeFree[Index] - 1));
+
+      uint32 Frame = ((Index * FramesPerSuperframe) + (Word * 64) + Bit);
+      return (void*)(Area->Base + (Frame * GetFrameSize(FrameOrder_4KiB)));
+
+    }
+
+  }
+
+  return NULL;
+
+}
+
+
+
+// (Free a frame from AllocateFrame(); `Order` must be the same value that
+// was used to allocate it, and returns false if the frame isn't in use, or
+// if it was allocated with a different order)
+
+[[nodiscard]] bool FreeFrame(void* Frame, frameOrder Order) {
+
+  if (FrameAllocatorData.IsEnabled == false) {
+    return false;
+  } else if ((Frame == NULL) || (Order >= NumFrameOrders)) {
+    return false;
+  }
+
+  // First, let's figure out which area `Frame` belongs to, and make sure
+  // that it's aligned and fits.
+
+  uintptr Address = (uintptr)Frame;
+  frameArea* Area = FindArea(Address);
+
+  if (Area == NULL) {
+    return false;
+  } else if ((Address % GetFrameSize(Order)) != 0) {
+    return false;
+  } else if ((Area->Size - (Address - Area->Base)) < GetFrameSize(Order)) {
+    return false;
+  }
+
+  uint32 Index = (uint32)((Address - Area->Base) / GetFrameSize(FrameOrder_2MiB));
+
+  // (Make sure the frame was actually allocated with this order, and not
+  // as part of a larger (or smaller) frame)
+
+  uint64 WholeBit = (1ULL << (Index % 64));
+  bool IsWholeSuperframe = ((Area->WholeSuperframes[Index / 64] & WholeBit) != 0);
+
+  if (Order == FrameOrder_1GiB) {
+
+    if (Area->IsGigaframeAllocated == false) {
+      return false;
+    }
+
+  } else if (Area->IsGigaframeAllocated == true) {
+
+    return false;
+
+  } else if (IsWholeSuperframe != (Order == FrameOrder_2MiB)) {
+
+    return false;
+
+  }
+
+  // (Free a single 4 KiB frame)
+
+  if (Order == FrameOrder_4KiB) {
+
+    uint32 FrameIndex = (uint32)((Address - Area->Base) / GetFrameSize(FrameOrder_4KiB));
+    uint64 Bit = (1ULL << (FrameIndex % 64));
+
+    if ((Area->Frames[FrameIndex / 64] & Bit) != 0) {
+      return false;
+    }
+
+    Area->Frames[FrameIndex / 64] |= Bit;
+    SetSuperframeFree(Area, Index, (Area->SuperframeFree[Index] + 1));
+
+    return true;
+
+  }
+
+  // (Free one or more entire superframes, as long as they're fully used)
+
+  uint32 NumSuperframes = ((Order == FrameOrder_1GiB) ? SuperframesPerGigaframe : 1);
+
+  for (uint32 Superframe = Index; Superframe < (Index + NumSuperframes); Superframe++) {
+
+    if (Area->SuperframeFree[Superframe] != 0) {
+      return false;
+    }
+
+  }
+
+  for (uint32 Superframe = Index; Superframe < (Index + NumSuperframes); Superframe++) {
+
+    Memset((void*)&Area->Frames[Superframe * (FramesPerSuperframe / 64)], 0xFF, (FramesPerSuperframe / 8));
+    SetSuperframeFree(Area, Superframe, FramesPerSuperframe);
+
+  }
+
+  if (Order == FrameOrder_1GiB) {
+    Area->IsGigaframeAllocated = false;
+  } else {
+    Area->WholeSuperframes[Index / 64] &= ~WholeBit;
+  }
+
+  return true;
+
+}
@@ -6,6 +6,351 @@
 #include "../System/System.h"
 #include "Memory.h"
 
+// (TODO - Write documentation)
+// [Platform-specific memory functions - for x64 (AMD64 / Intel 64)]
+
+#if defined(__amd64__) || defined(__x86_64__)
+
+  // Optimized Memcmp() functions for x64 platforms, from x64/Memcmp.asm
+
+  extern int Memcmp_Sse2(const void* BufferA, const void* BufferB, uint64 Size);
+  extern int Memcmp_Avx2(const void* BufferA, const void* BufferB, uint64 Size);
+  extern int Memcmp_Avx512bw(const void* BufferA, const void* BufferB, uint64 Size);
+
+  // Optimized Memcpy() functions for x64 platforms, from x64/Memcpy.asm
+
+  extern void Memcpy_RepMovsb(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Sse2(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Avx(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Avx512f(void* Destination, const void* Source, uint64 Size);
+
+  extern void Memcpy_Sse2Temporal(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_AvxTemporal(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Avx2Temporal(void* Destination, const void* Source, uint64 Size);
+  extern void Memcpy_Avx512fTemporal(void* Destination, const void* Source, uint64 Size);
+
+  // Optimized Memmove() functions for x64 platforms, from x64/Memmove.asm
+
+  extern void Memmove_Sse2(void* Destination, const void* Source, uint64 Size);
+  extern void Memmove_Avx(void* Destination, const void* Source, uint64 Size);
+  extern void Memmove_Avx512f(void* Destination, const void* Source, uint64 Size);
+
+  // Optimized Memset() functions for x64 platforms, from x64/Memset.asm
+
+  extern void Memset_RepStosb(void* Buffer, uint8 Value, uint64 Size);
+  extern void Memset_Sse2(void* Buffer, uint8 Value, uint64 Size);
+  extern void Memset_Avx(void* Buffer, uint8 Value, uint64 Size);
+  extern void Memset_Avx2(void* Buffer, uint8 Value, uint64 Size);
+  extern void Memset_Avx512f(void* Buffer, uint8 Value, uint64 Size);
+
+  extern void Memset_NonTemporal(void* Buffer, uint8 Value, uint64 Size);
+
+  extern void MemsetPattern_Sse2(void* Buffer, const void* Lane, uint64 Size);
+  extern void MemsetPattern_Avx(void* Buffer, const void* Lane, uint64 Size);
+  extern void MemsetPattern_Avx512f(void* Buffer, const void* Lane, uint64 Size);
+
+  // (Copies and fills smaller than this always use SIMD registers, rather
+  // than `rep movsb` or `rep stosb`, even on ERMS systems, since those have
+  // a fairly large startup cost; this is also the large size class's
+  // threshold if we don't know the size of the L2 cache)
+
+  #define RepMovsbThreshold 2048
+
+#endif
+
+
+
+/* memoryDispatchTable MemoryDispatchTable{}
+
+   Members: (See definition in Memory.h)
+
+   A table of the platform-specific routines that Memcpy(), Memset(),
+   Memmove() and Memcmp() use, for each size class; this is set up once
+   by InitializeMemoryDispatchTable(), so those functions don't need to
+   check which CPU features are available on every call.
+
+   Until then, it uses SSE2 routines (which every x64 processor supports),
+   along with a reasonable default for the non-temporal threshold.
+
+*/
+
+#if defined(__amd64__) || defined(__x86_64__)
+
+  memoryDispatchTable MemoryDispatchTable = {
+
+    .Memcpy = {Memcpy_Sse2Temporal, Memcpy_Sse2Temporal, Memcpy_Sse2},
+    .Memset = {Memset_Sse2, Memset_Sse2, Memset_NonTemporal},
+    .Memmove = Memmove_Sse2,
+    .Memcmp = {Memcmp_Sse2, Memcmp_Sse2, Memcmp_Sse2},
+
+    .MemsetPattern = MemsetPattern_Sse2,
+    .PatternLaneSize = 48,
+
+    .LargeThreshold = RepMovsbThreshold,
+    .HugeThreshold = DefaultNonTemporalThreshold
+
+  };
+
+#else
+
+  memoryDispatchTable MemoryDispatchTable = {0};
+
+#endif
+
+
+
+/* void InitializeMemoryDispatchTable(void)
+
+   Inputs: (none)
+   Outputs: (modifies MemoryDispatchTable{})
+
+   This function decides which platform-specific routines Memcpy(),
+   Memset(), Memmove() and Memcmp() should use, based on the features
+   in CpuFeaturesAvailable{} and the cache sizes in CpuCacheInfo{}; it's
+   called at the end of InitializeCpuFeatures(), and shouldn't need to
+   be called anywhere else.
+
+*/
+
+void InitializeMemoryDispatchTable(void) {
+
+  #if defined(__amd64__) || defined(__x86_64__)
+
+    // First, let's pick the widest SIMD routines the CPU supports, for
+    // copies that fit in the cache (Temporal), copies that don't
+    // (NonTemporal), fills, and overlapping moves.
+
+    // (AVX2 has its own copy and fill routines, but uses the same non-
+    // temporal and overlapping routines as AVX)
+
+    memoryCopyFunction Temporal = Memcpy_Sse2Temporal;
+    memoryCopyFunction NonTemporal = Memcpy_Sse2;
+    memoryFillFunction Fill = Memset_Sse2;
+    memoryCopyFunction Move = Memmove_Sse2;
+
+    if (CpuFeaturesAvailable.Avx512f == true) {
+
+      Temporal = Memcpy_Avx512fTemporal;
+      NonTemporal = Memcpy_Avx512f;
+      Fill = Memset_Avx512f;
+      Move = Memmove_Avx512f;
+
+    } else if (CpuFeaturesAvailable.Avx2 == true) {
+
+      Temporal = Memcpy_Avx2Temporal;
+      NonTemporal = Memcpy_Avx;
+      Fill = Memset_Avx2;
+      Move = Memmove_Avx;
+
+    } else if (CpuFeaturesAvailable.Avx == true) {
+
+      Temporal = Memcpy_AvxTemporal;
+      NonTemporal = Memcpy_Avx;
+      Fill = Memset_Avx;
+      Move = Memmove_Avx;
+
+    }
+
+    // Next, fill out the table itself; on ERMS systems, `rep movsb` and
+    // `rep stosb` are used for anything in the large size class.
+
+    MemoryDispatchTable.Memcpy[MemorySizeClass_Medium] = Temporal;
+    MemoryDispatchTable.Memcpy[MemorySizeClass_Large] = ((CpuFeaturesAvailable.Erms == true) ? Memcpy_RepMovsb : Temporal);
+    MemoryDispatchTable.Memcpy[MemorySizeClass_Huge] = NonTemporal;
+
+    MemoryDispatchTable.Memset[MemorySizeClass_Medium] = Fill;
+    MemoryDispatchTable.Memset[MemorySizeClass_Large] = ((CpuFeaturesAvailable.Erms == true) ? Memset_RepStosb : Fill);
+    MemoryDispatchTable.Memset[MemorySizeClass_Huge] = Memset_NonTemporal;
+
+    MemoryDispatchTable.Memmove = Move;
+
+    // (Memcmp() uses a different routine depending on whether there's at
+    // least 16, 32 or 64 bytes to compare, since each routine needs at
+    // least one full vector)
+
+    MemoryDispatchTable.Memcmp[0] = Memcmp_Sse2;
+    MemoryDispatchTable.Memcmp[1] = ((CpuFeaturesAvailable.Avx2 == true) ? Memcmp_Avx2 : Memcmp_Sse2);
+    MemoryDispatchTable.Memcmp[2] = ((CpuFeaturesAvailable.Avx512bw == true) ? Memcmp_Avx512bw : MemoryDispatchTable.Memcmp[1]);
+
+    // (MemsetBlock() repeats a lane that's three vectors long, so the
+    // lane size depends on which routine we use)
+
+    if (CpuFeaturesAvailable.Avx512f == true) {
+
+      MemoryDispatchTable.MemsetPattern = MemsetPattern_Avx512f;
+      MemoryDispatchTable.PatternLaneSize = 192;
+
+    } else if (CpuFeaturesAvailable.Avx == true) {
+
+      MemoryDispatchTable.MemsetPattern = MemsetPattern_Avx;
+      MemoryDispatchTable.PatternLaneSize = 96;
+
+    } else {
+
+      MemoryDispatchTable.MemsetPattern = MemsetPattern_Sse2;
+      MemoryDispatchTable.PatternLaneSize = 48;
+
+    }
+
+    // Finally, set the thresholds between each size class, based on the
+    // cache sizes from DetectCacheTopology().
+
+    // (As long as both the source and destination fit in the L2 cache,
+    // regular SIMD stores are about as fast as it gets, and they keep the
+    // data close by for whatever reads it next; past that, we switch to
+    // `rep movsb` and `rep stosb` (on ERMS systems), and then to non-
+    // temporal stores once we'd evict most of the last-level cache)
+
+    uintptr LargeThreshold = RepMovsbThreshold;
+    uintptr HugeThreshold = CpuCacheInfo.NonTemporalThreshold;
+
+    if ((CpuCacheInfo.L2Size / 2) > LargeThreshold) {
+      LargeThreshold = (CpuCacheInfo.L2Size / 2);
+    }
+
+    if (LargeThreshold > HugeThreshold) {
+      LargeThreshold = HugeThreshold;
+    }
+
+    MemoryDispatchTable.LargeThreshold = LargeThreshold;
+    MemoryDispatchTable.HugeThreshold = HugeThreshold;
+
+  #endif
+
+  return;
+
+}
+
+
+
+// (Calculate the size class of a copy or fill, for anything at least 64
+// bytes long; see MemoryDispatchTable{})
+
+static inline memorySizeClass GetSizeClass(uintptr Size) {
+
+  return (memorySizeClass)((Size >= MemoryDispatchTable.LargeThreshold)
+                           + (Size >= MemoryDispatchTable.HugeThreshold));
+
+}
+
+
+
+// (Copy less than 64 bytes inline, using a few overlapping loads and
+// stores; everything is loaded before anything is stored, so this also
+// works for overlapping areas)
+
+typedef struct _smallBlock {
+  uint64 Data[2];
+} smallBlock;
+
+static inline void CopySmall(void* Destination, const void* Source, uintptr Size) {
+
+  uint8* To = (uint8*)Destination;
+  const uint8* From = (const uint8*)Source;
+
+  if (Size >= 32) {
+
+    smallBlock A, B, C, D;
+
+    __builtin_memcpy(&A, From, 16);
+    __builtin_memcpy(&B, (From + 16), 16);
+    __builtin_memcpy(&C, (From + Size - 32), 16);
+    __builtin_memcpy(&D, (From + Size - 16), 16);
+
+    __builtin_memcpy(To, &A, 16);
+    __builtin_memcpy((To + 16), &B, 16);
+    __builtin_memcpy((To + Size - 32), &C, 16);
+    __builtin_memcpy((To + Size - 16), &D, 16);
+
+  } else if (Size >= 16) {
+
+    smallBlock A, B;
+
+    __builtin_memcpy(&A, From, 16);
+    __builtin_memcpy(&B, (From + Size - 16), 16);
+
+    __builtin_memcpy(To, &A, 16);
+    __builtin_memcpy((To + Size - 16), &B, 16);
+
+  } else if (Size >= 8) {
+
+    uint64 A, B;
+
+    __builtin_memcpy(&A, From, 8);
+    __builtin_memcpy(&B, (From + Size - 8), 8);
+
+    __builtin_memcpy(To, &A, 8);
+    __builtin_memcpy((To + Size - 8), &B, 8);
+
+  } else if (Size >= 4) {
+
+    uint32 A, B;
+
+    __builtin_memcpy(&A, From, 4);
+    __builtin_memcpy(&B, (From + Size - 4), 4);
+
+    __builtin_memcpy(To, &A, 4);
+    __builtin_memcpy((To + Size - 4), &B, 4);
+
+  } else if (Size != 0) {
+
+    uint8 A = From[0];
+    uint8 B = From[Size / 2];
+    uint8 C = From[Size - 1];
+
+    To[0] = A;
+    To[Size / 2] = B;
+    To[Size - 1] = C;
+
+  }
+
+}
+
+
+
+// (Fill less than 64 bytes inline, in the same way as CopySmall())
+
+static inline void FillSmall(void* Buffer, uint8 Value, uintptr Size) {
+
+  uint8* To = (uint8*)Buffer;
+  uint64 Pattern = (0x0101010101010101ULL * Value);
+
+  if (Size >= 16) {
+
+    smallBlock A = {{Pattern, Pattern}};
+
+    __builtin_memcpy(To, &A, 16);
+    __builtin_memcpy((To + Size - 16), &A, 16);
+
+    if (Size > 32) {
+
+      __builtin_memcpy((To + 16), &A, 16);
+      __builtin_memcpy((To + Size - 32), &A, 16);
+
+    }
+
+  } else if (Size >= 8) {
+
+    __builtin_memcpy(To, &Pattern, 8);
+    __builtin_memcpy((To + Size - 8), &Pattern, 8);
+
+  } else if (Size >= 4) {
+
+    __builtin_memcpy(To, &Pattern, 4);
+    __builtin_memcpy((To + Size - 4), &Pattern, 4);
+
+  } else if (Size != 0) {
+
+    To[0] = Value;
+    To[Size / 2] = Value;
+    To[Size - 1] = Value;
+
+  }
+
+}
+
+
+
 /* int Memcmp(), memcmp()
 
    Inputs: const void* BufferA - The first buffer you want to compare.
@@ -19,19 +364,33 @@
    -1 or +1, depending on the first differing byte).
 
    The main use of this function is to compare variables and memory areas
-   that can't be directly compared with the == operator, like UUIDs;
-   for example:
+   that can't be directly compared with the == operator, like signatures
+   or file names; for example:
 
-   -> bool UuidIsEqual = Memcmp(&Uuid1, &Uuid2, sizeof(genericUuid));
+   -> bool IsEqual = (Memcmp(Signature, "EFI PART", 8) == 0);
 
-   Please keep in mind that this function is quite slow, since it only
-   compares one byte at a time - unlike Memcpy() and Memset(), it
-   doesn't use hardware-optimized implementations.
+   On x64 platforms, anything at least 16 bytes long is compared with
+   SSE2, AVX2 or AVX-512 (depending on what's supported), which compare
+   an entire vector at a time; anything smaller is compared one byte
+   at a time, since it isn't worth calling into Assembly for that.
+
+   (If you just want to compare two UUIDs, use UuidsAreEqual() instead,
+   which is inlined, and doesn't need to call this at all)
 
 */
 
 int Memcmp(const void* BufferA, const void* BufferB, uintptr Size) {
 
+  // (Use the platform-specific routines for larger buffers)
+
+  #if defined(__amd64__) || defined(__x86_64__)
+
+    if (Size >= 16) {
+      return MemoryDispatchTable.Memcmp[(Size >= 32) + (Size >= 64)](BufferA, BufferB, Size);
+    }
+
+  #endif
+
   // Translate each const void* pointer into a const uint8* pointer.
 
   const uint8* ArrayA = (const uint8*)BufferA;
@@ -64,29 +423,6 @@ int memcmp(const void* BufferA, const void* BufferB, uintptr Size) {
 
 
 
-// (TODO - Write documentation)
-// [Platform-specific Memcpy - for x64 (AMD64 / Intel 64)]
-
-#if defined(__amd64__) || defined(__x86_64__)
-
-  // Optimized Memcpy() functions for x64 platforms, from x64/Memcpy.asm
-
-  extern void Memcpy_RepMovsb(void* Destination, const void* Source, uint64 Size);
-  extern void Memcpy_Sse2(void* Destination, const void* Source, uint64 Size);
-  extern void Memcpy_Avx(void* Destination, const void* Source, uint64 Size);
-  extern void Memcpy_Avx512f(void* Destination, const void* Source, uint64 Size);
-
-  // Optimized Memset() functions for x64 platforms, from x64/Memset.asm
-
-  extern void Memset_RepStosb(void* Buffer, uint8 Value, uint64 Size);
-  extern void Memset_Sse2(void* Buffer, uint8 Value, uint64 Size);
-  extern void Memset_Avx(void* Buffer, uint8 Value, uint64 Size);
-  extern void Memset_Avx512f(void* Buffer, uint8 Value, uint64 Size);
-
-#endif
-
-
-
 /* void Memcpy(), void* memcpy()
 
    Inputs: void* Destination - The memory area you want to copy data to.
@@ -118,23 +454,22 @@ void Memcpy(void* Destination, const void* Source, uintptr Size) {
 
     // (Routines specific to x64 platforms)
 
-    // We take into account feature support, as well as size; in this
-    // case, ERMS systems always use `rep movsb`)
+    // We take into account feature support, as well as size:
 
-    if ((Size < 64) || (CpuFeaturesAvailable.Erms == true)) {
+    // -> Very small copies are done inline, with a few overlapping loads
+    // and stores, since calling into Assembly would take longer;
+    // -> Copies that fit in the cache use regular (temporal) stores,
+    // either with SIMD registers or with `rep movsb` on ERMS systems;
+    // -> Copies too large to fit in the last-level cache use
+    // non-temporal stores, so they don't evict everything else.
 
-      Memcpy_RepMovsb(Destination, Source, Size);
+    // (Which routine we use for each size class was already decided by
+    // InitializeMemoryDispatchTable(), so we don't check for it here)
 
+    if (Size < 64) {
+      CopySmall(Destination, Source, Size);
     } else {
-
-      if (CpuFeaturesAvailable.Avx512f == true) {
-        Memcpy_Avx512f(Destination, Source, Size);
-      } else if (CpuFeaturesAvailable.Avx == true) {
-        Memcpy_Avx(Destination, Source, Size);
-      } else {
-        Memcpy_Sse2(Destination, Source, Size);
-      }
-
+      MemoryDispatchTable.Memcpy[GetSizeClass(Size)](Destination, Source, Size);
     }
 
   #else
@@ -175,11 +510,17 @@ void* memcpy(void* Destination, const void* Source, uintptr Size) {
            const void* Source - The memory area you want to move data from.
            uintptr Size - The size of both memory areas, in bytes.
 
-   (TODO - Something about memmove; this is essentially just a memcpy
-   that can deal with overlapping areas.)
+   Outputs: (None, or value of `Destination`)
+
+   This function copies a certain amount of data (`Size` bytes) from one
+   memory area (Source) to another (Destination), like Memcpy(), except
+   that both areas are allowed to overlap.
 
-   (TODO - Something about using memcpy if the difference is large
-   enough for it not to crash; this *could absolutely be an issue*)
+   If the two areas don't overlap at all, then this just calls Memcpy();
+   otherwise, it copies data front-to-back (if Destination comes before
+   Source) or back-to-front (if it comes after), using platform-specific
+   routines that read each block into registers before writing it back,
+   so even areas that are only a few bytes apart are copied correctly.
 
    (TODO - Something about GCC's insistence on memmove())
 
@@ -187,43 +528,58 @@ void* memcpy(void* Destination, const void* Source, uintptr Size) {
 
 void Memmove(void* Destination, const void* Source, uintptr Size) {
 
-  // (Manually copy each byte from `Source` to `Destination`)
+  // (If both areas are the same, or if they don't overlap at all, then
+  // we don't need to do anything special)
 
-  // If our destination buffer comes *before* our source buffer, then
-  // we need to copy each byte back-to-front, not front-to-back.
+  uintptr Distance = (((uintptr)Destination > (uintptr)Source)
+                     ? ((uintptr)Destination - (uintptr)Source)
+                     : ((uintptr)Source - (uintptr)Destination));
 
-  uint8* SourceByte = (uint8*)Source;
-  uint8* DestinationByte = (uint8*)Destination;
+  if ((Distance == 0) || (Size == 0)) {
+    return;
+  } else if (Distance >= Size) {
+    Memcpy(Destination, Source, Size);
+    return;
+  }
 
-  if (Destination < Source) {
+  #if defined(__amd64__) || defined(__x86_64__)
 
-    if (((uintptr)Source - (uintptr)Destination) < 64) {
+    // (Routines specific to x64 platforms)
 
-      for (uintptr Index = 0; Index < Size; Index++) {
-        DestinationByte[Index] = SourceByte[Index];
-      }
+    // (CopySmall() loads everything before storing any of it, so it's
+    // safe to use for overlapping areas as well)
 
+    if (Size < 64) {
+      CopySmall(Destination, Source, Size);
     } else {
+      MemoryDispatchTable.Memmove(Destination, Source, Size);
+    }
 
-      Memcpy(Destination, Source, Size); // (TODO - Might be an issue)
+  #else
 
-    }
+    // (Routines for other platforms)
 
-  } else {
+    // If our destination buffer comes *after* our source buffer, then
+    // we need to copy each byte back-to-front, not front-to-back.
 
-    if (((uintptr)Destination - (uintptr)Source) < 64) {
+    const uint8* SourceByte = (const uint8*)Source;
+    uint8* DestinationByte = (uint8*)Destination;
 
-      for (uintptr Index = Size; Index > 0; Index--) {
-        DestinationByte[Index-1] = SourceByte[Index-1];
+    if ((uintptr)Destination < (uintptr)Source) {
+
+      for (uintptr Index = 0; Index < Size; Index++) {
+        DestinationByte[Index] = SourceByte[Index];
       }
 
     } else {
 
-      Memcpy(Destination, Source, Size); // (TODO - Might be an issue)
+      for (uintptr Index = Size; Index > 0; Index--) {
+        DestinationByte[Index-1] = SourceByte[Index-1];
+      }
 
     }
 
-  }
+  #endif
 
   // Now that we're done, we can return.
 
@@ -265,23 +621,15 @@ void Memset(void* Buffer, uint8 Character, uintptr Size) {
 
     // (Routines specific to x64 platforms)
 
-    // We take into account feature support, as well as size; in this
-    // case, ERMS systems always use `rep stosb`)
-
-    if ((Size < 64) || (CpuFeaturesAvailable.Erms == true)) {
-
-      Memset_RepStosb(Buffer, Character, Size);
+    // We take into account feature support, as well as size, in the
+    // same way as Memcpy() - fills too large to fit in the last-level
+    // cache use non-temporal stores, and everything else uses regular
+    // stores (with `rep stosb` for larger fills on ERMS systems).
 
+    if (Size < 64) {
+      FillSmall(Buffer, Character, Size);
     } else {
-
-      if (CpuFeaturesAvailable.Avx512f == true) {
-        Memset_Avx512f(Buffer, Character, Size);
-      } else if (CpuFeaturesAvailable.Avx == true) {
-        Memset_Avx(Buffer, Character, Size);
-      } else {
-        Memset_Sse2(Buffer, Character, Size);
-      }
-
+      MemoryDispatchTable.Memset[GetSizeClass(Size)](Buffer, Character, Size);
     }
 
   #else
@@ -315,6 +663,29 @@ void* memset(void* Buffer, int Value, uintptr Size) {
 
 
 
+// (Copy `Count` bytes of a repeating pattern to `Destination`, starting
+// at byte `Phase` of the block; returns the phase we stopped at, so the
+// pattern can be continued later on)
+
+static inline uintptr CopyPatternBytes(uint8* Destination, uintptr Count, const uint8* Block, uintptr BlockSize, uintptr Phase) {
+
+  for (uintptr Index = 0; Index < Count; Index++) {
+
+    Destination[Index] = Block[Phase];
+    Phase++;
+
+    if (Phase == BlockSize) {
+      Phase = 0;
+    }
+
+  }
+
+  return Phase;
+
+}
+
+
+
 /* void MemsetBlock()
 
    Inputs: void* Buffer - The buffer you want to write to.
@@ -324,74 +695,136 @@ void* memset(void* Buffer, int Value, uintptr Size) {
 
    Outputs: (None)
 
-   (TODO: This is essentially Memset(), but for values (or 'blocks')
-   larger than one byte)
+   This is essentially Memset(), but for values (or 'blocks') larger
+   than one byte, like pixels; exactly `Size` bytes are written, so if
+   `Size` isn't a multiple of `BlockSize`, the last block is cut short.
+
+   On x64 systems, this builds a 'lane' of three vectors (48, 96 or 192
+   bytes, depending on MemoryDispatchTable{}) that's filled with the
+   pattern, and repeats that with SIMD stores; since three vectors always
+   hold a whole number of 2, 3, 4 or 8-byte blocks, this covers every
+   common pixel format. 2, 4 and 8-byte blocks are broadcast 8 bytes at
+   a time, whereas anything else (like 3-byte pixels) is copied once and
+   then doubled until it fills the lane.
 
-   (TODO: Something about block-size-specific optimizations)
+   Anything that's too small (or that doesn't fit evenly in a lane) is
+   filled one block at a time instead.
 
 */
 
+#define MaxPatternLaneSize 192
+
 void MemsetBlock(void* Buffer, const void* Block, uintptr Size, uintptr BlockSize) {
 
-  // (Routines for block sizes between 1 and 8 bytes)
-  // (TODO - This could be optimized further..)
+  // (If our block is a single byte, we can just use Memset())
+
+  if (BlockSize <= 1) {
+
+    Memset(Buffer, *(const uint8*)Block, Size);
+    return;
+
+  }
 
   uintptr Destination = (uintptr)Buffer;
   uintptr Threshold = (Destination + Size);
 
-  if (BlockSize <= 1) {
+  #if defined(__amd64__) || defined(__x86_64__)
 
-    // (Use Memset to fill everything in one go.)
+    // (Routines for x64 platforms)
 
-    Memset(Buffer, *(uint8*)Block, Size);
+    // First, let's see if our block fits evenly in a lane, and whether
+    // there's enough data to make building one worth it.
 
-  } else if (BlockSize <= 2) {
+    const uintptr LaneSize = MemoryDispatchTable.PatternLaneSize;
 
-    // (Manually fill 2 bytes at a time.)
+    if ((Size >= (LaneSize * 2)) && ((LaneSize % BlockSize) == 0)) {
 
-    while (Destination < Threshold) {
+      // Fill everything up to the next vector boundary manually, so the
+      // lane can be stored with aligned stores, and keep track of how
+      // far into the pattern that leaves us (in `Phase`).
 
-      *(uint16*)Destination = *(uint16*)Block;
-      Destination += BlockSize;
+      const uintptr VectorSize = (LaneSize / 3);
+      const uintptr Head = ((VectorSize - (Destination % VectorSize)) % VectorSize);
 
-    }
+      uintptr Phase = CopyPatternBytes((uint8*)Destination, Head, (const uint8*)Block, BlockSize, 0);
+      Destination += Head;
 
-  } else if (BlockSize <= 4) {
+      // Next, build the lane (starting from `Phase`), and have the SIMD
+      // routine repeat it over the rest of the buffer.
 
-    // (Manually fill 4 bytes at a time.)
+      // (2, 4 and 8-byte blocks are broadcast to every 8-byte word in the
+      // lane, which is always a multiple of 8 bytes)
 
-    while (Destination < Threshold) {
+      uint8 Lane[MaxPatternLaneSize];
 
-      *(uint32*)Destination = *(uint32*)Block;
-      Destination += BlockSize;
+      if ((BlockSize <= 8) && ((BlockSize & (BlockSize - 1)) == 0)) {
+
+        uint64 Pattern;
+        CopyPatternBytes((uint8*)&Pattern, sizeof(Pattern), (const uint8*)Block, BlockSize, Phase);
+
+        for (uintptr Offset = 0; Offset < LaneSize; Offset += sizeof(Pattern)) {
+          __builtin_memcpy(&Lane[Offset], &Pattern, sizeof(Pattern));
+        }
+
+      } else {
+
+        // (Otherwise, copy one block, and keep doubling it until it
+        // fills the whole lane)
+
+        CopyPatternBytes(Lane, BlockSize, (const uint8*)Block, BlockSize, Phase);
+
+        for (uintptr Filled = BlockSize; Filled < LaneSize; Filled *= 2) {
+          Memcpy(&Lane[Filled], Lane, (((LaneSize - Filled) < Filled) ? (LaneSize - Filled) : Filled));
+        }
+
+      }
+
+      MemoryDispatchTable.MemsetPattern((void*)Destination, (const void*)Lane, (Threshold - Destination));
+      return;
 
     }
 
-  } else if (BlockSize <= 8) {
+  #endif
 
-    // (Manually fill 8 bytes at a time.)
+  // (Routines for small buffers, or for other platforms)
 
-    while (Destination < Threshold) {
+  // Fill as many whole blocks as we can, using a single store for 2, 4
+  // and 8-byte blocks, and Memcpy() for anything else.
 
-      *(uint64*)Destination = *(uint64*)Block;
-      Destination += BlockSize;
+  if (BlockSize == 2) {
 
+    while ((Threshold - Destination) >= 2) {
+      __builtin_memcpy((void*)Destination, Block, 2);
+      Destination += 2;
     }
 
-  } else {
+  } else if (BlockSize == 4) {
 
-    // (Manually fill `BlockSize` bytes at a time, with Memcpy)
-    // This may be inefficient
+    while ((Threshold - Destination) >= 4) {
+      __builtin_memcpy((void*)Destination, Block, 4);
+      Destination += 4;
+    }
 
-    while (Destination < Threshold) {
+  } else if (BlockSize == 8) {
+
+    while ((Threshold - Destination) >= 8) {
+      __builtin_memcpy((void*)Destination, Block, 8);
+      Destination += 8;
+    }
+
+  } else {
 
+    while ((Threshold - Destination) >= BlockSize) {
       Memcpy((void*)Destination, Block, BlockSize);
       Destination += BlockSize;
-
     }
 
   }
 
+  // Finally, copy the first part of the block into whatever's left.
+
+  CopyPatternBytes((uint8*)Destination, (Threshold - Destination), (const uint8*)Block, BlockSize, 0);
+
   // (Return, now that we're done)
 
   return;
@@ -9,6 +9,38 @@
 
   #include "../Libraries/Stdint.h"
 
+  // Include structures from Memory.c
+
+  typedef void (*memoryCopyFunction)(void* Destination, const void* Source, uint64 Size);
+  typedef void (*memoryFillFunction)(void* Buffer, uint8 Value, uint64 Size);
+  typedef int (*memoryCompareFunction)(const void* BufferA, const void* BufferB, uint64 Size);
+  typedef void (*memoryPatternFunction)(void* Buffer, const void* Lane, uint64 Size);
+
+  typedef enum _memorySizeClass : uint8 {
+
+    MemorySizeClass_Medium = 0, // (From 64 bytes up to LargeThreshold)
+    MemorySizeClass_Large = 1, // (From LargeThreshold up to HugeThreshold)
+    MemorySizeClass_Huge = 2, // (Anything larger; these bypass the cache)
+
+    NumMemorySizeClasses = 3
+
+  } memorySizeClass;
+
+  typedef struct _memoryDispatchTable {
+
+    memoryCopyFunction Memcpy[NumMemorySizeClasses]; // (The routines Memcpy() uses, for each size class)
+    memoryFillFunction Memset[NumMemorySizeClasses]; // (The routines Memset() uses, for each size class)
+    memoryCopyFunction Memmove; // (The routine Memmove() uses for overlapping areas)
+    memoryCompareFunction Memcmp[3]; // (The routines Memcmp() uses, for 16, 32 and 64+ bytes)
+
+    memoryPatternFunction MemsetPattern; // (The routine MemsetBlock() uses to repeat a pattern)
+    uintptr PatternLaneSize; // (The size of the lane it repeats; always three vectors)
+
+    uintptr LargeThreshold; // (The smallest size that counts as MemorySizeClass_Large)
+    uintptr HugeThreshold; // (The smallest size that counts as MemorySizeClass_Huge)
+
+  } memoryDispatchTable;
+
   // Include standard library functions from Memory.c
 
   int Memcmp(const void* BufferA, const void* BufferB, uintptr Size);
@@ -18,8 +50,25 @@
 
   // Include non-standard library functions from Memory.c
 
+  extern memoryDispatchTable MemoryDispatchTable;
+  void InitializeMemoryDispatchTable(void);
+
   void MemsetBlock(void* Buffer, const void* Block, uintptr Size, uintptr BlockSize);
 
+  // (Compare two UUIDs for equality; this is inlined, since it's always
+  // the same size, and it's much faster than going through Memcmp())
+
+  static inline bool UuidsAreEqual(const genericUuid* UuidA, const genericUuid* UuidB) {
+
+    uint64 A[2], B[2];
+
+    __builtin_memcpy(A, UuidA, sizeof(genericUuid));
+    __builtin_memcpy(B, UuidB, sizeof(genericUuid));
+
+    return (((A[0] ^ B[0]) | (A[1] ^ B[1])) == 0);
+
+  }
+
   // Include compiler-required wrappers from Memory.c
 
   int memcmp(const void*, const void*, uintptr);
@@ -29,46 +78,86 @@
 
   // Include structures from Mm.c
 
-  typedef struct _allocationNode {
+  #define MaxBlockLevel 30 // (The largest block we can allocate is 1 GiB, or (1 << 30) bytes)
+  #define MaxMemoryRegions 128 // (The maximum number of usable memory map entries we can manage)
+  #define MinGrowSize 0x400000 // (Regions are set up lazily, at least 4 MiB at a time)
+
+  #define LowZoneLimit 0x100000 // (Memory below 1 MiB, which can be used from real mode)
+  #define Dma32ZoneLimit 0x100000000 // (Memory below 4 GiB, which can be used for 32-bit DMA)
 
-    // (Miscellaneous information, and padding)
+  typedef enum _mmZone : uint8 {
 
-    void* Pointer; // (What memory block does this node represent?)
-    uint8 Padding[24]; // (Not used, for now.)
+    MemoryZone_Low = 0, // (Below LowZoneLimit)
+    MemoryZone_Dma32 = 1, // (Between LowZoneLimit and Dma32ZoneLimit)
+    MemoryZone_Normal = 2, // (Everything above Dma32ZoneLimit)
 
-    // (Position-related information - links to the previous and next
-    // nodes, in terms of position)
+    NumMemoryZones = 3
 
-    struct {
+  } mmZone;
 
-      struct _allocationNode* Previous;
-      struct _allocationNode* Next;
+  typedef enum _allocateFlags : uint8 {
+
+    AllocateFlag_None = 0,
+    AllocateFlag_Zero = (1 << 0), // (Clear the block before returning it)
+    AllocateFlag_NoFallback = (1 << 1) // (Don't fall back to lower zones if the highest one is full)
+
+  } allocateFlags;
+
+  typedef struct _allocationNode {
 
-    } __attribute__((packed)) Position;
+    // (Links to the previous and next free blocks of the same size; this
+    // is stored at the start of each free block itself)
 
-    // (Size-related information - links to the previous and next
-    // nodes with the same size)
+    struct _allocationNode* Previous;
+    struct _allocationNode* Next;
 
-    struct {
+  } allocationNode;
 
-      struct _allocationNode* Previous;
-      struct _allocationNode* Next;
+  typedef struct _mmRegion {
 
-    } __attribute__((packed)) Size;
+    uintptr Base; // (The start of the region, including its metadata)
+    uintptr Start; // (The start of the area we can allocate from)
+    uintptr End; // (The end of that area; blocks can't go past this point)
+    uintptr Frontier; // (Everything between Start and here has already been set up)
+    mmZone Zone; // (The zone this region belongs to; regions never cross zones)
 
-  } __attribute__((packed)) allocationNode;
+    uint64* Bitmaps[MaxBlockLevel + 1]; // (One free block bitmap for each level)
 
-  static_assert((sizeof(allocationNode) == 64), "`allocationNode`'s size must be a power of two.");
+  } mmRegion;
 
   typedef struct _mmSubsystemData {
 
     bool IsEnabled; // Is the memory management subsystem currently enabled?
 
-    allocationNode* Nodes[64]; // A list of heads to linked lists for different sizes
+    allocationNode* Nodes[NumMemoryZones][64]; // A list of heads to linked lists for each zone and size
     uint8 Limits[2]; // The lower and upper bounds/limits for Nodes[]
 
+    mmRegion Regions[MaxMemoryRegions]; // Every region we can allocate from, sorted by address
+    uint16 NumRegions; // The number of regions in Regions[]
+
+    uint64 ManagedSize; // The amount of memory we can allocate from, in bytes
+    uint64 MetadataSize; // The amount of memory reserved for bitmaps, in bytes
+    uint64 ReclaimedSize; // The amount of memory saved compared to one 64-byte node per page
+
+    uint64 DroppedSize; // The amount of memory we couldn't manage, because Regions[] was full
+    uint16 NumDroppedRegions; // The number of regions that memory was in
+    uintptr DroppedBase; // The start of the first region we had to drop
+    uintptr DroppedLimit; // The end of that region
+
   } mmSubsystemData;
 
+  #define MaxAllocationRecords 8192 // (The number of allocations we can keep track of, with TraceAllocations)
+
+  typedef struct _allocationRecord {
+
+    uintptr Address; // (The address of the block, or 0 (empty) or 1 (deleted))
+    uintptr Length; // (The length that was requested, in bytes)
+    uintptr Caller; // (The return address of whoever allocated the block)
+    uint64 Timestamp; // (The value of the timestamp counter at the time)
+    uint8 Level; // (The level of the block that was actually allocated)
+
+  } allocationRecord;
+
   // Include functions and global variables from Mm.c
 
   extern mmSubsystemData MmSubsystemData;
@@ -77,6 +166,266 @@
   bool VerifyMemoryManagementSubsystem(const uintptr Try);
 
   [[nodiscard]] void* Allocate(const uintptr* Length);
+  [[nodiscard]] void* AllocateEx(const uintptr* Length, uintptr Alignment, uintptr MaxAddress, allocateFlags Flags);
   [[nodiscard]] bool Free(void* Pointer, const uintptr* Length);
+  [[nodiscard]] void* Reallocate(void* Pointer, const uintptr* OldLength, const uintptr* NewLength);
+
+  void PrintFragmentationReport(void);
+  void PrintAllocationTrace(void);
+  void RetraceAllocation(void* Pointer, uintptr Length, uintptr Caller);
+
+  #ifdef StressTestAllocator
+
+    #ifndef StressTestAllocatorSeed
+      #define StressTestAllocatorSeed 0 // (Pick a seed from the timestamp counter)
+    #endif
+
+    typedef enum _stressTestWorkload : uint8 {
+
+      StressTest_Uniform = 0, // (Random sizes up to 64 KiB, freed in random order)
+      StressTest_PowerLaw = 1, // (Mostly small sizes, with the occasional very large one)
+      StressTest_Lifo = 2, // (Random sizes, always freed in reverse order)
+      StressTest_Fragmenting = 3, // (Fill memory with pages, free every other one, then ask for larger blocks)
+
+      NumStressTestWorkloads = 4
+
+    } stressTestWorkload;
+
+    bool StressTestMemoryManagementSubsystem(uint32 NumOperations, uint64 Seed);
+
+  #endif
+
+  // Include structures from Frames.c
+
+  #define MaxFrameAreas 16 // (The maximum number of separate areas the frame allocator can manage)
+  #define FrameAllocatorShare 4 // (The frame allocator can grow to at most 1/4th of the heap's memory)
+
+  #define FramesPerSuperframe 512 // (The number of 4 KiB frames in each 2 MiB frame)
+  #define SuperframesPerGigaframe 512 // (The number of 2 MiB frames in each 1 GiB frame)
+
+  typedef enum _frameOrder : uint8 {
+
+    FrameOrder_4KiB = 0,
+    FrameOrder_2MiB = 1,
+    FrameOrder_1GiB = 2,
+
+    NumFrameOrders = 3
+
+  } frameOrder;
+
+  typedef struct _frameArea {
+
+    uintptr Base; // (The start of the area; this is always aligned to its own size)
+    uintptr Size; // (The size of the area; a power of two, between 2 MiB and 1 GiB)
+
+    uint64* Frames; // (One bit for each 4 KiB frame; set if it's free)
+    uint16* SuperframeFree; // (The number of free 4 KiB frames in each 2 MiB superframe)
+
+    uint64* FullSuperframes; // (One bit for each superframe; set if all of it is free)
+    uint64* PartialSuperframes; // (One bit for each superframe; set if only part of it is free)
+    uint64* WholeSuperframes; // (One bit for each superframe; set if it's in use as a 2 MiB frame)
+
+    bool IsGigaframeAllocated; // (Is this entire area in use as a 1 GiB frame?)
+
+    uint32 NumSuperframes; // (The number of superframes in this area)
+    uint32 NumFullSuperframes; // (The number of superframes that are completely free)
+
+  } frameArea;
+
+  typedef struct _frameAllocatorData {
+
+    bool IsEnabled; // Is the frame allocator currently enabled?
+
+    frameArea Areas[MaxFrameAreas]; // Every area we can allocate frames from
+    uint16 NumAreas; // The number of areas in Areas[]
+
+    uint64 NumFree[NumFrameOrders]; // The number of free 4 KiB, 2 MiB and 1 GiB frames
+
+    uint64 TotalSize; // The amount of memory we've taken from the heap so far, in bytes
+    uintptr NextAreaSize; // The size of the next area we'll try to take, if we need to grow
+
+  } frameAllocatorData;
+
+  // Include functions and global variables from Frames.c
+
+  extern frameAllocatorData FrameAllocatorData;
+
+  bool InitializeFrameAllocator(void);
+
+  [[nodiscard]] void* AllocateFrame(frameOrder Order);
+  [[nodiscard]] bool FreeFrame(void* Frame, frameOrder Order);
+
+  // Include structures from Paging.c
+
+  #define PageEntryPresent (1ULL << 0) // (Set if the entry is present)
+  #define PageEntryWritable (1ULL << 1) // (Set if the page can be written to)
+  #define PageEntryWriteThrough (1ULL << 3) // (PWT, bit 0 of the PAT index)
+  #define PageEntryCacheDisable (1ULL << 4) // (PCD, bit 1 of the PAT index)
+  #define PageEntryLarge (1ULL << 7) // (Set if the entry maps a 2 MiB or 1 GiB page)
+  #define PageEntryPat (1ULL << 7) // (Bit 2 of the PAT index, for 4 KiB pages)
+  #define PageEntryOwned (1ULL << 10) // (An available bit; set if we own the table this points to)
+  #define PageEntryLargePat (1ULL << 12) // (Bit 2 of the PAT index, for 2 MiB and 1 GiB pages)
+  #define PageEntryNoExecute (1ULL << 63) // (Set if the page can't be executed from)
+
+  #define PageEntryAddressMask 0x000FFFFFFFFFF000ULL // (The bits of an entry that hold an address)
+
+  typedef enum _cacheType : uint8 {
+
+    CacheType_WriteBack = 0,
+    CacheType_WriteThrough = 1,
+    CacheType_Uncached = 2,
+    CacheType_WriteCombining = 3,
+
+    NumCacheTypes = 4
+
+  } cacheType;
+
+  typedef struct _pagingSubsystemData {
+
+    bool IsEnabled; // Is the kernel currently managing its own page tables?
+
+    bool SupportsPat; // Does the CPU support PAT (and therefore write-combining)?
+    bool Supports1GiBPages; // Does the CPU support 1 GiB pages?
+
+    uint64* Pml4; // The PML4 we're currently using (this is always one we own)
+
+    uint64 NumTables; // The number of page tables we've allocated
+    uint64 NumSplitPages; // The number of large pages we've had to split up
+    uint64 NumPromotedPages; // The number of tables we've replaced with large pages
+
+    uint64 NumPages[3]; // The number of 4 KiB, 2 MiB and 1 GiB pages MapRange() has mapped
+
+  } pagingSubsystemData;
+
+  // Include functions and global variables from Paging.c
+
+  extern pagingSubsystemData PagingSubsystemData;
+
+  bool InitializePagingSubsystem(void);
+
+  bool MapRange(uint64 Physical, uint64 Virtual, uint64 Size, cacheType Type);
+  void InvalidatePages(uint64 Virtual, uint64 Size);
+
+  // Include structures from ZeroPool.c
+
+  #define NumZeroPoolSizes 5 // (The pool keeps blocks from 4 KiB to 64 KiB, one size per level)
+  #define ZeroPoolDepth 8 // (The number of pre-zeroed blocks the pool keeps for each size)
+
+  #define ZeroPoolRefillStep 0x10000 // (RefillZeroPool() clears at most 64 KiB per call)
+
+  typedef struct _zeroPoolData {
+
+    void* Blocks[NumZeroPoolSizes][ZeroPoolDepth]; // (Blocks that have already been cleared)
+    uint8 NumBlocks[NumZeroPoolSizes]; // (The number of blocks in each row of Blocks[])
+
+    void* Pending; // (The block that's currently being cleared, if any)
+    uint8 PendingSize; // (The size index of that block)
+    uintptr PendingOffset; // (How much of that block has been cleared so far)
+
+  } zeroPoolData;
+
+  // Include functions and global variables from ZeroPool.c
+
+  extern zeroPoolData ZeroPoolData;
+
+  [[nodiscard]] void* AllocateZeroed(const uintptr* Length);
+  bool RefillZeroPool(void);
+  void DrainZeroPool(void);
+
+  // Include structures from Slab.c
+
+  #define MinObjectSize 16 // (The smallest object a cache can hold; also the alignment of every object)
+  #define MinObjectsPerSlab 8 // (Slabs are made larger until they can fit at least this many objects)
+
+  #define NumSmallObjectCaches 8 // (The number of general-purpose caches, for objects from 16 B to 2 KiB)
+  #define MaxSmallObjectSize (MinObjectSize << (NumSmallObjectCaches - 1))
+
+  typedef struct _objectSlab {
+
+    // (Every slab starts with this header, and is aligned to its own size,
+    // so we can find it from any of its objects)
+
+    struct _objectCache* Cache; // (The cache this slab belongs to)
+
+    struct _objectSlab* Previous; // (Links to the previous and next slabs
+    struct _objectSlab* Next; // in the same list)
+
+    void* FreeObjects; // (A singly-linked list of free objects in this slab)
+    uint32 NumFree; // (The number of free objects in this slab)
+
+  } objectSlab;
+
+  typedef struct _objectCache {
+
+    uintptr ObjectSize; // (The size of each object, rounded up to MinObjectSize)
+    uintptr SlabSize; // (The size of each slab, including its header)
+    uintptr Offset; // (The offset of the first object in each slab)
+    uint32 ObjectsPerSlab; // (The number of objects that fit in each slab)
+
+    objectSlab* Partial; // (Slabs with at least one free object)
+    objectSlab* Full; // (Slabs without any free objects)
+    objectSlab* Empty; // (A spare slab without any used objects, or NULL)
+
+    uint64 NumSlabs; // (The number of slabs currently allocated)
+    uint64 NumObjects; // (The number of objects currently in use)
+
+  } objectCache;
+
+  // Include functions and global variables from Slab.c
+
+  extern objectCache SmallObjectCaches[NumSmallObjectCaches];
+
+  bool CreateObjectCache(objectCache* Cache, uintptr ObjectSize);
+
+  [[nodiscard]] void* AllocateObject(objectCache* Cache);
+  [[nodiscard]] bool FreeObject(objectCache* Cache, void* Pointer);
+
+  [[nodiscard]] void* AllocateSmall(const uintptr* Length);
+  [[nodiscard]] bool FreeSmall(void* Pointer, const uintptr* Length);
+
+  // Include structures from Arena.c
+
+  #define ArenaAlignment 16 // (Every allocation from an arena is aligned to this many bytes)
+  #define DefaultArenaChunkSize 0x10000 // (Arenas grow 64 KiB at a time, unless told otherwise)
+
+  typedef struct _arenaChunk {
+
+    // (Every chunk starts with this header; chunks are linked together
+    // from newest to oldest, so they can be freed in reverse order)
+
+    struct _arenaChunk* Previous; // (The chunk allocated before this one, or NULL)
+    uintptr Size; // (The size of this chunk, including its header)
+
+  } arenaChunk;
+
+  typedef struct _memoryArena {
+
+    arenaChunk* Chunk; // (The chunk we're currently allocating from, or NULL)
+    uintptr Offset; // (The offset of the next allocation within that chunk)
+    uintptr ChunkSize; // (The minimum size of each new chunk)
+
+  } memoryArena;
+
+  typedef struct _arenaMark {
+
+    arenaChunk* Chunk; // (The value of memoryArena{}.Chunk when the mark was taken)
+    uintptr Offset; // (The value of memoryArena{}.Offset when the mark was taken)
+
+  } arenaMark;
+
+  // Include functions from Arena.c
+
+  bool ArenaCreate(memoryArena* Arena, uintptr ChunkSize);
+  [[nodiscard]] void* ArenaAlloc(memoryArena* Arena, uintptr Size);
+
+  arenaMark ArenaMark(const memoryArena* Arena);
+  void ArenaReset(memoryArena* Arena, arenaMark Mark);
+  void ArenaDestroy(memoryArena* Arena);
+
+  // Include functions from Benchmark.c
+
+  #ifdef BenchmarkMemory
+    void BenchmarkMemoryRoutines(void);
+  #endif
 
 #endif
@@ -8,6 +8,10 @@
 #include "../../Common.h"
 #include "Memory.h"
 
+// (NOTE - This is for debug/information messages only)
+
+#include "../Libraries/Stdio.h"
+
 // (TODO - Global variables)
 
 mmSubsystemData MmSubsystemData = {0};
@@ -17,740 +21,1652 @@ mmSubsystemData MmSubsystemData = {0};
 static usableMmapEntry* KernelMmap = NULL;
 static uint16 NumKernelMmapEntries = 0;
 
-static constexpr uint64 ScalingFactor = (SystemPageSize / sizeof(allocationNode));
 
+#ifdef TraceAllocations
 
+  // When TraceAllocations is defined (see makefile.config), every block
+  // from Allocate() is recorded in a hash table (keyed by its address,
+  // with linear probing), so that Free() can catch double frees and
+  // length mismatches, and so that PrintAllocationTrace() can show what
+  // hasn't been freed yet. Without it, none of this is compiled in.
 
-// (TODO - Initializer/constructor function)
-
-bool InitializeMemoryManagementSubsystem(void* UsableMmap, uint16 NumUsableMmapEntries) {
+  static allocationRecord AllocationRecords[MaxAllocationRecords] = {0};
+  static uintptr NumAllocationRecords = 0;
 
-  // (First, is this actually a usable memory map?)
+  static_assert(((MaxAllocationRecords & (MaxAllocationRecords - 1)) == 0), "MaxAllocationRecords must be a power of two.");
 
-  if (UsableMmap == NULL) {
-    return false;
-  } else if (NumUsableMmapEntries == 0) {
-    return false;
+  static inline uintptr HashAddress(uintptr Address) {
+    return (((Address >> 12) * 0x9E3779B97F4A7C15ULL) >> 32) & (MaxAllocationRecords - 1);
   }
 
-  KernelMmap = UsableMmap;
-  NumKernelMmapEntries = NumUsableMmapEntries;
+  // (Find the record for a given address, or return NULL if there isn't
+  // one; we can stop at the first empty (not deleted) slot)
 
-  // (Calculate the 'minimum' and 'maximum' levels, storing them in
-  // MmSubsystemData.Limits[]; this is based off of `SystemPageSize`
+  static allocationRecord* FindRecord(uintptr Address) {
 
-  auto PageSize = SystemPageSize;
-  MmSubsystemData.Limits[0] = 0; MmSubsystemData.Limits[1] = 63;
+    uintptr Index = HashAddress(Address);
 
-  while (PageSize != 0) {
+    for (uintptr Probe = 0; Probe < MaxAllocationRecords; Probe++) {
 
-    MmSubsystemData.Limits[0]++;
-    PageSize >>= 1;
+      allocationRecord* Record = &AllocationRecords[Index];
 
-  }
+      if (Record->Address == Address) {
+        return Record;
+      } else if (Record->Address == 0) {
+        break;
+      }
 
-  MmSubsystemData.Limits[0]--;
+      Index = ((Index + 1) & (MaxAllocationRecords - 1));
+
+    }
 
-  // (Handle each memory map entry)
+    return NULL;
+
+  }
 
-  allocationNode* PreviousNode = NULL;
+  // (Add a record for a newly allocated block, reusing the first empty
+  // or deleted slot we find)
 
-  for (auto Entry = 0; Entry < NumKernelMmapEntries; Entry++) {
+  static void AddRecord(uintptr Address, uintptr Length, uint8 Level, uintptr Caller) {
 
-    // First, let's calculate how much space will actually be needed for
-    // the allocation data (at *Start), and reserve it.
+    if (NumAllocationRecords >= MaxAllocationRecords) {
 
-    auto ReservedSpace = (KernelMmap[Entry].Limit / ScalingFactor);
+      Message(Warning, "Couldn't trace allocation at %xh (by %xh); the table is full.", Address, Caller);
+      return;
 
-    if ((ReservedSpace % SystemPageSize) != 0) {
-      ReservedSpace += (SystemPageSize - (ReservedSpace % SystemPageSize));
     }
 
-    uintptr Start = KernelMmap[Entry].Base;
-    uintptr Offset = 0;
+    uintptr Index = HashAddress(Address);
 
-    // We don't know if the reserved space itself is clear or not, so
-    // let's clear it with Memset() - this is useful later on.
+    while (AllocationRecords[Index].Address > 1) {
+      Index = ((Index + 1) & (MaxAllocationRecords - 1));
+    }
 
-    Memset((void*)KernelMmap[Entry].Base, 0, ReservedSpace);
+    AllocationRecords[Index].Address = Address;
+    AllocationRecords[Index].Length = Length;
+    AllocationRecords[Index].Caller = Caller;
+    AllocationRecords[Index].Timestamp = ReadTimestampCounter();
+    AllocationRecords[Index].Level = Level;
 
-    // Now that we know how much space we're working with, let's
-    // push nodes (add free blocks) as necessary.
+    NumAllocationRecords++;
 
-    auto Space = (KernelMmap[Entry].Limit - ReservedSpace);
+  }
 
-    if (Space < (KernelMmap[Entry].Limit / 2)) {
-      return false;
-    }
+  // (Check that a block being freed or resized was actually allocated,
+  // and with a length that maps to the same level; returns its record,
+  // or NULL (after showing a warning) if not)
 
-    while (Space >= SystemPageSize) {
+  static allocationRecord* CheckRecord(uintptr Address, uintptr Length, uint8 Level, uintptr Caller) {
 
-      // (Find the largest offset of two that would reasonably fit;
-      // this is the base-two logarithm of `Space`)
+    allocationRecord* Record = FindRecord(Address);
 
-      auto Logarithm = 0;
+    if (Record == NULL) {
 
-      while ((Space >> Logarithm) != 0) {
-        Logarithm++;
-      }
+      Message(Warning, "Block at %xh (%d bytes, from %xh) isn't allocated; is this a double free?",
+                       Address, Length, Caller);
 
-      Logarithm--;
+      return NULL;
 
-      // (Push a node to signify that there's a free memory area
-      // at *(Start + Offset) that's (1 << Logarithm) bytes wide)
+    } else if (Record->Level != Level) {
 
-      uintptr Address = (Start + (Offset / ScalingFactor));
-      void* Pointer = (void*)(Start + ReservedSpace + Offset);
+      Message(Warning, "Block at %xh was allocated with %d bytes (by %xh), not %d bytes (from %xh).",
+                       Address, Record->Length, Record->Caller, Length, Caller);
 
-      allocationNode* Node = (allocationNode*)Address;
+      return NULL;
 
-      Node->Pointer = Pointer;
-      Node->Position.Previous = PreviousNode;
-      Node->Position.Next = NULL;
+    } else if (Record->Length != Length) {
 
-      if (PreviousNode != NULL) {
-        PreviousNode->Position.Next = Node;
-      }
+      Message(Warning, "Block at %xh was allocated with %d bytes (by %xh), not %d bytes (from %xh); "
+                       "ignoring, since the block size is the same.", Address, Record->Length,
+                       Record->Caller, Length, Caller);
 
-      PreviousNode = Node;
+    }
 
-      Node->Size.Previous = MmSubsystemData.Nodes[Logarithm];
-      MmSubsystemData.Nodes[Logarithm] = Node;
+    return Record;
 
-      if (Node->Size.Previous != NULL) {
-        allocationNode* Temp = Node->Size.Previous;
-        Temp->Size.Next = Node;
-      }
+  }
 
-      // (Update `Space` and `Offset` respectively)
+  // (Remove a record, leaving a 'deleted' marker so that probing still
+  // works for any records after it)
 
-      Space -= (1ULL << Logarithm);
-      Offset += (1ULL << Logarithm);
+  static inline void RemoveRecord(allocationRecord* Record) {
 
-    }
+    Record->Address = 1;
+    NumAllocationRecords--;
 
   }
 
-  // (Update `MmSubsystemData.IsEnabled` and return true, now that
-  // we're done)
+#endif
 
-  MmSubsystemData.IsEnabled = true;
-  return MmSubsystemData.IsEnabled;
+
+
+// (Calculate the level (base-two logarithm) of the smallest block that
+// can fit `Size` bytes; this is never lower than MmSubsystemData.Limits[0])
+
+static inline uint8 GetBlockLevel(uintptr Size) {
+
+  uint8 Level = MmSubsystemData.Limits[0];
+
+  while ((Level < 63) && (Size > (1ULL << Level))) {
+    Level++;
+  }
+
+  return Level;
 
 }
 
 
 
-// (TODO - Function to test the memory management subsystem)
+// (Calculate the size of a region's bitmap for a given level, in 64-bit
+// words; each bit represents one (naturally aligned) block)
 
-bool VerifyMemoryManagementSubsystem(const uintptr Try) {
+static inline uintptr GetBitmapSize(uintptr Base, uintptr End, uint8 Level) {
 
-  // (Declare a new `Size` variable with the value from Try, and
-  // try to allocate memory with it)
+  uintptr NumBits = ((((End - 1) >> Level) - (Base >> Level)) + 1);
+  return ((NumBits + 63) / 64);
 
-  const uintptr Size = Try;
-  void* Pointer = Allocate(&Size);
+}
 
-  if (Pointer == NULL) {
-    return false;
-  } else if (Size != Try) {
-    return false;
-  }
 
-  // (Now, try to free the memory block we just allocated, and return
-  // the result from Free())
 
-  return Free(Pointer, &Size);
+// (Find the zone that an address belongs to)
+
+static inline mmZone GetZone(uintptr Address) {
+
+  if (Address < LowZoneLimit) {
+    return MemoryZone_Low;
+  } else if (Address < Dma32ZoneLimit) {
+    return MemoryZone_Dma32;
+  }
+
+  return MemoryZone_Normal;
 
 }
 
 
 
-// (TODO - Push a block (for FreeBlock, Merge, etc.))
+// (Find the region that `Address` belongs to, using a binary search over
+// MmSubsystemData.Regions[] (which is sorted by address); returns NULL if
+// it doesn't belong to any)
 
-static inline void PushBlock(allocationNode* Node, void* Pointer, allocationNode* Previous, allocationNode* Next, uint8 Level) {
+static inline mmRegion* FindRegion(uintptr Address) {
 
-  // (Create a node at the address pointed to by `Node`, and link it
-  // with adjacent nodes if possible)
+  uint16 Lower = 0;
+  uint16 Upper = MmSubsystemData.NumRegions;
 
-  Node->Pointer = Pointer;
+  while (Lower < Upper) {
 
-  Node->Position.Previous = Previous;
-  Node->Position.Next = Next;
+    uint16 Middle = (Lower + ((Upper - Lower) / 2));
+    mmRegion* Region = &MmSubsystemData.Regions[Middle];
 
-  if (Previous != NULL) {
-    Previous->Position.Next = Node;
-  }
+    if (Address < Region->Start) {
+      Upper = Middle;
+    } else if (Address >= Region->End) {
+      Lower = (Middle + 1);
+    } else {
+      return Region;
+    }
 
-  if (Next != NULL) {
-    Next->Position.Previous = Node;
   }
 
-  // (Push the node to its corresponding list at `MmSubsystemData.Nodes[Level]`,
-  // and link it with the last free size block)
+  return NULL;
+
+}
+
+
+
+// (Check, set or clear the bit that represents a given block in its
+// region's bitmap for that level; a set bit means the block is free)
 
-  Node->Size.Previous = MmSubsystemData.Nodes[Level];
-  MmSubsystemData.Nodes[Level] = Node;
+static inline bool IsBlockFree(const mmRegion* Region, uintptr Address, uint8 Level) {
 
-  if (Node->Size.Previous != NULL) {
-    allocationNode* Temp = Node->Size.Previous;
-    Temp->Size.Next = Node;
+  if ((Address < Region->Start) || (Address >= Region->Frontier)) {
+    return false;
   }
 
-  Node->Size.Next = NULL;
+  uintptr Index = ((Address >> Level) - (Region->Base >> Level));
+  return ((Region->Bitmaps[Level][Index / 64] & (1ULL << (Index % 64))) != 0);
+
+}
+
+static inline void MarkBlock(mmRegion* Region, uintptr Address, uint8 Level, bool IsFree) {
 
-  // (Return, now that we're done)
+  uintptr Index = ((Address >> Level) - (Region->Base >> Level));
 
-  return;
+  if (IsFree == true) {
+    Region->Bitmaps[Level][Index / 64] |= (1ULL << (Index % 64));
+  } else {
+    Region->Bitmaps[Level][Index / 64] &= ~(1ULL << (Index % 64));
+  }
 
 }
 
 
 
-// (TODO - Pop a block (for Allocate(), Merge, etc.))
+// (Push a free block onto the list for its zone and level (and mark it in
+// the bitmap); the list node itself is stored at the start of the block)
+
+static inline void PushBlock(mmRegion* Region, uintptr Address, uint8 Level) {
+
+  allocationNode* Node = (allocationNode*)Address;
+  allocationNode* Head = MmSubsystemData.Nodes[Region->Zone][Level];
+
+  Node->Previous = NULL;
+  Node->Next = Head;
 
-[[nodiscard]] static inline void* PopBlock(uint8 Level) {
+  if (Head != NULL) {
+    Head->Previous = Node;
+  }
 
-  // (Get the current node for the corresponding level, as long as
-  // it isn't a null pointer)
+  MmSubsystemData.Nodes[Region->Zone][Level] = Node;
+  MarkBlock(Region, Address, Level, true);
 
-  allocationNode* Node = MmSubsystemData.Nodes[Level];
-  void* Pointer = NULL;
+}
 
-  if (Node != NULL) {
 
-    // (Update `Pointer`, and check that it isn't NULL either)
 
-    Pointer = Node->Pointer;
+// (Remove a free block from its level's list, wherever it is (and clear
+// it from the bitmap))
 
-    if (Pointer != NULL) {
+static inline void RemoveBlock(mmRegion* Region, uintptr Address, uint8 Level) {
 
-      // (Relink any adjacent nodes, and update position information)
+  allocationNode* Node = (allocationNode*)Address;
 
-      allocationNode* Previous = Node->Position.Previous;
-      allocationNode* Next = Node->Position.Next;
+  if (Node->Previous != NULL) {
+    Node->Previous->Next = Node->Next;
+  } else {
+    MmSubsystemData.Nodes[Region->Zone][Level] = Node->Next;
+  }
 
-      if (Previous != NULL) {
-        Previous->Position.Next = Next;
-      }
+  if (Node->Next != NULL) {
+    Node->Next->Previous = Node->Previous;
+  }
 
-      if (Next != NULL) {
-        Next->Position.Previous = Previous;
-      }
+  MarkBlock(Region, Address, Level, false);
+
+}
 
-      // (Pop the node from `MmSubsystemData.Nodes[Level]`)
 
-      MmSubsystemData.Nodes[Level] = Node->Size.Previous;
 
-      if (MmSubsystemData.Nodes[Level] != NULL) {
-        MmSubsystemData.Nodes[Level]->Size.Next = NULL;
-      }
+// (Add a free block, merging it with its buddy for as long as the buddy
+// is also free; since every block is aligned to its own size, the buddy
+// is just (Address ^ Size), and we can check it with the bitmap)
 
-      // (Clear our newly popped node, so it doesn't appear in any
-      // searches from something like `FreeBlock()`)
+static void ReleaseBlock(mmRegion* Region, uintptr Address, uint8 Level) {
 
-      Memset((void*)Node, 0, sizeof(allocationNode));
+  while (Level < MmSubsystemData.Limits[1]) {
 
+    uintptr Buddy = (Address ^ (1ULL << Level));
+
+    if (IsBlockFree(Region, Buddy, Level) == false) {
+      break;
     }
 
-  }
+    RemoveBlock(Region, Buddy, Level);
+
+    if (Buddy < Address) {
+      Address = Buddy;
+    }
 
-  // (Now that we're done, return `Pointer`)
+    Level++;
 
-  return Pointer;
+  }
+
+  PushBlock(Region, Address, Level);
 
 }
 
 
 
-// (TODO - Free a block (for Free()))
+// (Set up more of a region - moving its frontier forward by at least
+// MinGrowSize, and far enough to fit a block of the given level - and
+// return false if there's nothing left to set up)
 
-static inline allocationNode* FreeBlock(void* Pointer, uintptr Size) {
+// Regions aren't set up all at once; instead, we only clear the parts of
+// each bitmap that we need, and add free blocks for the memory that
+// they cover, as we run out of memory. This means that initialization
+// doesn't need to touch any more memory than it has to.
 
-  // First, let's try to figure out which entry `Pointer` belongs to.
+static bool GrowRegion(mmRegion* Region, uint8 Level) {
 
-  // (Try to figure out where `Pointer` is (within the memory map))
+  if (Region->Frontier >= Region->End) {
+    return false;
+  }
 
-  auto Entry = uintmax;
+  // (Calculate where the new frontier should be)
 
-  for (uint16 Index = 0; Index < NumKernelMmapEntries; Index++) {
+  uintptr Size = (1ULL << Level);
+  uintptr Target = (Region->Frontier + MinGrowSize);
+  uintptr Aligned = (((Region->Frontier + Size - 1) & ~(Size - 1)) + Size);
+
+  if (Aligned > Target) {
+    Target = Aligned;
+  }
 
-    if ((uintptr)Pointer >= KernelMmap[Index].Base) {
+  if ((Target > Region->End) || (Target < Region->Frontier)) {
+    Target = Region->End;
+  }
 
-      if ((uintptr)Pointer <= (KernelMmap[Index].Base + KernelMmap[Index].Limit)) {
+  // (Clear the bitmap words that cover the area between the current
+  // frontier and the new one; the first word may have already been
+  // cleared, in which case we skip it)
 
-        Entry = Index;
-        break;
+  for (auto Bitmap = MmSubsystemData.Limits[0]; Bitmap <= MmSubsystemData.Limits[1]; Bitmap++) {
 
-      }
+    uintptr BaseIndex = (Region->Base >> Bitmap);
+    uintptr First = (((Region->Start >> Bitmap) - BaseIndex) / 64);
 
+    if (Region->Frontier != Region->Start) {
+      First = (((((Region->Frontier - 1) >> Bitmap) - BaseIndex) / 64) + 1);
     }
 
-  }
+    uintptr Last = ((((Target - 1) >> Bitmap) - BaseIndex) / 64);
 
-  // (If it's not within the memory map at all, just return false)
+    if (Last >= First) {
+      Memset((void*)&Region->Bitmaps[Bitmap][First], 0, ((Last - First + 1) * sizeof(uint64)));
+    }
 
-  if (Entry == uintmax) {
-    return NULL;
   }
 
-  // Next, let's calculate the amount of reserved space within this
-  // entry, and return NULL if `Pointer` is within it.see
+  // (Add the largest blocks that are aligned to their own size, and that
+  // still fit before the new frontier; these can also merge with any
+  // free blocks right before the old frontier)
 
-  // (Calculate the amount of reserved space in the entry that
-  // `Pointer` belongs to)
+  uintptr Address = Region->Frontier;
+  Region->Frontier = Target;
 
-  auto ReservedSpace = (KernelMmap[Entry].Limit / ScalingFactor);
+  while ((Target - Address) >= SystemPageSize) {
 
-  if ((ReservedSpace % SystemPageSize) != 0) {
-    ReservedSpace += (SystemPageSize - (ReservedSpace % SystemPageSize));
-  }
+    uint8 BlockLevel = MmSubsystemData.Limits[1];
 
-  // (Check if `Pointer` is within that reserved space, and if so,
-  // return a NULL pointer)
+    while (((Address % (1ULL << BlockLevel)) != 0) || ((Target - Address) < (1ULL << BlockLevel))) {
+      BlockLevel--;
+    }
 
-  auto Start = KernelMmap[Entry].Base;
+    ReleaseBlock(Region, Address, BlockLevel);
+    Address += (1ULL << BlockLevel);
 
-  if ((uintptr)Pointer <= (Start + ReservedSpace)) {
-    return NULL;
   }
 
-  // Now that we know how much reserved space we have, we can move
-  // onto trying to find adjacent free memory blocks.
+  return true;
+
+}
 
-  // Each free memory block is stored in a corresponding unique location
-  // as an `allocationNode`, which means you can predictably find
-  // adjacent nodes like this:
 
-  // (1) Calculate the corresponding address for the node that
-  // would represent `Pointer`
 
-  auto Offset = ((uintptr)Pointer - (ReservedSpace + Start));
-  uintptr Address = (Start + (Offset / ScalingFactor));
+// (Set up a region from `Base` to `Limit` (which must be page-aligned,
+// and within the same zone), and insert it into MmSubsystemData.Regions[])
 
-  // (2) Try to find the *previous* node
-  // (If the `Pointer` member isn't NULL, that means it's a valid node)
+static void AddRegion(uintptr Base, uintptr Limit) {
 
-  allocationNode* PreviousNode = NULL;
+  // (Make sure we still have space left in Regions[]; if we don't, keep
+  // track of what we had to drop, so KernelCore() can warn about it later,
+  // since the console isn't available yet)
 
-  auto Limit = (KernelMmap[Entry].Base);
-  auto Multiplier = sizeof(allocationNode);
+  if (MmSubsystemData.NumRegions >= MaxMemoryRegions) {
 
-  while ((Address - Multiplier) >= Limit) {
+    if (MmSubsystemData.NumDroppedRegions == 0) {
 
-    allocationNode* Try = (allocationNode*)(Address - Multiplier);
+      MmSubsystemData.DroppedBase = Base;
+      MmSubsystemData.DroppedLimit = Limit;
 
-    if (Try->Pointer != NULL) {
-      PreviousNode = Try; break;
-    } else {
-      Multiplier *= 2;
     }
 
-  }
+    MmSubsystemData.DroppedSize += (Limit - Base);
+    MmSubsystemData.NumDroppedRegions++;
 
-  // (3) Try to find the *next* node.
+    return;
 
-  allocationNode* NextNode = NULL;
+  }
 
-  Limit += ReservedSpace;
-  Multiplier = sizeof(allocationNode);
+  // First, let's calculate how much space will actually be needed for
+  // the allocation data (at *Base), and reserve it.
 
-  while ((Address + Multiplier) <= Limit) {
+  uintptr ReservedSpace = 0;
 
-    allocationNode* Try = (allocationNode*)(Address + Multiplier);
+  for (auto Level = MmSubsystemData.Limits[0]; Level <= MmSubsystemData.Limits[1]; Level++) {
+    ReservedSpace += (GetBitmapSize(Base, Limit, Level) * sizeof(uint64));
+  }
 
-    if (Try->Pointer != NULL) {
-      NextNode = Try; break;
-    } else {
-      Multiplier *= 2;
-    }
+  if ((ReservedSpace % SystemPageSize) != 0) {
+    ReservedSpace += (SystemPageSize - (ReservedSpace % SystemPageSize));
+  }
+
+  // (Make sure that we aren't using most of the region just for
+  // metadata; this can happen with very small regions, which we skip)
 
+  if (ReservedSpace > ((Limit - Base) / 2)) {
+    return;
   }
 
-  // Finally, now that we've found the previous and next nodes, we
-  // can create a new node (at *Address), and assign it to the given
-  // list, depending on the size:
+  // (We don't clear the reserved space here; each part of it is cleared
+  // by GrowRegion() instead, right before it's first needed)
 
-  // (Calculate the logarithm of the block size / the block 'level')
+  // Now that we know how much space we're working with, let's set up
+  // the region itself, and insert it into Regions[] (which needs to
+  // stay sorted, so we can binary search through it later on).
 
-  auto Logarithm = MmSubsystemData.Limits[0];
+  mmRegion Region = {0};
+
+  Region.Base = Base;
+  Region.Start = (Base + ReservedSpace);
+  Region.End = Limit;
+  Region.Frontier = Region.Start;
+  Region.Zone = GetZone(Base);
+
+  uintptr Bitmap = Base;
+
+  for (auto Level = MmSubsystemData.Limits[0]; Level <= MmSubsystemData.Limits[1]; Level++) {
+
+    Region.Bitmaps[Level] = (uint64*)Bitmap;
+    Bitmap += (GetBitmapSize(Base, Limit, Level) * sizeof(uint64));
 
-  while (Size > (1ULL << Logarithm)) {
-    Logarithm++;
   }
 
-  // (Return a null pointer if the logarithm exceeds the maximum)
+  // (Keep track of how much memory we're managing, and how much we
+  // saved compared to the old layout, which needed a 64-byte node for
+  // every page)
 
-  if (Logarithm > MmSubsystemData.Limits[1]) {
-    return NULL;
+  uintptr NodeSpace = (((Limit - Base) / SystemPageSize) * 64);
+
+  if ((NodeSpace % SystemPageSize) != 0) {
+    NodeSpace += (SystemPageSize - (NodeSpace % SystemPageSize));
   }
 
-  // (Use PushBlock() to initialize the node at the corresponding
-  // location (Node, representing Pointer), before returning it)
+  MmSubsystemData.ManagedSize += (Region.End - Region.Start);
+  MmSubsystemData.MetadataSize += ReservedSpace;
 
-  allocationNode* Node = (allocationNode*)Address;
-  PushBlock(Node, Pointer, PreviousNode, NextNode, Logarithm);
+  if (NodeSpace > ReservedSpace) {
+    MmSubsystemData.ReclaimedSize += (NodeSpace - ReservedSpace);
+  }
 
-  return Node;
+  uint16 Index = MmSubsystemData.NumRegions;
 
-}
+  while ((Index > 0) && (MmSubsystemData.Regions[Index - 1].Start > Region.Start)) {
 
+    MmSubsystemData.Regions[Index] = MmSubsystemData.Regions[Index - 1];
+    Index--;
 
+  }
 
-// (TODO - Break a block up to a certain target size)
+  MmSubsystemData.Regions[Index] = Region;
+  MmSubsystemData.NumRegions++;
 
-[[nodiscard]] static inline bool DivideBlock(allocationNode* Node, uint8 Level, uint8 Target) {
+}
 
-  // (Sanity-check `Node`, `Level` and `Target`, and return `false`
-  // if they don't make sense)
 
-  if ((Node == NULL) || (Node->Pointer == NULL)) {
-    return false;
-  } else if (Target >= Level) {
-    return false;
-  }
 
-  uintptr Address = (uintptr)Node;
+// (TODO - Initializer/constructor function)
+
+bool InitializeMemoryManagementSubsystem(void* UsableMmap, uint16 NumUsableMmapEntries) {
 
-  // (Additionally, check if we're exceeding MmSubsystemData.Limits[])
+  // (First, is this actually a usable memory map?)
 
-  if (Target < MmSubsystemData.Limits[0]) {
+  if (UsableMmap == NULL) {
     return false;
-  } else if (Level > MmSubsystemData.Limits[1]) {
+  } else if (NumUsableMmapEntries == 0) {
     return false;
   }
 
-  // We need to be able to divide our memory block in the most efficient
-  // way possible, depending on the value of `Target`; so, before we
-  // do anything else, let's try to deal with that.
+  KernelMmap = UsableMmap;
+  NumKernelMmapEntries = NumUsableMmapEntries;
+
+  // (Calculate the 'minimum' and 'maximum' levels, storing them in
+  // MmSubsystemData.Limits[]; this is based off of `SystemPageSize`
 
-  // (Calculate the necessary size for the 'buffer')
+  auto PageSize = SystemPageSize;
+  MmSubsystemData.Limits[0] = 0; MmSubsystemData.Limits[1] = MaxBlockLevel;
 
-  auto Size = (Level - Target + 1);
-  uint8 Buffer[Size];
+  while (PageSize != 0) {
 
-  // (Fill it out; for example, (15, 11) becomes (14, 13, 12, 11, 11))
+    MmSubsystemData.Limits[0]++;
+    PageSize >>= 1;
 
-  for (auto Index = 0; Index < (Size - 1); Index++) {
-    Buffer[Index] = (Level - Index - 1);
   }
 
-  Buffer[Size - 1] = Target;
+  MmSubsystemData.Limits[0]--;
 
-  // Now that we know which levels we need to push to, let's extract the
-  // current node's information, before popping it from its list.
+  // Every usable memory map entry becomes its own region (or one region
+  // for each zone it covers), which has some space reserved at the start
+  // for its metadata - a free block bitmap for each level, which works
+  // out to about 2 bits per page. (The free lists themselves are stored
+  // inside of the free blocks, so they don't need any space of their own.)
 
-  allocationNode* PreviousNode = Node->Position.Previous;
-  allocationNode* NextNode = Node->Position.Next;
+  // (We use a classic buddy allocator, where every block is aligned to
+  // its own size - that way, the 'buddy' of any block can be calculated
+  // directly, by just flipping a single bit of its address.)
 
-  void* Pointer = PopBlock(Level);
+  MmSubsystemData.NumRegions = 0;
 
-  // (Sanity-check `Pointer`, just in case it didn't go well)
+  MmSubsystemData.ManagedSize = 0;
+  MmSubsystemData.MetadataSize = 0;
+  MmSubsystemData.ReclaimedSize = 0;
 
-  if (Pointer == NULL) {
-    return false;
-  }
+  MmSubsystemData.DroppedSize = 0;
+  MmSubsystemData.NumDroppedRegions = 0;
+
+  for (auto Entry = 0; Entry < NumKernelMmapEntries; Entry++) {
 
-  // Now, let's add *new* free blocks to their respective lists, as
-  // indicated by the buffer.
+    uintptr Base = KernelMmap[Entry].Base;
+    uintptr Limit = (Base + KernelMmap[Entry].Limit);
 
-  uintptr Location = (uintptr)Pointer;
+    if ((Base % SystemPageSize) != 0) {
+      Base += (SystemPageSize - (Base % SystemPageSize));
+    }
 
-  for (auto Index = 0; Index < Size; Index++) {
+    Limit -= (Limit % SystemPageSize);
 
-    // (Declare a node, and push it with `PushBlock()`
+    // Memory is also split into zones (below 1 MiB, below 4 GiB, and
+    // everything else), so that callers that need memory below a certain
+    // address can get it; if an entry crosses a zone boundary, then it's
+    // split into multiple regions, one for each zone.
 
-    allocationNode* ThisNode = (allocationNode*)Address;
-    PushBlock(ThisNode, (void*)Location, PreviousNode, NextNode, Buffer[Index]);
+    while (Base < Limit) {
 
-    // (Update `PreviousNode` to point to this node - `NextNode`
-    // shouldn't need to be updated, however)
+      uintptr Boundary = Limit;
 
-    PreviousNode = ThisNode;
+      if ((Base < LowZoneLimit) && (Boundary > LowZoneLimit)) {
+        Boundary = LowZoneLimit;
+      } else if ((Base < Dma32ZoneLimit) && (Boundary > Dma32ZoneLimit)) {
+        Boundary = Dma32ZoneLimit;
+      }
 
-    // (Update `Address` and `Location` to point to the next block)
+      AddRegion(Base, Boundary);
+      Base = Boundary;
 
-    Address += ((1ULL << Buffer[Index]) / ScalingFactor);
-    Location += (1ULL << Buffer[Index]);
+    }
 
   }
 
-  // (Now that we're done, we can safely return `true`.)
+  // (Every region is set up lazily, by Allocate(), the first time that
+  // its zone runs out of free blocks)
 
-  return true;
+  // (Update `MmSubsystemData.IsEnabled` and return true, now that
+  // we're done)
+
+  MmSubsystemData.IsEnabled = (MmSubsystemData.NumRegions != 0);
+  return MmSubsystemData.IsEnabled;
 
 }
 
 
 
-// (TODO - Join/merge a block; can be recursive)
+// (TODO - Function to test the memory management subsystem)
+
+bool VerifyMemoryManagementSubsystem(const uintptr Try) {
 
-[[nodiscard]] static inline bool MergeBlock(allocationNode* Node, uintptr Size) {
+  // (Declare a new `Size` variable with the value from Try, and
+  // try to allocate memory with it)
 
-  // (Sanity-check `Node` and `Size`, and return `false` if they
-  // don't make sense)
+  const uintptr Size = Try;
+  void* Pointer = Allocate(&Size);
 
-  if (Node == NULL) {
+  if (Pointer == NULL) {
     return false;
-  } else if (Size == 0) {
+  } else if (Size != Try) {
     return false;
   }
 
-  // Before we do anything else, let's calculate the level (logarithm) of
-  // our node, based on its size.
-
-  auto Logarithm = MmSubsystemData.Limits[0];
+  // (Now, try to free the memory block we just allocated)
 
-  while (Size > (1ULL << Logarithm)) {
-    Logarithm++;
+  if (Free(Pointer, &Size) == false) {
+    return false;
   }
 
-  // Next, let's recursively merge the previous block with this one
-  // until there are no more blocks left to merge, or until
-  // `Logarithm` goes out of bounds).
-
-  while (Logarithm < MmSubsystemData.Limits[1]) {
+  // Next, let's make sure Reallocate() works, by growing a block one
+  // level at a time (filling in each new part as we go), and then
+  // shrinking it back down again, checking its contents every time.
 
-    // Calculate the address of the previous and next nodes, and break
-    // if both are NULL.
+  uintptr Length = Try;
+  uint8* Buffer = (uint8*)Allocate(&Length);
 
-    allocationNode* Previous = Node->Position.Previous;
-    allocationNode* Next = Node->Position.Next;
+  if (Buffer == NULL) {
+    return false;
+  }
 
-    if ((Previous == NULL) && (Next == NULL)) {
-      break;
-    }
+  for (uintptr Index = 0; Index < Length; Index++) {
+    Buffer[Index] = (uint8)(Index ^ (Index >> 8));
+  }
 
-    // Compare the distance (delta) between nodes, and break if
-    // *both* adjacent nodes don't have the same size as ours.
+  for (auto Step = 0; Step < 8; Step++) {
 
-    // (This is necessary because it lets us merge blocks from *both*
-    // sides; otherwise, you'd only be able to merge from the right.)
+    // (Grow for the first four steps, and shrink for the last four)
 
-    uintptr Delta = 0;
-    auto Target = ((1ULL << Logarithm) / ScalingFactor);
+    uintptr NewLength = ((Step < 4) ? (Length * 2) : (Length / 2));
+    uint8* NewBuffer = (uint8*)Reallocate(Buffer, &Length, &NewLength);
 
-    if (Previous != NULL) {
-      Delta = ((uintptr)Node - (uintptr)Previous);
+    if (NewBuffer == NULL) {
+      [[maybe_unused]] bool Result = Free((void*)Buffer, &Length);
+      return false;
     }
 
-    if (Delta != Target) {
+    Buffer = NewBuffer;
 
-      // (Can we calculate the size of the next block?)
+    // (Check everything that was preserved, and fill in the rest)
 
-      if (Next == NULL) {
+    uintptr Preserved = ((NewLength < Length) ? NewLength : Length);
 
-        break;
+    for (uintptr Index = 0; Index < NewLength; Index++) {
 
-      } else if (Next->Position.Next == NULL) {
+      if (Index >= Preserved) {
+        Buffer[Index] = (uint8)(Index ^ (Index >> 8));
+      } else if (Buffer[Index] != (uint8)(Index ^ (Index >> 8))) {
+        [[maybe_unused]] bool Result = Free((void*)Buffer, &NewLength);
+        return false;
+      }
 
-        break;
+    }
 
-      } else {
+    Length = NewLength;
 
-        // (Attempt to calculate the size of the next free block)
+  }
 
-        Delta = ((uintptr)Next->Position.Next - (uintptr)Next);
+  // (Finally, free the block, and return the result from Free())
 
-        if (Delta != Target) {
+  return Free((void*)Buffer, &Length);
 
-          break;
+}
 
-        } else {
 
-          // (The next free block *is* just as wide, so let's move
-          // `Node` to that instead, then continue)
 
-          Previous = Node;
-          Node = Next;
+// (Find a free block in a zone that's at least (1 << BlockLevel) bytes
+// long, aligned to (1 << AlignLevel) bytes, and whose lower part (which
+// is what we'll end up keeping) ends at or below `MaxAddress`)
 
-        }
+// Usually, the first block we check fits, so this is just as fast as
+// taking the head of a list; we only need to search further when the
+// caller has asked for a specific alignment or address limit.
 
-      }
+static bool FindBlock(mmZone Zone, uint8 BlockLevel, uint8 AlignLevel, uintptr MaxAddress, uintptr* Address, uint8* Level) {
 
-    }
+  for (auto Search = BlockLevel; Search <= MmSubsystemData.Limits[1]; Search++) {
 
-    // Finally, now that we know that we *can* merge these two
-    // blocks, let's go ahead and do so. We'll need to:
+    allocationNode* Node = MmSubsystemData.Nodes[Zone][Search];
 
-    // -> (1) 'Pop' the last two nodes from their respective lists;
-    // we can't use PopBlock() since we don't know where they are.
+    while (Node != NULL) {
 
-    // (Deal with position-related links)
+      uintptr Candidate = (uintptr)Node;
 
-    allocationNode* Before = Previous->Position.Previous;
-    allocationNode* After = Node->Position.Next;
+      if (((Candidate % (1ULL << AlignLevel)) == 0) && (Candidate < MaxAddress)
+          && ((MaxAddress - Candidate) >= (1ULL << BlockLevel))) {
 
-    void* Pointer = Previous->Pointer;
+        *Address = Candidate;
+        *Level = Search;
 
-    if (Before != NULL) {
-      Before->Position.Next = After;
-    }
+        return true;
 
-    if (After != NULL) {
-      After->Position.Previous = Before;
-    }
+      }
 
-    // (Deal with size-related links, for `Previous`)
+      Node = Node->Next;
 
-    if (Previous->Size.Previous != NULL) {
-      allocationNode* Temp = Previous->Size.Previous;
-      Temp->Size.Next = Previous->Size.Next;
-    } else {
-      MmSubsystemData.Nodes[Logarithm] = Previous->Size.Next;
     }
 
-    if (Previous->Size.Next != NULL) {
-      allocationNode* Temp = Previous->Size.Next;
-      Temp->Size.Previous = Previous->Size.Previous;
-    }
+  }
 
-    // (Deal with size-related links, for `Node`)
+  return false;
+
+}
 
-    if (Node->Size.Previous != NULL) {
-      allocationNode* Temp = Node->Size.Previous;
-      Temp->Size.Next = Node->Size.Next;
-    } else {
-      MmSubsystemData.Nodes[Logarithm] = Node->Size.Next;
-    }
 
-    if (Node->Size.Next != NULL) {
-      allocationNode* Temp = Node->Size.Next;
-      Temp->Size.Previous = Node->Size.Previous;
-    }
 
-    // (Clear `Previous` and `Node`, so they don't pop up in any
-    // future searches)
+// (Set up more of a zone, by growing the first region in it that still
+// has something left to set up below `MaxAddress`; returns false if
+// there isn't one)
 
-    Memset((void*)Previous, 0, sizeof(allocationNode));
-    Memset((void*)Node, 0, sizeof(allocationNode));
+static bool GrowZone(mmZone Zone, uint8 Level, uintptr MaxAddress) {
 
-    // -> (2) 'Push' a new node to the level above, although this
-    // time using PushBlock().
+  for (auto Index = 0; Index < MmSubsystemData.NumRegions; Index++) {
 
-    Logarithm++;
-    PushBlock(Previous, Pointer, Before, After, Logarithm);
+    mmRegion* Region = &MmSubsystemData.Regions[Index];
 
-    // Finally, let's redefine `Node` to point to our previous
-    // block, and repeat the loop.
+    if ((Region->Zone != Zone) || (Region->Frontier >= MaxAddress)) {
+      continue;
+    }
 
-    Node = Previous;
-    continue;
+    if (GrowRegion(Region, Level) == true) {
+      return true;
+    }
 
   }
 
-  // (Now that we're done, we can safely return `true`.)
-
-  return true;
+  return false;
 
 }
 
 
 
-// (TODO - Kernel memory allocator, malloc(); returns `NULL` if there's
-// an issue (size == 0, lack of memory, etc.), and must be contiguous)
+// (Allocate a block that's aligned to `Alignment` bytes (a power of two,
+// or zero for page alignment), and that ends at or below `MaxAddress`
+// (or zero for no limit); see allocateFlags for the possible flags. This
+// does the actual work for Allocate() and AllocateEx())
 
-[[nodiscard]] void* Allocate(const uintptr* Length) {
+// Memory is allocated from the highest zone that `MaxAddress` allows,
+// and only falls back to the zones below it if that one is full (unless
+// AllocateFlag_NoFallback is set), so that memory below 1 MiB and 4 GiB
+// is left for the callers that actually need it.
+
+// Since every block is naturally aligned, and splitting a block always
+// keeps its lower half, aligned allocations don't waste any memory; a
+// 512-byte block aligned to 64 KiB is still only one page.
 
-  // (Sanity-check our values first - if `Length` is zero or `KernelMmap`
-  // is a null pointer (or has no entries), return NULL)
+static void* AllocateBlock(const uintptr* Length, uintptr Alignment, uintptr MaxAddress, allocateFlags Flags) {
 
-  if ((KernelMmap == NULL) || (NumKernelMmapEntries == 0)) {
+  // (Sanity-check our values first - if `Length` is zero, `Alignment`
+  // isn't a power of two, or the subsystem hasn't been initialized,
+  // return NULL)
+
+  if (MmSubsystemData.IsEnabled == false) {
     return NULL;
   } else if (Length == NULL) {
     return NULL;
   } else if (*Length == 0) {
     return NULL;
+  } else if ((Alignment & (Alignment - 1)) != 0) {
+    return NULL;
   }
 
-  uintptr Size = *Length;
-
   // Now that we know we're probably good to go, let's calculate the
-  // (minimum) block size we need to allocate.
+  // (minimum) block size we need to allocate, and the alignment.
+
+  uint8 BlockLevel = GetBlockLevel(*Length);
+  uint8 AlignLevel = GetBlockLevel(Alignment);
 
-  auto BlockLevel = MmSubsystemData.Limits[0];
+  // (If either level exceeds the maximum limit, just return NULL)
 
-  while (Size > (1ULL << BlockLevel)) {
-    BlockLevel++;
+  if ((BlockLevel > MmSubsystemData.Limits[1]) || (AlignLevel > MmSubsystemData.Limits[1])) {
+    return NULL;
   }
 
-  // (If the block level exceeds the maximum limit, just return NULL)
+  uint8 GrowLevel = ((AlignLevel > BlockLevel) ? AlignLevel : BlockLevel);
 
-  if (BlockLevel > MmSubsystemData.Limits[1]) {
-    return NULL;
+  if (MaxAddress == 0) {
+    MaxAddress = ~(uintptr)0;
   }
 
-  // The allocation system we're using uses doubly-linked lists of nodes,
-  // with one list for each 'level' (which corresponds to the amount
-  // of memory that node corresponds to).
+  // For any zone Z and level N, MmSubsystemData.Nodes[Z][N] is the head
+  // of a list of free blocks that are (1 << N) bytes long, so all we need
+  // to do is find a suitable block at or above our level.
 
-  // (Essentially, for any N, MmSubsystemData.Nodes[N] is a pointer to the last entry in
-  // a list of nodes that correspond to memory areas that are (1 << N)
-  // bytes long.)
+  // (If there aren't any, then set up more of the zone with GrowZone(),
+  // and try again, until there's nothing left to set up; after that, we
+  // fall back to the zone below it)
 
-  // That means there are two steps we need to take:
+  mmZone Zone = GetZone(MaxAddress - 1);
 
-  // -> (1) If there *aren't* any memory areas at our level, try to
-  // find a larger area we can divide)
+  uintptr Address;
+  uint8 Level;
 
-  if (MmSubsystemData.Nodes[BlockLevel] == NULL) {
+  while (FindBlock(Zone, BlockLevel, AlignLevel, MaxAddress, &Address, &Level) == false) {
 
-    for (auto Level = (BlockLevel + 1); Level <= MmSubsystemData.Limits[1]; Level++) {
+    if (GrowZone(Zone, GrowLevel, MaxAddress) == true) {
+      continue;
+    }
 
-      if (MmSubsystemData.Nodes[Level] != NULL) {
+    if ((Zone == MemoryZone_Low) || ((Flags & AllocateFlag_NoFallback) != 0)) {
+      return NULL;
+    }
 
-        bool Result = DivideBlock(MmSubsystemData.Nodes[Level], Level, BlockLevel);
+    Zone--;
 
-        if (Result == false) {
-          return NULL;
-        } else {
-          break;
-        }
+  }
 
-      }
+  // (Remove that block from its list)
 
-    }
+  mmRegion* Region = FindRegion(Address);
 
+  if (Region == NULL) {
+    return NULL;
   }
 
-  // -> (2) TODO - Use PopBlock() to actually pop it from the stack;
-  // it should return the corresponding address as well
+  RemoveBlock(Region, Address, Level);
 
-  return PopBlock(BlockLevel);
+  // If the block is larger than what we need, then split it in half until
+  // it isn't; the lower half is what we keep, and the upper half (its
+  // buddy) goes back onto the list for the level below.
 
-}
+  while (Level > BlockLevel) {
 
+    Level--;
+    PushBlock(Region, (Address + (1ULL << Level)), Level);
 
+  }
 
-// (TODO - Memory deallocator, free(); does nothing if `Pointer == NULL`)
+  // (Clear the block, if the caller asked us to)
 
-[[nodiscard]] bool Free(void* Pointer, const uintptr* Length) {
+  if ((Flags & AllocateFlag_Zero) != 0) {
+    Memset((void*)Address, 0, *Length);
+  }
 
-  // (Sanity-check our values first - if `Pointer` *or* `KernelMmap`
-  // is a null pointer (or has no entries), return false)
+  return (void*)Address;
 
-  if ((KernelMmap == NULL) || (NumKernelMmapEntries == 0)) {
-    return false;
-  } else if ((Pointer == NULL) || (Length == NULL)) {
-    return false;
-  } else if (*Length == 0) {
-    return false;
-  }
+}
 
-  uintptr Size = *Length;
 
-  // -> (1) TODO - Use FreeBlock() to actually free the block, and
-  // have it return the corresponding node.
 
-  allocationNode* Node = FreeBlock(Pointer, Size);
+// (TODO - Kernel memory allocator, malloc(); returns `NULL` if there's
+// an issue (size == 0, lack of memory, etc.), and must be contiguous)
 
-  if (Node == NULL) {
-    return false;
-  }
+[[nodiscard]] void* Allocate(const uintptr* Length) {
 
-  // -> (2) If possible, merge MmSubsystemData.Nodes[N] with any other nearby
-  // blocks (for example, two 4 KiB blocks -> one 8 KiB block).
+  void* Pointer = AllocateBlock(Length, 0, 0, AllocateFlag_None);
+
+  #ifdef TraceAllocations
+    if (Pointer != NULL) {
+      AddRecord((uintptr)Pointer, *Length, GetBlockLevel(*Length), (uintptr)__builtin_return_address(0));
+    }
+  #endif
 
-  return MergeBlock(Node, Size);
+  return Pointer;
 
 }
+
+
+
+// (Extended version of Allocate(), for memory with specific alignment or
+// address requirements; see AllocateBlock() for more information)
+
+[[nodiscard]] void* AllocateEx(const uintptr* Length, uintptr Alignment, uintptr MaxAddress, allocateFlags Flags) {
+
+  void* Pointer = AllocateBlock(Length, Alignment, MaxAddress, Flags);
+
+  #ifdef TraceAllocations
+    if (Pointer != NULL) {
+      AddRecord((uintptr)Pointer, *Length, GetBlockLevel(*Length), (uintptr)__builtin_return_address(0));
+    }
+  #endif
+
+  return Pointer;
+
+}
+
+
+
+// (TODO - Memory deallocator, free(); does nothing if `Pointer == NULL`)
+
+[[nodiscard]] bool Free(void* Pointer, const uintptr* Length) {
+
+  // (Sanity-check our values first - if `Pointer` is a null pointer, or
+  // if the subsystem hasn't been initialized, return false)
+
+  if (MmSubsystemData.IsEnabled == false) {
+    return false;
+  } else if ((Pointer == NULL) || (Length == NULL)) {
+    return false;
+  } else if (*Length == 0) {
+    return false;
+  }
+
+  // First, let's figure out which region `Pointer` belongs to, and make
+  // sure it actually points to the start of a block of that size.
+
+  uintptr Address = (uintptr)Pointer;
+  uint8 Level = GetBlockLevel(*Length);
+
+  #ifdef TraceAllocations
+
+    allocationRecord* Record = CheckRecord(Address, *Length, Level, (uintptr)__builtin_return_address(0));
+
+    if (Record == NULL) {
+      return false;
+    }
+
+    RemoveRecord(Record);
+
+  #endif
+
+  mmRegion* Region = FindRegion(Address);
+
+  if (Region == NULL) {
+    return false;
+  } else if (Level > MmSubsystemData.Limits[1]) {
+    return false;
+  } else if ((Address % (1ULL << Level)) != 0) {
+    return false;
+  } else if ((Address >= Region->Frontier) || ((Region->Frontier - Address) < (1ULL << Level))) {
+    return false;
+  }
+
+  // (If the block is already free, then this is a double free)
+
+  if (IsBlockFree(Region, Address, Level) == true) {
+    return false;
+  }
+
+  // (Otherwise, merge it with its buddies and push it onto its list)
+
+  ReleaseBlock(Region, Address, Level);
+  return true;
+
+}
+
+
+
+// (Resize a block from Allocate(), from `OldLength` to `NewLength` bytes;
+// returns the (possibly different) new pointer, or NULL if there's an
+// issue, in which case the old block is left untouched)
+
+// Whenever possible, this happens in-place - shrinking a block just
+// splits it and frees the upper halves, and growing a block absorbs its
+// buddies, as long as they're free (and it's the lower half of each
+// pair). Only when that isn't possible do we allocate a new block, copy
+// everything over, and free the old one.
+
+[[nodiscard]] void* Reallocate(void* Pointer, const uintptr* OldLength, const uintptr* NewLength) {
+
+  // (Sanity-check our values first; a null pointer just means that we
+  // need to allocate a new block)
+
+  if (MmSubsystemData.IsEnabled == false) {
+    return NULL;
+  } else if ((OldLength == NULL) || (NewLength == NULL)) {
+    return NULL;
+  } else if (*NewLength == 0) {
+    return NULL;
+  } else if (Pointer == NULL) {
+    return Allocate(NewLength);
+  } else if (*OldLength == 0) {
+    return NULL;
+  }
+
+  // First, let's figure out which region `Pointer` belongs to, and make
+  // sure it actually points to the start of an allocated block (the same
+  // checks as in Free()).
+
+  uintptr Address = (uintptr)Pointer;
+
+  uint8 OldLevel = GetBlockLevel(*OldLength);
+  uint8 NewLevel = GetBlockLevel(*NewLength);
+
+  #ifdef TraceAllocations
+
+    allocationRecord* Record = CheckRecord(Address, *OldLength, OldLevel, (uintptr)__builtin_return_address(0));
+
+    if (Record == NULL) {
+      return NULL;
+    }
+
+  #endif
+
+  mmRegion* Region = FindRegion(Address);
+
+  if (Region == NULL) {
+    return NULL;
+  } else if ((OldLevel > MmSubsystemData.Limits[1]) || (NewLevel > MmSubsystemData.Limits[1])) {
+    return NULL;
+  } else if ((Address % (1ULL << OldLevel)) != 0) {
+    return NULL;
+  } else if ((Address >= Region->Frontier) || ((Region->Frontier - Address) < (1ULL << OldLevel))) {
+    return NULL;
+  } else if (IsBlockFree(Region, Address, OldLevel) == true) {
+    return NULL;
+  }
+
+  // (If the block doesn't need to change size, we're already done; if it
+  // needs to shrink, split it, and free every upper half)
+
+  #ifdef TraceAllocations
+    if (NewLevel <= OldLevel) {
+      Record->Length = *NewLength;
+      Record->Level = NewLevel;
+    }
+  #endif
+
+  if (NewLevel == OldLevel) {
+    return Pointer;
+  }
+
+  if (NewLevel < OldLevel) {
+
+    for (uint8 Level = OldLevel; Level > NewLevel; Level--) {
+      PushBlock(Region, (Address + (1ULL << (Level - 1))), (Level - 1));
+    }
+
+    return Pointer;
+
+  }
+
+  // If it needs to grow, check if we can do so in-place - that is, if
+  // the block is aligned to its new size, and each of the buddies it'd
+  // need to absorb (one at every level in between) is free.
+
+  // (If the new block would go past the frontier, try to grow the region
+  // first, so we don't miss out on memory that hasn't been set up yet)
+
+  uintptr NewSize = (1ULL << NewLevel);
+  bool CanGrowInPlace = ((Address % NewSize) == 0);
+
+  if ((CanGrowInPlace == true) && ((Region->End - Address) < NewSize)) {
+    CanGrowInPlace = false;
+  }
+
+  if ((CanGrowInPlace == true) && ((Region->Frontier - Address) < NewSize)) {
+    GrowRegion(Region, NewLevel);
+  }
+
+  for (uint8 Level = OldLevel; (CanGrowInPlace == true) && (Level < NewLevel); Level++) {
+
+    if (IsBlockFree(Region, (Address + (1ULL << Level)), Level) == false) {
+      CanGrowInPlace = false;
+    }
+
+  }
+
+  if (CanGrowInPlace == true) {
+
+    for (uint8 Level = OldLevel; Level < NewLevel; Level++) {
+      RemoveBlock(Region, (Address + (1ULL << Level)), Level);
+    }
+
+    #ifdef TraceAllocations
+      Record->Length = *NewLength;
+      Record->Level = NewLevel;
+    #endif
+
+    return Pointer;
+
+  }
+
+  // Otherwise, we have no choice but to allocate a new block, copy the
+  // old block's contents over, and then free it.
+
+  void* NewPointer = Allocate(NewLength);
+
+  if (NewPointer == NULL) {
+    return NULL;
+  }
+
+  Memcpy(NewPointer, Pointer, *OldLength);
+
+  [[maybe_unused]] bool Result = Free(Pointer, OldLength);
+  return NewPointer;
+
+}
+
+
+
+// (Calculate the external fragmentation ratio of free memory, in tenths
+// of a percent (so we don't need floating-point numbers); this is how
+// much of the free memory *can't* be allocated in one go)
+
+static uint64 GetFragmentationRatio(uint64 TotalFree, uint64 LargestFree) {
+
+  if (TotalFree == 0) {
+    return 0;
+  }
+
+  return (1000 - ((LargestFree * 1000) / TotalFree));
+
+}
+
+
+
+// (Show how fragmented free memory currently is - the number of free
+// blocks at each level, the largest free block, and the external
+// fragmentation ratio, which is how much of the free memory *can't* be
+// allocated in one go (0% means it's all in one block))
+
+// This doesn't include memory that hasn't been set up yet by GrowRegion(),
+// since that's always contiguous, but it's shown separately.
+
+void PrintFragmentationReport(void) {
+
+  uint64 TotalFree = 0;
+  uint64 LargestFree = 0;
+  uint64 NumBlocks = 0;
+
+  for (auto Level = MmSubsystemData.Limits[0]; Level <= MmSubsystemData.Limits[1]; Level++) {
+
+    uint64 Num = 0;
+
+    for (uint8 Zone = 0; Zone < NumMemoryZones; Zone++) {
+
+      for (allocationNode* Node = MmSubsystemData.Nodes[Zone][Level]; Node != NULL; Node = Node->Next) {
+        Num++;
+      }
+
+    }
+
+    if (Num != 0) {
+
+      Message(Info, "Found %d free blocks at level [%d] (%d KiB each)", Num, (uint64)Level,
+                    ((1ULL << Level) / 1024));
+
+      TotalFree += (Num << Level);
+      LargestFree = (1ULL << Level);
+      NumBlocks += Num;
+
+    }
+
+  }
+
+  uint64 NotSetUp = 0;
+
+  for (auto Index = 0; Index < MmSubsystemData.NumRegions; Index++) {
+    NotSetUp += (MmSubsystemData.Regions[Index].End - MmSubsystemData.Regions[Index].Frontier);
+  }
+
+  uint64 Ratio = GetFragmentationRatio(TotalFree, LargestFree);
+
+  Message(Info, "%d KiB free in %d blocks (largest is %d KiB), plus %d KiB not set up yet",
+                (TotalFree / 1024), NumBlocks, (LargestFree / 1024), (NotSetUp / 1024));
+
+  Message(Info, "External fragmentation ratio is %d.%d%%", (Ratio / 10), (Ratio % 10));
+
+}
+
+
+
+// (Show every allocation that hasn't been freed yet, along with who
+// allocated it and when; this only works with TraceAllocations)
+
+void PrintAllocationTrace(void) {
+
+  #ifdef TraceAllocations
+
+    uint64 TotalLength = 0;
+
+    for (uintptr Index = 0; Index < MaxAllocationRecords; Index++) {
+
+      const allocationRecord* Record = &AllocationRecords[Index];
+
+      if (Record->Address <= 1) {
+        continue;
+      }
+
+      Message(Info, "Block at %xh (%d bytes, level %d) was allocated by %xh, at timestamp %d",
+                    Record->Address, Record->Length, (uint64)Record->Level, Record->Caller,
+                    Record->Timestamp);
+
+      TotalLength += Record->Length;
+
+    }
+
+    Message(Info, "%d allocations (%d KiB in total) haven't been freed yet",
+                  (uint64)NumAllocationRecords, (TotalLength / 1024));
+
+  #else
+
+    Message(Info, "Allocation tracing is disabled (see TraceAllocations in makefile.config)");
+
+  #endif
+
+}
+
+
+
+// (Update the record for a block that was allocated on someone else's
+// behalf (like the blocks in the zero pool), so it shows the length and
+// caller it's actually being used for; this only works with
+// TraceAllocations, and does nothing otherwise)
+
+void RetraceAllocation([[maybe_unused]] void* Pointer, [[maybe_unused]] uintptr Length, [[maybe_unused]] uintptr Caller) {
+
+  #ifdef TraceAllocations
+
+    allocationRecord* Record = FindRecord((uintptr)Pointer);
+
+    if (Record != NULL) {
+
+      Record->Length = Length;
+      Record->Caller = Caller;
+
+    }
+
+  #endif
+
+}
+
+
+
+#ifdef StressTestAllocator
+
+  // When StressTestAllocator is defined (see makefile.config), the kernel
+  // runs a few randomized workloads through Allocate(), Reallocate() and
+  // Free() at boot, checking the allocator's internal state after every
+  // single operation, and showing how long each workload took and how
+  // fragmented it left memory. Without it, none of this is compiled in.
+
+  // The same workloads can also be run on a Linux host, without booting
+  // at all, with the harness in Common/Host (see `make fuzz`).
+
+  typedef struct _stressTestSlot {
+
+    uint8* Pointer; // (The block we allocated, or NULL)
+    uintptr Length; // (The length we allocated it with)
+    uint8 Pattern; // (The byte we filled it with)
+
+  } stressTestSlot;
+
+  static uint64 StressTestSeed = 0;
+  static uint64 StressTestTicks = 0; // (Only counts time spent in Allocate(), Reallocate() and Free())
+
+  static uint64 StressTestNumInPlace = 0; // (How many Reallocate() calls kept the same block)
+  static uint64 StressTestNumMoved = 0; // (How many Reallocate() calls had to move it elsewhere)
+
+  // (Generate a pseudo-random number, using xorshift64)
+
+  static inline uint64 GetRandomNumber(void) {
+
+    StressTestSeed ^= (StressTestSeed << 13);
+    StressTestSeed ^= (StressTestSeed >> 7);
+    StressTestSeed ^= (StressTestSeed << 17);
+
+    return StressTestSeed;
+
+  }
+
+  // (Check that the allocator's internal state is consistent - every
+  // block on a free list has to be in a region of the right zone,
+  // aligned, set up, marked as free in its bitmap, linked properly, and
+  // not mergeable with its buddy; returns false if not)
+
+  static bool CheckAllocatorInvariants(void) {
+
+    for (uint8 Zone = 0; Zone < NumMemoryZones; Zone++) {
+
+      for (auto Level = MmSubsystemData.Limits[0]; Level <= MmSubsystemData.Limits[1]; Level++) {
+
+        allocationNode* Previous = NULL;
+        uint64 Limit = ((MmSubsystemData.ManagedSize >> Level) + 1);
+
+        for (allocationNode* Node = MmSubsystemData.Nodes[Zone][Level]; Node != NULL; Node = Node->Next) {
+
+          uintptr Address = (uintptr)Node;
+          mmRegion* Region = FindRegion(Address);
+
+          if ((Region == NULL) || (Region->Zone != Zone)) {
+            Message(Fail, "Free block at %xh (level %d) isn't in a region of the right zone.", Address, (uint64)Level);
+            return false;
+          } else if ((Address % (1ULL << Level)) != 0) {
+            Message(Fail, "Free block at %xh (level %d) isn't aligned.", Address, (uint64)Level);
+            return false;
+          } else if ((Address >= Region->Frontier) || ((Region->Frontier - Address) < (1ULL << Level))) {
+            Message(Fail, "Free block at %xh (level %d) hasn't been set up yet.", Address, (uint64)Level);
+            return false;
+          } else if (IsBlockFree(Region, Address, Level) == false) {
+            Message(Fail, "Free block at %xh (level %d) isn't marked as free.", Address, (uint64)Level);
+            return false;
+          } else if (Node->Previous != Previous) {
+            Message(Fail, "Free block at %xh (level %d) isn't linked properly.", Address, (uint64)Level);
+            return false;
+          } else if ((Level < MmSubsystemData.Limits[1]) && (IsBlockFree(Region, (Address ^ (1ULL << Level)), Level) == true)) {
+            Message(Fail, "Free block at %xh (level %d) wasn't merged with its buddy.", Address, (uint64)Level);
+            return false;
+          }
+
+          // (Make sure we don't get stuck in a loop, if the list is
+          // somehow circular)
+
+          if (Limit-- == 0) {
+            Message(Fail, "Free list for level %d is longer than it should be.", (uint64)Level);
+            return false;
+          }
+
+          Previous = Node;
+
+        }
+
+      }
+
+    }
+
+    return true;
+
+  }
+
+  // (Calculate the total amount of free memory, and the size of the
+  // largest free block)
+
+  static void GetFreeMemory(uint64* TotalFree, uint64* LargestFree) {
+
+    *TotalFree = 0;
+    *LargestFree = 0;
+
+    for (uint8 Zone = 0; Zone < NumMemoryZones; Zone++) {
+
+      for (auto Level = MmSubsystemData.Limits[0]; Level <= MmSubsystemData.Limits[1]; Level++) {
+
+        for (allocationNode* Node = MmSubsystemData.Nodes[Zone][Level]; Node != NULL; Node = Node->Next) {
+
+          *TotalFree += (1ULL << Level);
+
+          if ((1ULL << Level) > *LargestFree) {
+            *LargestFree = (1ULL << Level);
+          }
+
+        }
+
+      }
+
+    }
+
+  }
+
+  // (Calculate how much memory the allocator could still hand out; this
+  // includes the parts of each region that haven't been set up yet, since
+  // GrowRegion() can move memory from there onto the free lists at any
+  // point, which would otherwise hide leaks)
+
+  static uint64 GetAvailableMemory(void) {
+
+    uint64 TotalFree, LargestFree;
+    GetFreeMemory(&TotalFree, &LargestFree);
+
+    for (uint16 Index = 0; Index < MmSubsystemData.NumRegions; Index++) {
+
+      const mmRegion* Region = &MmSubsystemData.Regions[Index];
+      TotalFree += (Region->End - Region->Frontier);
+
+    }
+
+    return TotalFree;
+
+  }
+
+  // (Allocate a block for a slot, and fill it with a random pattern;
+  // running out of memory isn't an error, so this only returns false if
+  // the allocator's state is inconsistent afterwards)
+
+  static bool StressTestAllocate(stressTestSlot* Slot, uintptr Length, uint64* NumFailed) {
+
+    Slot->Length = Length;
+
+    uint64 Start = ReadTimestampCounter();
+    Slot->Pointer = (uint8*)Allocate(&Slot->Length);
+    StressTestTicks += (ReadTimestampCounter() - Start);
+
+    Slot->Pattern = (uint8)GetRandomNumber();
+
+    if (Slot->Pointer == NULL) {
+      (*NumFailed)++;
+    } else {
+      Memset((void*)Slot->Pointer, Slot->Pattern, Length);
+    }
+
+    return CheckAllocatorInvariants();
+
+  }
+
+  // (Check that a slot's block still has its pattern, and free it;
+  // returns false if anything went wrong)
+
+  static bool StressTestFree(stressTestSlot* Slot) {
+
+    if (Slot->Pointer == NULL) {
+      return true;
+    }
+
+    for (uintptr Index = 0; Index < Slot->Length; Index++) {
+
+      if (Slot->Pointer[Index] != Slot->Pattern) {
+        Message(Fail, "Block at %xh was overwritten (at offset %xh).", (uintptr)Slot->Pointer, Index);
+        return false;
+      }
+
+    }
+
+    uint64 Start = ReadTimestampCounter();
+    bool Result = Free((void*)Slot->Pointer, &Slot->Length);
+    StressTestTicks += (ReadTimestampCounter() - Start);
+
+    if (Result == false) {
+      Message(Fail, "Couldn't free block at %xh (%d bytes).", (uintptr)Slot->Pointer, Slot->Length);
+      return false;
+    }
+
+    Slot->Pointer = NULL;
+    return CheckAllocatorInvariants();
+
+  }
+
+  // (Resize a slot's block with Reallocate(), check that everything that
+  // fits in both the old and new lengths kept its pattern, and refill it
+  // with a new one; if Reallocate() fails, the old block has to be left
+  // alone, so it's checked later on like any other block)
+
+  static bool StressTestReallocate(stressTestSlot* Slot, uintptr Length, uint64* NumFailed) {
+
+    uint64 Start = ReadTimestampCounter();
+    uint8* Pointer = (uint8*)Reallocate((void*)Slot->Pointer, &Slot->Length, &Length);
+    StressTestTicks += (ReadTimestampCounter() - Start);
+
+    if (Pointer == NULL) {
+      (*NumFailed)++;
+      return CheckAllocatorInvariants();
+    }
+
+    if (Pointer == Slot->Pointer) {
+      StressTestNumInPlace++;
+    } else {
+      StressTestNumMoved++;
+    }
+
+    uintptr Preserved = min(Slot->Length, Length);
+
+    for (uintptr Index = 0; Index < Preserved; Index++) {
+
+      if (Pointer[Index] != Slot->Pattern) {
+        Message(Fail, "Block at %xh lost its contents when it was reallocated to %xh (at offset %xh).",
+                      (uintptr)Slot->Pointer, (uintptr)Pointer, Index);
+        return false;
+      }
+
+    }
+
+    Slot->Pointer = Pointer;
+    Slot->Length = Length;
+    Slot->Pattern = (uint8)GetRandomNumber();
+
+    Memset((void*)Slot->Pointer, Slot->Pattern, Length);
+    return CheckAllocatorInvariants();
+
+  }
+
+  // (Run a single operation from a given workload; returns false if
+  // anything went wrong)
+
+  static bool RunStressTestOperation(stressTestWorkload Workload, stressTestSlot* Slots, uint32 NumSlots,
+                                     uint32 Operation, uint32* Top, uint64* NumFailed) {
+
+    uint64 Random = GetRandomNumber();
+
+    switch (Workload) {
+
+      // (Pick a random slot, and a size that depends on the workload; if
+      // the slot is in use, either free it or (one time in four) resize
+      // it to that size, and otherwise, allocate a block for it)
+
+      case StressTest_Uniform:
+      case StressTest_PowerLaw: {
+
+        stressTestSlot* Slot = &Slots[Random % NumSlots];
+        uintptr Length = (1 + ((Random >> 16) % 0x10000));
+
+        if (Workload == StressTest_PowerLaw) {
+
+          uint8 Order = (uint8)__builtin_ctzll((Random >> 32) | (1ULL << 10));
+          Length = (1 + ((Random >> 16) % (SystemPageSize << Order)));
+
+        }
+
+        if (Slot->Pointer == NULL) {
+          return StressTestAllocate(Slot, Length, NumFailed);
+        } else if (((Random >> 12) & 3) == 0) {
+          return StressTestReallocate(Slot, Length, NumFailed);
+        }
+
+        return StressTestFree(Slot);
+
+      }
+
+      // (Either push or pop a block, like a stack)
+
+      case StressTest_Lifo: {
+
+        if ((*Top < NumSlots) && (((Random & 1) == 0) || (*Top == 0))) {
+
+          uintptr Length = (1 + ((Random >> 16) % 0x10000));
+          return StressTestAllocate(&Slots[(*Top)++], Length, NumFailed);
+
+        }
+
+        return StressTestFree(&Slots[--(*Top)]);
+
+      }
+
+      // (Fill every slot with a single page, then free every other slot,
+      // then try to fill those slots with two pages each (which can't
+      // reuse any of the holes we just left), and so on)
+
+      case StressTest_Fragmenting: {
+
+        stressTestSlot* Slot = &Slots[Operation % NumSlots];
+
+        if (Operation < NumSlots) {
+          return StressTestAllocate(Slot, SystemPageSize, NumFailed);
+        } else if ((Operation % 2) == 0) {
+          return true;
+        } else if (Slot->Pointer != NULL) {
+          return StressTestFree(Slot);
+        }
+
+        return StressTestAllocate(Slot, (SystemPageSize * 2), NumFailed);
+
+      }
+
+      default:
+        return false;
+
+    }
+
+  }
+
+  // (Run every workload, `NumOperations` operations each, and show the
+  // results; returns false if anything went wrong)
+
+  // Every workload draws from the same pseudo-random sequence, which
+  // starts at `Seed`; if that's 0, we pick one from the timestamp counter
+  // instead. Either way, it's shown before anything else, so a failing
+  // run can be reproduced by passing the same seed again.
+
+  // The timings only count the time spent inside Allocate(), Reallocate()
+  // and Free(), not the checks; they're shown in operations per second if
+  // we know the frequency of the timestamp counter, or in ticks per
+  // operation if not (which is still useful for comparing versions of the
+  // allocator on the same machine).
+
+  bool StressTestMemoryManagementSubsystem(uint32 NumOperations, uint64 Seed) {
+
+    const char* Names[NumStressTestWorkloads] = {"uniform", "power-law", "LIFO", "fragmenting"};
+
+    if ((MmSubsystemData.IsEnabled == false) || (NumOperations == 0)) {
+      return false;
+    }
+
+    // (Allocate space for our slots, which need to start out cleared)
+
+    const uint32 NumSlots = 1024;
+    const uintptr SlotsSize = (NumSlots * sizeof(stressTestSlot));
+
+    stressTestSlot* Slots = (stressTestSlot*)AllocateZeroed(&SlotsSize);
+
+    if (Slots == NULL) {
+      return false;
+    }
+
+    if (Seed == 0) {
+      Seed = (ReadTimestampCounter() | 1);
+    }
+
+    StressTestSeed = Seed;
+    Message(Info, "Stress testing the allocator with seed %xh (%d operations per workload)", Seed, (uint64)NumOperations);
+
+    uint64 Frequency = GetTimestampFrequency();
+    bool Status = CheckAllocatorInvariants();
+
+    for (uint8 Workload = 0; (Status == true) && (Workload < NumStressTestWorkloads); Workload++) {
+
+      uint64 InitialAvailable = GetAvailableMemory();
+
+      // (Run the workload itself)
+
+      uint32 Top = 0;
+      uint64 NumFailed = 0;
+
+      StressTestTicks = 0;
+      StressTestNumInPlace = 0;
+      StressTestNumMoved = 0;
+
+      for (uint32 Operation = 0; (Status == true) && (Operation < NumOperations); Operation++) {
+        Status = RunStressTestOperation(Workload, Slots, NumSlots, Operation, &Top, &NumFailed);
+      }
+
+      uint64 Ticks = StressTestTicks;
+
+      // (Measure fragmentation *before* cleaning up, since that's what
+      // the workload actually left behind)
+
+      uint64 TotalFree, LargestFree;
+      GetFreeMemory(&TotalFree, &LargestFree);
+
+      uint64 Ratio = GetFragmentationRatio(TotalFree, LargestFree);
+
+      // (Free every slot that's still in use, and make sure that all of
+      // the memory we started with came back)
+
+      for (uint32 Index = 0; (Status == true) && (Index < NumSlots); Index++) {
+        Status = StressTestFree(&Slots[Index]);
+      }
+
+      uint64 Available = GetAvailableMemory();
+
+      if ((Status == true) && (Available != InitialAvailable)) {
+
+        Message(Fail, "The %s workload leaked %d KiB of memory.", Names[Workload],
+                      (((InitialAvailable > Available) ? (InitialAvailable - Available) : (Available - InitialAvailable)) / 1024));
+
+        Status = false;
+
+      }
+
+      if (Ticks == 0) {
+        Ticks = 1;
+      }
+
+      if (Frequency != 0) {
+
+        Message(Info, "Ran the %s workload: %d operations (%d failed), %d operations per second, %d.%d%% fragmentation",
+                      Names[Workload], (uint64)NumOperations, NumFailed, ((NumOperations * Frequency) / Ticks),
+                      (Ratio / 10), (Ratio % 10));
+
+      } else {
+
+        Message(Info, "Ran the %s workload: %d operations (%d failed), %d ticks per operation, %d.%d%% fragmentation",
+                      Names[Workload], (uint64)NumOperations, NumFailed, (Ticks / NumOperations),
+                      (Ratio / 10), (Ratio % 10));
+
+      }
+
+      // (Show how many blocks Reallocate() could resize in place, since
+      // that's the whole point of it, compared to how many it had to move)
+
+      if ((StressTestNumInPlace + StressTestNumMoved) != 0) {
+
+        Message(Info, "The %s workload reallocated %d blocks (%d in place, %d moved)", Names[Workload],
+                      (StressTestNumInPlace + StressTestNumMoved), StressTestNumInPlace, StressTestNumMoved);
+
+      }
+
+    }
+
+    // (Free our slots, and return)
+
+    if (Free((void*)Slots, &SlotsSize) == false) {
+      return false;
+    }
+
+    return Status;
+
+  }
+
+#endif
@@ -0,0 +1,709 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "../Libraries/Stdint.h"
+#include "../Libraries/String.h"
+#include "../System/System.h"
+#include "../../Common.h"
+#include "Memory.h"
+
+// The kernel starts out with whatever page tables the bootloader (or on
+// EFI systems, the firmware) left it with, which identity-map everything
+// we need, but which we can't safely modify - some firmware even marks
+// its own page tables as read-only.
+
+// This file lets the kernel manage its own page tables instead. It takes
+// over by copying the current PML4 into one of its own, and then copies
+// any lower-level tables the first time it needs to modify them (marking
+// the entries that point to them with PageEntryOwned); that way, nothing
+// the bootloader left behind ever gets modified in place.
+
+// Every page table is identity-mapped, like the rest of the kernel's
+// memory, so physical and virtual table addresses are the same.
+
+pagingSubsystemData PagingSubsystemData = {0};
+
+#if defined(__amd64__) || defined(__x86_64__)
+
+  // (The PAT layout we use; this is the same as the default layout,
+  // except that PAT4 is write-combining instead of write-back, and it's
+  // also what the BIOS bootloader sets up)
+
+  // Each byte is one entry, starting from PAT0 - from lowest to highest,
+  // that's WB (06h), WT (04h), UC- (07h), UC (00h), WC (01h), WT (04h),
+  // UC- (07h) and UC (00h).
+
+  #define PatMsr 0x277
+  #define PatValue 0x0007040100070406
+
+  // (The PAT index for each cache type - WB (0), WT (1), UC (3) and WC (4);
+  // without PAT support, write-combining falls back to uncached)
+
+  static const uint8 PatIndices[NumCacheTypes] = {0, 1, 3, 4};
+
+  // (If we need to invalidate more than this many pages at once, it's
+  // faster to flush the whole TLB instead)
+
+  #define MaxInvalidatedPages 64
+
+  // (The most page tables we can hold on to before they're actually freed;
+  // see FreePageTable())
+
+  #define MaxPendingTables 64
+
+  static uint64* PendingTables[MaxPendingTables];
+  static uint16 NumPendingTables = 0;
+
+
+
+  // (Calculate the size of a page mapped at a given level (1 for page
+  // table entries, 2 for page directory entries, 3 for PDPT entries))
+
+  static inline uint64 GetPageSize(uint8 Level) {
+    return (SystemPageSize << (9 * (Level - 1)));
+  }
+
+  // (Calculate the index of the entry that maps `Virtual` at a given level)
+
+  static inline uint16 GetEntryIndex(uint64 Virtual, uint8 Level) {
+    return (uint16)((Virtual >> (12 + (9 * (Level - 1)))) % 512);
+  }
+
+  // (Get the physical address an entry points to; large pages use fewer
+  // bits, since bit 12 is the PAT bit)
+
+  static inline uint64 GetEntryAddress(uint64 Entry, uint8 Level) {
+
+    if ((Level > 1) && ((Entry & PageEntryLarge) != 0)) {
+      return (Entry & PageEntryAddressMask & ~(GetPageSize(Level) - 1));
+    }
+
+    return (Entry & PageEntryAddressMask);
+
+  }
+
+  // (Get the bits that select a given cache type, for either a regular
+  // (4 KiB) page or a large one)
+
+  static inline uint64 GetCacheBits(cacheType Type, bool IsLargePage) {
+
+    uint8 Index = PatIndices[Type];
+
+    if ((PagingSubsystemData.SupportsPat == false) && (Index >= 4)) {
+      Index = PatIndices[CacheType_Uncached];
+    }
+
+    uint64 Bits = 0;
+
+    if ((Index & 1) != 0) {
+      Bits |= PageEntryWriteThrough;
+    }
+
+    if ((Index & 2) != 0) {
+      Bits |= PageEntryCacheDisable;
+    }
+
+    if ((Index & 4) != 0) {
+      Bits |= ((IsLargePage == true) ? PageEntryLargePat : PageEntryPat);
+    }
+
+    return Bits;
+
+  }
+
+
+
+  // (Allocate a new (zeroed-out) page table, either from the frame
+  // allocator or from the heap; returns NULL if we're out of memory)
+
+  static uint64* AllocatePageTable(void) {
+
+    uint64* Table;
+
+    if (FrameAllocatorData.IsEnabled == true) {
+
+      Table = (uint64*)AllocateFrame(FrameOrder_4KiB);
+
+      if (Table != NULL) {
+        Memset((void*)Table, 0, SystemPageSize);
+      }
+
+    } else {
+
+      // (Blocks from the heap are always aligned to their own size, so
+      // this is page-aligned, even if it comes from the zero pool)
+
+      const uintptr Size = SystemPageSize;
+      Table = (uint64*)AllocateZeroed(&Size);
+
+    }
+
+    if (Table != NULL) {
+      PagingSubsystemData.NumTables++;
+    }
+
+    return Table;
+
+  }
+
+  // (Copy a table we don't own into one of our own; PageEntryOwned is an
+  // available bit, so firmware might use it for something else, and we
+  // need to clear it in every entry so we don't treat any of the tables
+  // it points to as ours)
+
+  static void CopyPageTable(uint64* Table, const uint64* Source) {
+
+    for (uint16 Index = 0; Index < 512; Index++) {
+      Table[Index] = (Source[Index] & ~PageEntryOwned);
+    }
+
+  }
+
+  // (Flush every entry in the TLB, including global ones; reloading CR3
+  // doesn't flush global pages, so if those are enabled (CR4.PGE, bit
+  // 7), we toggle CR4.PGE instead, which flushes everything)
+
+  static void FlushTlb(void) {
+
+    uint64 Cr4 = ReadFromControlRegister(4, false);
+
+    if ((Cr4 & (1ULL << 7)) != 0) {
+
+      WriteToControlRegister(4, false, (Cr4 & ~(1ULL << 7)));
+      WriteToControlRegister(4, false, Cr4);
+
+    } else {
+
+      WriteToControlRegister(3, false, ReadFromControlRegister(3, false));
+
+    }
+
+  }
+
+  // (Actually free every page table FreePageTable() queued up; this
+  // should only be called once the TLB has been invalidated for the
+  // areas they used to map)
+
+  static void ReleasePageTables(void) {
+
+    for (uint16 Index = 0; Index < NumPendingTables; Index++) {
+
+      if (FrameAllocatorData.IsEnabled == true) {
+        [[maybe_unused]] bool Result = FreeFrame((void*)PendingTables[Index], FrameOrder_4KiB);
+      } else {
+        const uintptr Size = SystemPageSize;
+        [[maybe_unused]] bool Result = Free((void*)PendingTables[Index], &Size);
+      }
+
+      PagingSubsystemData.NumTables--;
+
+    }
+
+    NumPendingTables = 0;
+
+  }
+
+  // (Free a page table we allocated, along with any tables *it* points
+  // to that we also own)
+
+  // Until the TLB is invalidated, the CPU might still walk through this
+  // table (its paging-structure caches can point straight to it), so we
+  // can't reuse it yet; instead, it's queued up, and freed later on by
+  // ReleasePageTables(). If the queue is full, we flush the whole TLB,
+  // and free everything in it early.
+
+  static void FreePageTable(uint64* Table, uint8 Level) {
+
+    if (Level > 1) {
+
+      for (uint16 Index = 0; Index < 512; Index++) {
+
+        uint64 Entry = Table[Index];
+
+        if (((Entry & PageEntryPresent) != 0) && ((Entry & PageEntryLarge) == 0) && ((Entry & PageEntryOwned) != 0)) {
+          FreePageTable((uint64*)GetEntryAddress(Entry, Level), (Level - 1));
+        }
+
+      }
+
+    }
+
+    if (NumPendingTables >= MaxPendingTables) {
+
+      FlushTlb();
+      ReleasePageTables();
+
+    }
+
+    PendingTables[NumPendingTables] = Table;
+    NumPendingTables++;
+
+  }
+
+
+
+  /* static uint64* GetNextTable()
+
+     Inputs: uint64* Entry - The entry that points to (or should point to)
+             the next table down.
+
+             uint8 Level - The level of the table `Entry` is in (4 for the
+             PML4, 3 for a PDPT, and 2 for a page directory).
+
+     Outputs: uint64* - The table `Entry` points to, which we're always
+              allowed to modify, or NULL if we ran out of memory.
+
+     This function makes sure that `Entry` points to a table we own, so
+     we can safely modify it; if it doesn't point to anything yet, it
+     allocates a new table, and if it points to a table we don't own (like
+     one the firmware created), it copies it first.
+
+     If `Entry` maps a large page instead, this splits it into a table of
+     smaller pages that map the same area, with the same flags.
+
+  */
+
+  static uint64* GetNextTable(uint64* Entry, uint8 Level) {
+
+    uint64 Value = *Entry;
+
+    // (If this entry already points to a table we own, just return that)
+
+    if (((Value & PageEntryPresent) != 0) && ((Value & PageEntryLarge) == 0) && ((Value & PageEntryOwned) != 0)) {
+      return (uint64*)GetEntryAddress(Value, Level);
+    }
+
+    // Otherwise, we need to allocate a new table, and fill it out.
+
+    uint64* Table = AllocatePageTable();
+
+    if (Table == NULL) {
+      return NULL;
+    }
+
+    if ((Value & PageEntryPresent) == 0) {
+
+      // (If the entry isn't present, leave the new table empty)
+
+      *Entry = ((uint64)Table | PageEntryPresent | PageEntryWritable | PageEntryOwned);
+
+    } else if ((Value & PageEntryLarge) != 0) {
+
+      // (If the entry is a large page, split it up; smaller pages keep
+      // the same flags, except that 4 KiB pages use a different PAT bit,
+      // and don't have PageEntryLarge set)
+
+      uint64 Address = GetEntryAddress(Value, Level);
+      uint64 Flags = (Value & ~(PageEntryAddressMask & ~(GetPageSize(Level) - 1)));
+      Flags &= ~PageEntryOwned;
+
+      if ((Level - 1) == 1) {
+
+        bool HasPat = ((Flags & PageEntryLargePat) != 0);
+
+        Flags &= ~(PageEntryLarge | PageEntryLargePat);
+        Flags |= ((HasPat == true) ? PageEntryPat : 0);
+
+      }
+
+      for (uint16 Index = 0; Index < 512; Index++) {
+        Table[Index] = ((Address + (Index * GetPageSize(Level - 1))) | Flags);
+      }
+
+      *Entry = ((uint64)Table | PageEntryPresent | PageEntryWritable | PageEntryOwned);
+      PagingSubsystemData.NumSplitPages++;
+
+    } else {
+
+      // (If the entry points to a table we don't own, copy it, and keep
+      // the same flags)
+
+      CopyPageTable(Table, (const uint64*)GetEntryAddress(Value, Level));
+      *Entry = ((uint64)Table | (Value & ~PageEntryAddressMask) | PageEntryOwned);
+
+    }
+
+    return Table;
+
+  }
+
+
+
+  /* static void TryPromoteTable()
+
+     Inputs: uint64* Entry - The entry that points to the table we want to
+             promote.
+
+             uint8 Level - The level of the table `Entry` is in (2 or 3).
+
+     Outputs: (None)
+
+     This function checks whether every entry in the table `Entry` points
+     to maps one contiguous area, with the same flags, and if so, replaces
+     the whole table with a single large page (2 MiB or 1 GiB), which
+     saves a table and a lot of TLB entries.
+
+  */
+
+  static void TryPromoteTable(uint64* Entry, uint8 Level) {
+
+    uint64 Value = *Entry;
+
+    if (((Value & PageEntryPresent) == 0) || ((Value & PageEntryLarge) != 0) || ((Value & PageEntryOwned) == 0)) {
+      return;
+    } else if ((Level == 3) && (PagingSubsystemData.Supports1GiBPages == false)) {
+      return;
+    }
+
+    // (Every entry needs to be a present page (not a table), and the
+    // first one needs to be aligned to the size of the large page)
+
+    uint64* Table = (uint64*)GetEntryAddress(Value, Level);
+    uint8 ChildLevel = (Level - 1);
+
+    uint64 First = Table[0];
+
+    if ((First & PageEntryPresent) == 0) {
+      return;
+    } else if ((ChildLevel > 1) && ((First & PageEntryLarge) == 0)) {
+      return;
+    }
+
+    uint64 Address = GetEntryAddress(First, ChildLevel);
+    uint64 Flags = (First & ~(PageEntryAddressMask & ~(GetPageSize(ChildLevel) - 1)));
+
+    if ((Address % GetPageSize(Level)) != 0) {
+      return;
+    }
+
+    for (uint16 Index = 1; Index < 512; Index++) {
+
+      if (Table[Index] != ((Address + (Index * GetPageSize(ChildLevel))) | Flags)) {
+        return;
+      }
+
+    }
+
+    // (Convert the flags to the large page format, if necessary, and
+    // replace the table with a single large page)
+
+    if (ChildLevel == 1) {
+
+      bool HasPat = ((Flags & PageEntryPat) != 0);
+
+      Flags &= ~PageEntryPat;
+      Flags |= (PageEntryLarge | ((HasPat == true) ? PageEntryLargePat : 0));
+
+    }
+
+    *Entry = (Address | Flags);
+
+    PagingSubsystemData.NumPromotedPages++;
+    FreePageTable(Table, ChildLevel);
+
+  }
+
+
+
+  /* void InvalidatePages()
+
+     Inputs: uint64 Virtual - The start of the virtual address range you
+             want to invalidate.
+
+             uint64 Size - The size of that range, in bytes.
+
+     Outputs: (None)
+
+     This function makes sure the CPU doesn't keep using any stale TLB
+     entries for a range of virtual addresses, after their page table
+     entries have been changed; for small ranges, this uses `invlpg` on
+     each page, and for larger ones, it just flushes the whole TLB.
+
+     (This only affects the current CPU; once other CPUs are running,
+     this is also where a TLB shootdown would need to be sent to them)
+
+  */
+
+  void InvalidatePages(uint64 Virtual, uint64 Size) {
+
+    uint64 NumPages = ((Size + SystemPageSize - 1) / SystemPageSize);
+
+    if (NumPages <= MaxInvalidatedPages) {
+
+      for (uint64 Page = 0; Page < NumPages; Page++) {
+        __asm__ __volatile__ ("invlpg (%0)" :: "r"(Virtual + (Page * SystemPageSize)) : "memory");
+      }
+
+      return;
+
+    }
+
+    // (Otherwise, it's faster to just flush the whole TLB)
+
+    FlushTlb();
+    return;
+
+  }
+
+
+
+  /* bool MapRange()
+
+     Inputs: uint64 Physical - The physical address you want to map from.
+
+             uint64 Virtual - The virtual address you want to map it to.
+
+             uint64 Size - The size of the area you want to map, in bytes
+             (this is rounded up to the nearest page).
+
+             cacheType Type - The cache type you want the area to use (see
+             cacheType{} in Memory.h).
+
+     Outputs: bool - Whether we were able to map the area.
+
+     This function maps an area of physical memory to a given virtual
+     address, with a given cache type, using the largest pages it can (1
+     GiB pages if they're supported, then 2 MiB and 4 KiB pages), and
+     replacing any mappings that were already there.
+
+     Both addresses need to be page-aligned. Don't use this to remap
+     anything that's in use while it's being remapped (like the kernel
+     itself), since each page is briefly unmapped before it's replaced.
+
+  */
+
+  bool MapRange(uint64 Physical, uint64 Virtual, uint64 Size, cacheType Type) {
+
+    // First, let's make sure that we can actually map this area.
+
+    if (PagingSubsystemData.IsEnabled == false) {
+      return false;
+    } else if (((Physical % SystemPageSize) != 0) || ((Virtual % SystemPageSize) != 0)) {
+      return false;
+    } else if (Type >= NumCacheTypes) {
+      return false;
+    }
+
+    Size = ((Size + SystemPageSize - 1) & ~((uint64)SystemPageSize - 1));
+
+    const uint64 Start = Virtual;
+    const uint64 End = (Virtual + Size);
+
+    // Next, map each page, one at a time, using the largest page size
+    // that both addresses are aligned to (and that still fits).
+
+    while (Virtual < End) {
+
+      uint8 LeafLevel = 1;
+
+      if ((PagingSubsystemData.Supports1GiBPages == true) && (((Physical | Virtual) % GetPageSize(3)) == 0)
+          && ((End - Virtual) >= GetPageSize(3))) {
+        LeafLevel = 3;
+      } else if ((((Physical | Virtual) % GetPageSize(2)) == 0) && ((End - Virtual) >= GetPageSize(2))) {
+        LeafLevel = 2;
+      }
+
+      // (Walk down the page tables, keeping track of the entry we went
+      // through at each level, so we can try to promote them later)
+
+      uint64* Entries[5] = {NULL};
+      uint64* Table = PagingSubsystemData.Pml4;
+
+      for (uint8 Level = 4; Level > LeafLevel; Level--) {
+
+        Entries[Level] = &Table[GetEntryIndex(Virtual, Level)];
+        Table = GetNextTable(Entries[Level], Level);
+
+        if (Table == NULL) {
+
+          InvalidatePages(Start, (Virtual - Start));
+          ReleasePageTables();
+
+          return false;
+
+        }
+
+      }
+
+      // (Replace the entry itself; if it was already present, unmap it
+      // and invalidate it first, since we might be changing its cache
+      // type, and free it if it was a table we owned)
+
+      uint64* Entry = &Table[GetEntryIndex(Virtual, LeafLevel)];
+      uint64 OldEntry = *Entry;
+
+      if ((OldEntry & PageEntryPresent) != 0) {
+
+        *Entry = 0;
+        InvalidatePages(Virtual, GetPageSize(LeafLevel));
+
+        if ((LeafLevel > 1) && ((OldEntry & PageEntryLarge) == 0) && ((OldEntry & PageEntryOwned) != 0)) {
+          FreePageTable((uint64*)GetEntryAddress(OldEntry, LeafLevel), (LeafLevel - 1));
+        }
+
+      }
+
+      uint64 Flags = (PageEntryPresent | PageEntryWritable | GetCacheBits(Type, (LeafLevel > 1)));
+
+      if (LeafLevel > 1) {
+        Flags |= PageEntryLarge;
+      }
+
+      *Entry = (Physical | Flags);
+
+      PagingSubsystemData.NumPages[LeafLevel - 1]++;
+
+      Physical += GetPageSize(LeafLevel);
+      Virtual += GetPageSize(LeafLevel);
+
+      // (If we just finished filling out a table (or reached the end of
+      // the area), see if we can replace it with a larger page)
+
+      for (uint8 Level = (LeafLevel + 1); Level <= 3; Level++) {
+
+        if (((Virtual % GetPageSize(Level)) != 0) && (Virtual < End)) {
+          break;
+        }
+
+        TryPromoteTable(Entries[Level], Level);
+
+      }
+
+    }
+
+    // Finally, invalidate the whole area, free any tables we replaced
+    // (now that the CPU can't be using them anymore), and return.
+
+    InvalidatePages(Start, Size);
+    ReleasePageTables();
+
+    return true;
+
+  }
+
+
+
+  // (Update the PAT MSR to use the layout in PatValue, following the
+  // procedure from the Intel SDM (section 11.11.8); this disables
+  // interrupts, the cache (CR0.CD, bit 30) and global pages (CR4.PGE,
+  // bit 7) while the PAT is being changed, and flushes both the cache
+  // and the TLB before and after doing so)
+
+  static void ProgramPat(void) {
+
+    if (ReadFromMsr(PatMsr) == PatValue) {
+      return;
+    }
+
+    // (Disable interrupts, keeping track of whether they were enabled
+    // (RFLAGS.IF, bit 9) so we can restore them later)
+
+    uint64 Rflags;
+    __asm__ __volatile__ ("pushfq; pop %0; cli" : "=r"(Rflags) :: "memory");
+
+    uint64 Cr0 = ReadFromControlRegister(0, false);
+    uint64 Cr4 = ReadFromControlRegister(4, false);
+
+    // (Enter no-fill cache mode (CD = 1, NW = 0), and flush the cache)
+
+    WriteToControlRegister(0, false, ((Cr0 | (1ULL << 30)) & ~(1ULL << 29)));
+    __asm__ __volatile__ ("wbinvd" ::: "memory");
+
+    // (Flush the TLB; clearing CR4.PGE does this by itself, and with it
+    // cleared, reloading CR3 does too)
+
+    if ((Cr4 & (1ULL << 7)) != 0) {
+      WriteToControlRegister(4, false, (Cr4 & ~(1ULL << 7)));
+    } else {
+      WriteToControlRegister(3, false, ReadFromControlRegister(3, false));
+    }
+
+    // (Update the PAT, and then flush the cache and TLB again)
+
+    WriteToMsr(PatMsr, PatValue);
+
+    __asm__ __volatile__ ("wbinvd" ::: "memory");
+    WriteToControlRegister(3, false, ReadFromControlRegister(3, false));
+
+    // (Re-enable the cache, and global pages, if they were enabled)
+
+    WriteToControlRegister(0, false, Cr0);
+    WriteToControlRegister(4, false, Cr4);
+
+    if ((Rflags & (1ULL << 9)) != 0) {
+      __asm__ __volatile__ ("sti" ::: "memory");
+    }
+
+  }
+
+#endif
+
+
+
+/* bool InitializePagingSubsystem()
+
+   Inputs: (None)
+   Outputs: bool - Whether the kernel was able to take over its own
+            page tables.
+
+   This function checks for PAT and 1 GiB page support, programs the PAT
+   (so write-combining is available), and then switches over to a PML4 of
+   our own, which starts out as a copy of the current one; after this,
+   MapRange() can be used.
+
+   This needs the memory management subsystem (and ideally, the frame
+   allocator) to already be initialized.
+
+*/
+
+bool InitializePagingSubsystem(void) {
+
+  PagingSubsystemData.IsEnabled = false;
+
+  #if defined(__amd64__) || defined(__x86_64__)
+
+    if (MmSubsystemData.IsEnabled == false) {
+      return false;
+    }
+
+    // First, let's check which features we can use; PAT is in leaf 1
+    // (rdx, bit 16), and 1 GiB pages are in leaf 80000001h (rdx, bit 26).
+
+    PagingSubsystemData.SupportsPat = ((QueryCpuid(1, 0).Rdx & (1ULL << 16)) != 0);
+    PagingSubsystemData.Supports1GiBPages = false;
+
+    if (QueryCpuid(0x80000000, 0).Rax >= 0x80000001) {
+      PagingSubsystemData.Supports1GiBPages = ((QueryCpuid(0x80000001, 0).Rdx & (1ULL << 26)) != 0);
+    }
+
+    // Next, allocate our own PML4, and copy the current one into it;
+    // every entry still points to the bootloader's tables, but those will
+    // be copied as soon as we need to modify them.
+
+    uint64* Pml4 = AllocatePageTable();
+
+    if (Pml4 == NULL) {
+      return false;
+    }
+
+    uint64 Cr3 = ReadFromControlRegister(3, false);
+
+    CopyPageTable(Pml4, (const uint64*)(Cr3 & PageEntryAddressMask));
+    PagingSubsystemData.Pml4 = Pml4;
+
+    // Finally, program the PAT (if possible), and switch to our PML4,
+    // keeping the same cache bits (and PCID) in CR3.
+
+    if (PagingSubsystemData.SupportsPat == true) {
+      ProgramPat();
+    }
+
+    WriteToControlRegister(3, false, ((uint64)Pml4 | (Cr3 & ~PageEntryAddressMask)));
+    PagingSubsystemData.IsEnabled = true;
+
+  #endif
+
+  return PagingSubsystemData.IsEnabled;
+
+}
@@ -0,0 +1,348 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "../Libraries/Stdint.h"
+#include "../Libraries/String.h"
+#include "../System/System.h"
+#include "../../Common.h"
+#include "Memory.h"
+
+// Allocate() always hands out at least one page, which is wasteful for
+// small objects (a 512-byte sector, or a GPT header, still takes up 4
+// KiB). To avoid that, this file implements a simple slab allocator on
+// top of it - each cache carves objects of one size out of slabs, which
+// are themselves allocated with Allocate().
+
+// (Every slab is aligned to its own size, so we can find the header of
+// the slab an object belongs to just by rounding its address down)
+
+objectCache SmallObjectCaches[NumSmallObjectCaches] = {0};
+
+
+
+// (Add a slab to the start of a list of slabs)
+
+static inline void LinkSlab(objectSlab** Head, objectSlab* Slab) {
+
+  Slab->Previous = NULL;
+  Slab->Next = *Head;
+
+  if (*Head != NULL) {
+    (*Head)->Previous = Slab;
+  }
+
+  *Head = Slab;
+
+}
+
+
+
+// (Remove a slab from a list of slabs)
+
+static inline void UnlinkSlab(objectSlab** Head, objectSlab* Slab) {
+
+  if (Slab->Previous != NULL) {
+    Slab->Previous->Next = Slab->Next;
+  } else {
+    *Head = Slab->Next;
+  }
+
+  if (Slab->Next != NULL) {
+    Slab->Next->Previous = Slab->Previous;
+  }
+
+  Slab->Previous = NULL;
+  Slab->Next = NULL;
+
+}
+
+
+
+// (Allocate a new slab for a cache, and link every object in it onto its
+// list of free objects; returns NULL if we're out of memory)
+
+static objectSlab* CreateSlab(objectCache* Cache) {
+
+  objectSlab* Slab = (objectSlab*)Allocate(&Cache->SlabSize);
+
+  if (Slab == NULL) {
+    return NULL;
+  }
+
+  Slab->Cache = Cache;
+  Slab->Previous = NULL;
+  Slab->Next = NULL;
+
+  // (Link every object together, in order, so that objects are handed
+  // out from the start of the slab)
+
+  uintptr Address = ((uintptr)Slab + Cache->Offset);
+  Slab->FreeObjects = (void*)Address;
+
+  for (uint32 Index = 1; Index < Cache->ObjectsPerSlab; Index++) {
+
+    *(void**)Address = (void*)(Address + Cache->ObjectSize);
+    Address += Cache->ObjectSize;
+
+  }
+
+  *(void**)Address = NULL;
+  Slab->NumFree = Cache->ObjectsPerSlab;
+
+  Cache->NumSlabs++;
+  return Slab;
+
+}
+
+
+
+// (Set up a cache for objects of a given size; this doesn't allocate any
+// memory by itself, and returns false if the size is invalid)
+
+bool CreateObjectCache(objectCache* Cache, uintptr ObjectSize) {
+
+  if (Cache == NULL) {
+    return false;
+  } else if (ObjectSize == 0) {
+    return false;
+  }
+
+  Memset((void*)Cache, 0, sizeof(objectCache));
+
+  // (Round the object size and the size of the slab header up to the
+  // nearest multiple of MinObjectSize, so every object stays aligned)
+
+  ObjectSize = ((ObjectSize + MinObjectSize - 1) & ~((uintptr)MinObjectSize - 1));
+  uintptr Offset = ((sizeof(objectSlab) + MinObjectSize - 1) & ~((uintptr)MinObjectSize - 1));
+
+  // (Start with one page per slab, and keep doubling it until it fits at
+  // least MinObjectsPerSlab objects; each slab has to be a power of two,
+  // since Allocate() only aligns blocks to their own size)
+
+  uintptr SlabSize = SystemPageSize;
+
+  while (((SlabSize - Offset) / ObjectSize) < MinObjectsPerSlab) {
+
+    SlabSize <<= 1;
+
+    if (SlabSize > (1ULL << MaxBlockLevel)) {
+      return false;
+    }
+
+  }
+
+  Cache->ObjectSize = ObjectSize;
+  Cache->SlabSize = SlabSize;
+  Cache->Offset = Offset;
+  Cache->ObjectsPerSlab = (uint32)((SlabSize - Offset) / ObjectSize);
+
+  return true;
+
+}
+
+
+
+// (Allocate an object from a cache; returns NULL if the cache hasn't been
+// set up, or if we're out of memory)
+
+[[nodiscard]] void* AllocateObject(objectCache* Cache) {
+
+  if (Cache == NULL) {
+    return NULL;
+  } else if (Cache->ObjectSize == 0) {
+    return NULL;
+  }
+
+  // First, let's find a slab with at least one free object - either one
+  // that's already partially used, the spare slab, or a new one.
+
+  objectSlab* Slab = Cache->Partial;
+
+  if (Slab == NULL) {
+
+    if (Cache->Empty != NULL) {
+
+      Slab = Cache->Empty;
+      Cache->Empty = NULL;
+
+    } else {
+
+      Slab = CreateSlab(Cache);
+
+      if (Slab == NULL) {
+        return NULL;
+      }
+
+    }
+
+    LinkSlab(&Cache->Partial, Slab);
+
+  }
+
+  // Next, take the first object from its free list, and move the slab to
+  // the list of full slabs if that was the last one.
+
+  void* Object = Slab->FreeObjects;
+
+  Slab->FreeObjects = *(void**)Object;
+  Slab->NumFree--;
+
+  if (Slab->NumFree == 0) {
+
+    UnlinkSlab(&Cache->Partial, Slab);
+    LinkSlab(&Cache->Full, Slab);
+
+  }
+
+  Cache->NumObjects++;
+  return Object;
+
+}
+
+
+
+// (Return an object to the cache it was allocated from; returns false if
+// it doesn't belong to that cache)
+
+[[nodiscard]] bool FreeObject(objectCache* Cache, void* Pointer) {
+
+  if ((Cache == NULL) || (Pointer == NULL)) {
+    return false;
+  } else if (Cache->ObjectSize == 0) {
+    return false;
+  }
+
+  // First, let's find the slab this object belongs to, and make sure that
+  // it actually points to the start of an object in this cache.
+
+  uintptr Address = (uintptr)Pointer;
+  objectSlab* Slab = (objectSlab*)(Address & ~(Cache->SlabSize - 1));
+
+  uintptr Offset = (Address - (uintptr)Slab);
+
+  if (Offset < Cache->Offset) {
+    return false;
+  } else if (((Offset - Cache->Offset) % Cache->ObjectSize) != 0) {
+    return false;
+  } else if (((Offset - Cache->Offset) / Cache->ObjectSize) >= Cache->ObjectsPerSlab) {
+    return false;
+  } else if (Slab->Cache != Cache) {
+    return false;
+  } else if (Slab->NumFree >= Cache->ObjectsPerSlab) {
+    return false;
+  }
+
+  // (If the slab was full, it now has a free object, so move it back to
+  // the list of partially used slabs)
+
+  if (Slab->NumFree == 0) {
+
+    UnlinkSlab(&Cache->Full, Slab);
+    LinkSlab(&Cache->Partial, Slab);
+
+  }
+
+  *(void**)Pointer = Slab->FreeObjects;
+
+  Slab->FreeObjects = Pointer;
+  Slab->NumFree++;
+
+  Cache->NumObjects--;
+
+  // If the slab is now completely unused, keep it as a spare (so that we
+  // don't keep allocating and freeing the same slab), unless we already
+  // have one, in which case we can return it to Allocate().
+
+  if (Slab->NumFree == Cache->ObjectsPerSlab) {
+
+    UnlinkSlab(&Cache->Partial, Slab);
+
+    if (Cache->Empty == NULL) {
+      Cache->Empty = Slab;
+    } else {
+
+      Cache->NumSlabs--;
+      return Free((void*)Slab, &Cache->SlabSize);
+
+    }
+
+  }
+
+  return true;
+
+}
+
+
+
+// (Find the general-purpose cache for objects of a given size, and set it
+// up if it hasn't been already; returns NULL if the size is too large)
+
+static objectCache* GetSmallObjectCache(uintptr Size) {
+
+  uint8 Index = 0;
+
+  while ((Index < NumSmallObjectCaches) && (Size > ((uintptr)MinObjectSize << Index))) {
+    Index++;
+  }
+
+  if (Index >= NumSmallObjectCaches) {
+    return NULL;
+  }
+
+  objectCache* Cache = &SmallObjectCaches[Index];
+
+  if (Cache->ObjectSize == 0) {
+
+    if (CreateObjectCache(Cache, ((uintptr)MinObjectSize << Index)) == false) {
+      return NULL;
+    }
+
+  }
+
+  return Cache;
+
+}
+
+
+
+// (General-purpose allocator for small objects, with size classes from
+// MinObjectSize to MaxSmallObjectSize; anything larger than that is
+// passed on to Allocate() instead, so this works for any size)
+
+// Objects from this are only aligned to MinObjectSize bytes, not to a
+// page boundary, so anything that needs a page-aligned buffer should
+// still use Allocate() directly.
+
+[[nodiscard]] void* AllocateSmall(const uintptr* Length) {
+
+  if (Length == NULL) {
+    return NULL;
+  } else if (*Length == 0) {
+    return NULL;
+  } else if (*Length > MaxSmallObjectSize) {
+    return Allocate(Length);
+  }
+
+  return AllocateObject(GetSmallObjectCache(*Length));
+
+}
+
+
+
+// (Free an object from AllocateSmall(); `Length` must be the same value
+// that was used to allocate it)
+
+[[nodiscard]] bool FreeSmall(void* Pointer, const uintptr* Length) {
+
+  if (Length == NULL) {
+    return false;
+  } else if (*Length == 0) {
+    return false;
+  } else if (*Length > MaxSmallObjectSize) {
+    return Free(Pointer, Length);
+  }
+
+  return FreeObject(GetSmallObjectCache(*Length), Pointer);
+
+}
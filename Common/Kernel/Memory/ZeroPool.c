@@ -0,0 +1,212 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#include "../Libraries/Stdint.h"
+#include "../Libraries/String.h"
+#include "../System/System.h"
+#include "../../Common.h"
+#include "Memory.h"
+
+// A lot of allocations need to be cleared before they can be used, and
+// doing that inline means the caller has to wait for it (and that the
+// cache gets filled with zeroes nobody's going to read).
+
+// To avoid that, this file keeps a small pool of blocks that have already
+// been cleared, which AllocateZeroed() can hand out straight away. The
+// pool is refilled by RefillZeroPool(), which should be called whenever
+// the system is otherwise idle (for example, while waiting for a key),
+// and it's also filled once at boot, before anything else allocates; it
+// only does a bounded amount of work per call, using non-temporal stores,
+// so it can be called in a loop without adding any latency.
+
+// Right before the kernel returns, DrainZeroPool() gives every block
+// back to the heap, so they don't stay reserved.
+
+zeroPoolData ZeroPoolData = {0};
+
+// (Non-temporal version of Memset(), from x64/Memset.asm; this fills
+// memory without pulling it into the cache while doing so)
+
+#if defined(__amd64__) || defined(__x86_64__)
+  extern void Memset_NonTemporal(void* Buffer, uint8 Value, uint64 Size);
+#endif
+
+
+
+// (Clear a buffer, using non-temporal stores where we can)
+
+static inline void ClearBuffer(void* Buffer, uintptr Size) {
+
+  #if defined(__amd64__) || defined(__x86_64__)
+    Memset_NonTemporal(Buffer, 0, Size);
+  #else
+    Memset(Buffer, 0, Size);
+  #endif
+
+}
+
+
+
+// (Calculate the size of the blocks in a given row of the pool)
+
+static inline uintptr GetZeroPoolBlockSize(uint8 Index) {
+  return ((uintptr)SystemPageSize << Index);
+}
+
+
+
+// (Allocate a block of memory that's already been cleared; this works
+// exactly like Allocate(), and the block can be freed with Free())
+
+// If the pool has a block of the right size, this takes it from there;
+// otherwise, it allocates a new block and clears it inline (Memset()
+// already uses non-temporal stores for anything too large to cache).
+
+[[nodiscard]] void* AllocateZeroed(const uintptr* Length) {
+
+  if (Length == NULL) {
+    return NULL;
+  } else if (*Length == 0) {
+    return NULL;
+  }
+
+  // (Find the smallest block size in the pool that fits `Length`, and
+  // take a block from it if there's one left)
+
+  for (uint8 Index = 0; Index < NumZeroPoolSizes; Index++) {
+
+    if (*Length > GetZeroPoolBlockSize(Index)) {
+      continue;
+    }
+
+    if (ZeroPoolData.NumBlocks[Index] != 0) {
+
+      ZeroPoolData.NumBlocks[Index]--;
+      void* Block = ZeroPoolData.Blocks[Index][ZeroPoolData.NumBlocks[Index]];
+
+      // (This block was allocated by RefillZeroPool(), with the block
+      // size, so update its record to match what the caller will free)
+
+      RetraceAllocation(Block, *Length, (uintptr)__builtin_return_address(0));
+      return Block;
+
+    }
+
+    break;
+
+  }
+
+  // (If we couldn't, then allocate and clear a new block)
+
+  void* Pointer = Allocate(Length);
+
+  if (Pointer != NULL) {
+
+    RetraceAllocation(Pointer, *Length, (uintptr)__builtin_return_address(0));
+    Memset(Pointer, 0, *Length);
+
+  }
+
+  return Pointer;
+
+}
+
+
+
+// (Do a bounded amount of work towards refilling the pool, clearing at
+// most ZeroPoolRefillStep bytes; returns false once the pool is full, or
+// if we're out of memory)
+
+bool RefillZeroPool(void) {
+
+  if (MmSubsystemData.IsEnabled == false) {
+    return false;
+  }
+
+  // If we aren't already in the middle of clearing a block, then find
+  // the smallest size that isn't full yet, and allocate a block for it.
+
+  if (ZeroPoolData.Pending == NULL) {
+
+    uint8 Index = 0;
+
+    while ((Index < NumZeroPoolSizes) && (ZeroPoolData.NumBlocks[Index] >= ZeroPoolDepth)) {
+      Index++;
+    }
+
+    if (Index >= NumZeroPoolSizes) {
+      return false;
+    }
+
+    const uintptr Size = GetZeroPoolBlockSize(Index);
+    void* Block = Allocate(&Size);
+
+    if (Block == NULL) {
+      return false;
+    }
+
+    ZeroPoolData.Pending = Block;
+    ZeroPoolData.PendingSize = Index;
+    ZeroPoolData.PendingOffset = 0;
+
+  }
+
+  // Next, clear the next part of the block, and add it to the pool once
+  // we've cleared all of it.
+
+  const uintptr Size = GetZeroPoolBlockSize(ZeroPoolData.PendingSize);
+  uintptr Step = (Size - ZeroPoolData.PendingOffset);
+
+  if (Step > ZeroPoolRefillStep) {
+    Step = ZeroPoolRefillStep;
+  }
+
+  ClearBuffer((void*)((uintptr)ZeroPoolData.Pending + ZeroPoolData.PendingOffset), Step);
+  ZeroPoolData.PendingOffset += Step;
+
+  if (ZeroPoolData.PendingOffset == Size) {
+
+    uint8 Index = ZeroPoolData.PendingSize;
+
+    ZeroPoolData.Blocks[Index][ZeroPoolData.NumBlocks[Index]] = ZeroPoolData.Pending;
+    ZeroPoolData.NumBlocks[Index]++;
+
+    ZeroPoolData.Pending = NULL;
+
+  }
+
+  return true;
+
+}
+
+
+
+// (Give every block in the pool back to the heap, including the one we
+// were in the middle of clearing, if any)
+
+void DrainZeroPool(void) {
+
+  for (uint8 Index = 0; Index < NumZeroPoolSizes; Index++) {
+
+    const uintptr Size = GetZeroPoolBlockSize(Index);
+
+    while (ZeroPoolData.NumBlocks[Index] != 0) {
+
+      ZeroPoolData.NumBlocks[Index]--;
+      [[maybe_unused]] bool Result = Free(ZeroPoolData.Blocks[Index][ZeroPoolData.NumBlocks[Index]], &Size);
+
+    }
+
+  }
+
+  if (ZeroPoolData.Pending != NULL) {
+
+    const uintptr Size = GetZeroPoolBlockSize(ZeroPoolData.PendingSize);
+    [[maybe_unused]] bool Result = Free(ZeroPoolData.Pending, &Size);
+
+    ZeroPoolData.Pending = NULL;
+
+  }
+
+}
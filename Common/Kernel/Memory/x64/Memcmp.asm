@@ -0,0 +1,263 @@
+; Copyright (C) 2025 NunoLealF
+; This file is part of the Serra project, which is released under the MIT license.
+; For more information, please refer to the accompanying license agreement. <3
+
+[BITS 64]
+
+DEFAULT REL
+SECTION .text
+
+GLOBAL Memcmp_Sse2
+GLOBAL Memcmp_Avx2
+GLOBAL Memcmp_Avx512bw
+
+
+; These functions compare one vector at a time, and return -1, 0 or +1,
+; just like Memcmp(). They all expect `Size` to be at least as large as
+; one vector (16, 32 or 64 bytes), since the last few bytes are handled
+; by comparing the *last* vector of both buffers, which overlaps with
+; data we've already compared (and found to be equal).
+
+; (`tzcnt` is used to find the first differing byte; on CPUs without
+; BMI1, it's decoded as `bsf`, which gives the same result here, since
+; we only ever use it on non-zero masks)
+
+
+; This function shouldn't change any preserved registers, other than XMM
+; ones, but those are covered by the System V ABI.
+
+; (const void* BufferA (RDI), const void* BufferB (RSI), uint64 Size (RDX))
+
+Memcmp_Sse2:
+
+  ; (Store `Size` in RCX, and use it as a counter)
+
+  mov rcx, rdx
+
+  ; Compare each 16-byte block, using `pcmpeqb` (which sets each byte
+  ; that's equal to FFh) and `pmovmskb` (which gathers the top bit of
+  ; each byte into R8); if any bit is zero, we found a difference.
+
+  .CompareBlockData:
+
+    cmp rcx, 16
+    jb .CompareRemainder
+
+    movdqu xmm0, [rdi]
+    movdqu xmm1, [rsi]
+
+    pcmpeqb xmm0, xmm1
+    pmovmskb r8d, xmm0
+
+    xor r8d, 0FFFFh
+    jnz .FoundDifference
+
+    add rdi, 16
+    add rsi, 16
+
+    sub rcx, 16
+    jmp .CompareBlockData
+
+  ; Compare the last 16 bytes of both buffers, if there's anything left.
+
+  .CompareRemainder:
+
+    cmp rcx, 0
+    je .Equal
+
+    lea rdi, [rdi+rcx-16]
+    lea rsi, [rsi+rcx-16]
+
+    movdqu xmm0, [rdi]
+    movdqu xmm1, [rsi]
+
+    pcmpeqb xmm0, xmm1
+    pmovmskb r8d, xmm0
+
+    xor r8d, 0FFFFh
+    jnz .FoundDifference
+
+  ; If we didn't find any differences, return 0.
+
+  .Equal:
+
+    xor eax, eax
+    ret
+
+  ; Otherwise, find the first differing byte (the lowest set bit in
+  ; R8), and return -1 or +1 depending on which one is larger.
+
+  .FoundDifference:
+
+    tzcnt r8d, r8d
+
+    movzx eax, byte [rdi+r8]
+    movzx r9d, byte [rsi+r8]
+
+    cmp eax, r9d
+
+    mov eax, 1
+    mov r9d, -1
+    cmovb eax, r9d
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than YMM
+; ones, but those are covered by the System V ABI.
+
+; (const void* BufferA (RDI), const void* BufferB (RSI), uint64 Size (RDX))
+
+Memcmp_Avx2:
+
+  ; (Store `Size` in RCX, and use it as a counter)
+
+  mov rcx, rdx
+
+  ; Compare each 32-byte block, using `vpcmpeqb` and `vpmovmskb`, in
+  ; the same way as Memcmp_Sse2().
+
+  .CompareBlockData:
+
+    cmp rcx, 32
+    jb .CompareRemainder
+
+    vmovdqu ymm0, [rdi]
+    vpcmpeqb ymm0, ymm0, [rsi]
+    vpmovmskb r8d, ymm0
+
+    xor r8d, 0FFFFFFFFh
+    jnz .FoundDifference
+
+    add rdi, 32
+    add rsi, 32
+
+    sub rcx, 32
+    jmp .CompareBlockData
+
+  ; Compare the last 32 bytes of both buffers, if there's anything left.
+
+  .CompareRemainder:
+
+    cmp rcx, 0
+    je .Equal
+
+    lea rdi, [rdi+rcx-32]
+    lea rsi, [rsi+rcx-32]
+
+    vmovdqu ymm0, [rdi]
+    vpcmpeqb ymm0, ymm0, [rsi]
+    vpmovmskb r8d, ymm0
+
+    xor r8d, 0FFFFFFFFh
+    jnz .FoundDifference
+
+  ; If we didn't find any differences, return 0.
+
+  .Equal:
+
+    vzeroupper
+
+    xor eax, eax
+    ret
+
+  ; Otherwise, find the first differing byte (the lowest set bit in
+  ; R8), and return -1 or +1 depending on which one is larger.
+
+  .FoundDifference:
+
+    vzeroupper
+
+    tzcnt r8d, r8d
+
+    movzx eax, byte [rdi+r8]
+    movzx r9d, byte [rsi+r8]
+
+    cmp eax, r9d
+
+    mov eax, 1
+    mov r9d, -1
+    cmovb eax, r9d
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than ZMM
+; and opmask ones, but those are covered by the System V ABI.
+
+; (const void* BufferA (RDI), const void* BufferB (RSI), uint64 Size (RDX))
+
+Memcmp_Avx512bw:
+
+  ; (Store `Size` in RCX, and use it as a counter)
+
+  mov rcx, rdx
+
+  ; Compare each 64-byte block, using `vpcmpb` (with the 'not equal'
+  ; predicate, 4), which sets a bit in K1 for every byte that differs.
+
+  .CompareBlockData:
+
+    cmp rcx, 64
+    jb .CompareRemainder
+
+    vmovdqu64 zmm0, [rdi]
+    vpcmpb k1, zmm0, [rsi], 4
+    kmovq r8, k1
+
+    test r8, r8
+    jnz .FoundDifference
+
+    add rdi, 64
+    add rsi, 64
+
+    sub rcx, 64
+    jmp .CompareBlockData
+
+  ; Compare the last 64 bytes of both buffers, if there's anything left.
+
+  .CompareRemainder:
+
+    cmp rcx, 0
+    je .Equal
+
+    lea rdi, [rdi+rcx-64]
+    lea rsi, [rsi+rcx-64]
+
+    vmovdqu64 zmm0, [rdi]
+    vpcmpb k1, zmm0, [rsi], 4
+    kmovq r8, k1
+
+    test r8, r8
+    jnz .FoundDifference
+
+  ; If we didn't find any differences, return 0.
+
+  .Equal:
+
+    vzeroupper
+
+    xor eax, eax
+    ret
+
+  ; Otherwise, find the first differing byte (the lowest set bit in
+  ; R8), and return -1 or +1 depending on which one is larger.
+
+  .FoundDifference:
+
+    vzeroupper
+
+    tzcnt r8, r8
+
+    movzx eax, byte [rdi+r8]
+    movzx r9d, byte [rsi+r8]
+
+    cmp eax, r9d
+
+    mov eax, 1
+    mov r9d, -1
+    cmovb eax, r9d
+
+    ret
@@ -12,6 +12,11 @@ GLOBAL Memcpy_Sse2
 GLOBAL Memcpy_Avx
 GLOBAL Memcpy_Avx512f
 
+GLOBAL Memcpy_Sse2Temporal
+GLOBAL Memcpy_AvxTemporal
+GLOBAL Memcpy_Avx2Temporal
+GLOBAL Memcpy_Avx512fTemporal
+
 
 ; TODO - In theory this shouldn't alter any preserved registers.
 ; (void* Destination (RDI), const void* Source (RSI), uint64 Size (RDX))
@@ -59,12 +64,14 @@ Memcpy_RepMovsb:
   ; Now that we know that Destination is 16-byte-aligned, we can safely
   ; use `rep movsb` to copy everything else, before returning.
 
+  ; (These are all regular stores, so unlike Memcpy_Sse2() and the other
+  ; non-temporal routines, we don't need an `sfence` afterwards)
+
   .MoveAlignedData:
 
     cld
     rep movsb
 
-    sfence
     ret
 
 
@@ -396,3 +403,380 @@ Memcpy_Avx512f:
 
     sfence
     ret
+
+
+
+; This function shouldn't change any preserved registers, other than XMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Destination (RDI), const void* Source (RSI), uint64 Size (RDX))
+
+Memcpy_Sse2Temporal:
+
+  ; First, let's check if the destination address is 16-byte-aligned,
+  ; and if not, use `rep movsb` to copy the remainder.
+
+  ; (We store the remainder in R8, and use R9 as a scratch register)
+
+  mov r9, rdi
+  and r9, (16 - 1)
+
+  mov r8, 16
+  sub r8, r9
+
+  ; (Store `Size` (RDX) in RCX, since it's used for `rep movsb`)
+
+  mov rcx, rdx
+
+  ; (If it's already aligned, then we don't need to align it)
+
+  cmp r8, 16
+  je .MoveAlignedData
+
+  ; If the destination address isn't 16-byte-aligned, copy the remainder
+  ; (also using `rep movsb`, but *only* for the remainder)
+
+  .MoveUnalignedData:
+
+    push rcx
+    mov rcx, r8
+
+    cld
+    rep movsb
+
+    pop rcx
+    sub rcx, r8
+
+  ; If it is, then prepare the environment for SSE.
+
+  .MoveAlignedData:
+
+    ; (Calculate the number of 64-byte 'blocks' we need to move in R9)
+
+    mov r9, rcx
+    shr r9, 6
+
+  ; Move each 64-byte block using SSE registers, using R9 as a counter;
+  ; unlike Memcpy_Sse2(), this uses regular (temporal) stores,
+  ; so the data we've copied stays in the cache.
+
+  .MoveBlockData:
+
+    cmp r9, 0
+    je .MoveRemainder
+
+    movdqu xmm0, [rsi+0]
+    movdqu xmm1, [rsi+16]
+    movdqu xmm2, [rsi+32]
+    movdqu xmm3, [rsi+48]
+
+    movdqa [rdi+0], xmm0
+    movdqa [rdi+16], xmm1
+    movdqa [rdi+32], xmm2
+    movdqa [rdi+48], xmm3
+
+    add rsi, 64
+    add rdi, 64
+
+    sub rcx, 64
+
+    dec r9
+    jmp .MoveBlockData
+
+  ; Move the remainder of the data, using `rep movsb` again.
+
+  .MoveRemainder:
+
+    cld
+    rep movsb
+
+  ; Now that we're done, we can return; since these are all regular
+  ; stores, we don't need an `sfence` here.
+
+  .Cleanup:
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than YMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Destination (RDI), const void* Source (RSI), uint64 Size (RDX))
+
+Memcpy_AvxTemporal:
+
+  ; First, let's check if the destination address is 32-byte-aligned,
+  ; and if not, use `rep movsb` to copy the remainder.
+
+  ; (We store the remainder in R8, and use R9 as a scratch register)
+
+  mov r9, rdi
+  and r9, (32 - 1)
+
+  mov r8, 32
+  sub r8, r9
+
+  ; (Store `Size` (RDX) in RCX, since it's used for `rep movsb`)
+
+  mov rcx, rdx
+
+  ; (If it's already aligned, then we don't need to align it)
+
+  cmp r8, 32
+  je .MoveAlignedData
+
+  ; If the destination address isn't 32-byte-aligned, copy the remainder
+  ; (also using `rep movsb`, but *only* for the remainder)
+
+  .MoveUnalignedData:
+
+    push rcx
+    mov rcx, r8
+
+    cld
+    rep movsb
+
+    pop rcx
+    sub rcx, r8
+
+  ; If it is, then prepare the environment for AVX.
+
+  .MoveAlignedData:
+
+    ; (Calculate the number of 128-byte 'blocks' we need to move in R9)
+
+    mov r9, rcx
+    shr r9, 7
+
+  ; Move each 128-byte block using AVX registers, using R9 as a counter;
+  ; unlike Memcpy_Avx(), this uses regular (temporal) stores,
+  ; so the data we've copied stays in the cache.
+
+  .MoveBlockData:
+
+    cmp r9, 0
+    je .MoveRemainder
+
+    vmovdqu ymm0, [rsi+0]
+    vmovdqu ymm1, [rsi+32]
+    vmovdqu ymm2, [rsi+64]
+    vmovdqu ymm3, [rsi+96]
+
+    vmovdqa [rdi+0], ymm0
+    vmovdqa [rdi+32], ymm1
+    vmovdqa [rdi+64], ymm2
+    vmovdqa [rdi+96], ymm3
+
+    add rsi, 128
+    add rdi, 128
+
+    sub rcx, 128
+
+    dec r9
+    jmp .MoveBlockData
+
+  ; Move the remainder of the data, using `rep movsb` again.
+
+  .MoveRemainder:
+
+    cld
+    rep movsb
+
+  ; Now that we're done, we can return; since these are all regular
+  ; stores, we don't need an `sfence` here.
+
+  .Cleanup:
+
+    vzeroupper
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than ZMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Destination (RDI), const void* Source (RSI), uint64 Size (RDX))
+
+Memcpy_Avx512fTemporal:
+
+  ; First, let's check if the destination address is 64-byte-aligned,
+  ; and if not, use `rep movsb` to copy the remainder.
+
+  ; (We store the remainder in R8, and use R9 as a scratch register)
+
+  mov r9, rdi
+  and r9, (64 - 1)
+
+  mov r8, 64
+  sub r8, r9
+
+  ; (Store `Size` (RDX) in RCX, since it's used for `rep movsb`)
+
+  mov rcx, rdx
+
+  ; (If it's already aligned, then we don't need to align it)
+
+  cmp r8, 64
+  je .MoveAlignedData
+
+  ; If the destination address isn't 64-byte-aligned, copy the remainder
+  ; (also using `rep movsb`, but *only* for the remainder)
+
+  .MoveUnalignedData:
+
+    push rcx
+    mov rcx, r8
+
+    cld
+    rep movsb
+
+    pop rcx
+    sub rcx, r8
+
+  ; If it is, then prepare the environment for AVX-512.
+
+  .MoveAlignedData:
+
+    ; (Calculate the number of 256-byte 'blocks' we need to move in R9)
+
+    mov r9, rcx
+    shr r9, 8
+
+  ; Move each 256-byte block using AVX-512 registers, using R9 as a counter;
+  ; unlike Memcpy_Avx512f(), this uses regular (temporal) stores,
+  ; so the data we've copied stays in the cache.
+
+  .MoveBlockData:
+
+    cmp r9, 0
+    je .MoveRemainder
+
+    vmovdqu64 zmm0, [rsi+0]
+    vmovdqu64 zmm1, [rsi+64]
+    vmovdqu64 zmm2, [rsi+128]
+    vmovdqu64 zmm3, [rsi+192]
+
+    vmovdqa64 [rdi+0], zmm0
+    vmovdqa64 [rdi+64], zmm1
+    vmovdqa64 [rdi+128], zmm2
+    vmovdqa64 [rdi+192], zmm3
+
+    add rsi, 256
+    add rdi, 256
+
+    sub rcx, 256
+
+    dec r9
+    jmp .MoveBlockData
+
+  ; Move the remainder of the data, using `rep movsb` again.
+
+  .MoveRemainder:
+
+    cld
+    rep movsb
+
+  ; Now that we're done, we can return; since these are all regular
+  ; stores, we don't need an `sfence` here.
+
+  .Cleanup:
+
+    vzeroupper
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than YMM
+; ones, but those are covered by the System V ABI. Unlike the other
+; functions here, `Size` must be at least 64 bytes.
+
+; (void* Destination (RDI), const void* Source (RSI), uint64 Size (RDX))
+
+Memcpy_Avx2Temporal:
+
+  ; Instead of aligning the destination with `rep movsb` (which has a
+  ; fairly large startup cost), we load the first and last 32 bytes
+  ; into YMM4 and YMM5 upfront, and store them at the very end; that
+  ; way, the main loop only has to deal with aligned 32-byte blocks.
+
+  ; (Store the original destination in R11, and the end of both areas
+  ; in R8 (destination) and R10 (source))
+
+  mov r11, rdi
+
+  lea r8, [rdi+rdx]
+  lea r10, [rsi+rdx]
+
+  vmovdqu ymm4, [rsi]
+  vmovdqu ymm5, [r10-32]
+
+  ; (Round the destination up to the next 32-byte boundary, and move
+  ; the source forward by the same amount)
+
+  mov rcx, rdi
+
+  add rdi, 32
+  and rdi, -32
+
+  sub rcx, rdi
+  sub rsi, rcx
+
+  ; (Round the end of the destination down to a 32-byte boundary, and
+  ; store it in R9; we stop the main loop there)
+
+  mov r9, r8
+  and r9, -32
+
+  ; Move each 128-byte block using YMM registers, comparing against the
+  ; end pointer (in R9) instead of keeping a separate counter.
+
+  .MoveBlockData:
+
+    lea rax, [rdi+128]
+
+    cmp rax, r9
+    ja .MoveRemainder
+
+    vmovdqu ymm0, [rsi+0]
+    vmovdqu ymm1, [rsi+32]
+    vmovdqu ymm2, [rsi+64]
+    vmovdqu ymm3, [rsi+96]
+
+    vmovdqa [rdi+0], ymm0
+    vmovdqa [rdi+32], ymm1
+    vmovdqa [rdi+64], ymm2
+    vmovdqa [rdi+96], ymm3
+
+    add rsi, 128
+    mov rdi, rax
+
+    jmp .MoveBlockData
+
+  ; Move any aligned 32-byte blocks that are left over, one at a time.
+
+  .MoveRemainder:
+
+    cmp rdi, r9
+    jae .Cleanup
+
+    vmovdqu ymm0, [rsi]
+    vmovdqa [rdi], ymm0
+
+    add rsi, 32
+    add rdi, 32
+
+    jmp .MoveRemainder
+
+  ; Finally, store the first and last 32 bytes (which we loaded at the
+  ; start), and return.
+
+  .Cleanup:
+
+    vmovdqu [r11], ymm4
+    vmovdqu [r8-32], ymm5
+
+    vzeroupper
+    ret
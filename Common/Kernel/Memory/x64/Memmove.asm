@@ -0,0 +1,577 @@
+; Copyright (C) 2025 NunoLealF
+; This file is part of the Serra project, which is released under the MIT license.
+; For more information, please refer to the accompanying license agreement. <3
+
+[BITS 64]
+
+DEFAULT REL
+SECTION .text
+
+GLOBAL Memmove_Sse2
+GLOBAL Memmove_Avx
+GLOBAL Memmove_Avx512f
+
+
+; Unlike the functions in Memcpy.asm, these can deal with overlapping
+; memory areas, no matter how close together they are.
+
+; The trick is that each block is read into registers *before* any of it
+; is written back, so as long as we copy front-to-back when Destination
+; comes before Source (and back-to-front otherwise), no block can ever
+; overwrite data we still need to read. This works even if the areas are
+; only a single byte apart, so there's no need for a byte-by-byte loop
+; for short distances.
+
+; (Since these are only used for areas that actually overlap, and that
+; data is usually still in the cache, these use regular stores instead
+; of non-temporal ones)
+
+
+
+; This function shouldn't change any preserved registers, other than XMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Destination (RDI), const void* Source (RSI), uint64 Size (RDX))
+
+Memmove_Sse2:
+
+  ; (Store `Size` (RDX) in RCX, since it's used for `rep movsb`)
+
+  mov rcx, rdx
+
+  ; First, let's figure out which direction we need to copy in; if
+  ; Destination comes after Source, we need to copy back-to-front.
+
+  cmp rdi, rsi
+  je .Cleanup
+  ja .MoveBackward
+
+  ; (If there isn't enough data to be worth aligning, skip straight to
+  ; the end, and copy everything with `rep movsb`)
+
+  cmp rcx, (64 + 16)
+  jb .MoveForwardRemainder
+
+  ; If the destination address isn't 16-byte-aligned, copy the bytes
+  ; before the next boundary using `rep movsb` (front-to-back, which is
+  ; safe here, since Destination comes before Source).
+
+  ; (We store the number of bytes we need to copy in R8)
+
+  mov r8, rdi
+  neg r8
+  and r8, (16 - 1)
+
+  .MoveForwardUnalignedData:
+
+    push rcx
+    mov rcx, r8
+
+    cld
+    rep movsb
+
+    pop rcx
+    sub rcx, r8
+
+    ; (Calculate the number of 64-byte 'blocks' we need to move in R9,
+    ; and leave the remainder in RCX)
+
+    mov r9, rcx
+    shr r9, 6
+
+    and rcx, (64 - 1)
+
+  ; Move each 64-byte block using SSE registers, using R9 as a counter;
+  ; we read the entire block before writing any of it.
+
+  .MoveForwardBlockData:
+
+    cmp r9, 0
+    je .MoveForwardRemainder
+
+    movdqu xmm0, [rsi+0]
+    movdqu xmm1, [rsi+16]
+    movdqu xmm2, [rsi+32]
+    movdqu xmm3, [rsi+48]
+
+    movdqa [rdi+0], xmm0
+    movdqa [rdi+16], xmm1
+    movdqa [rdi+32], xmm2
+    movdqa [rdi+48], xmm3
+
+    add rsi, 64
+    add rdi, 64
+
+    dec r9
+    jmp .MoveForwardBlockData
+
+  ; Move the remainder of the data, using `rep movsb` again.
+
+  .MoveForwardRemainder:
+
+    cld
+    rep movsb
+
+    jmp .Cleanup
+
+  ; If Destination comes after Source, then we need to do the same thing,
+  ; but starting from the end of both areas, and working backwards.
+
+  .MoveBackward:
+
+    add rsi, rcx
+    add rdi, rcx
+
+    ; (If there isn't enough data to be worth aligning, skip straight to
+    ; the end, and copy everything one byte at a time)
+
+    cmp rcx, (64 + 16)
+    jb .MoveBackwardRemainder
+
+    ; (Calculate the number of bytes after the last 16-byte boundary in
+    ; the destination area in R8, and copy those one byte at a time)
+
+    mov r8, rdi
+    and r8, (16 - 1)
+
+    sub rcx, r8
+
+  .MoveBackwardUnalignedData:
+
+    cmp r8, 0
+    je .MoveBackwardAlignedData
+
+    dec rsi
+    dec rdi
+
+    mov al, [rsi]
+    mov [rdi], al
+
+    dec r8
+    jmp .MoveBackwardUnalignedData
+
+  .MoveBackwardAlignedData:
+
+    ; (Calculate the number of 64-byte 'blocks' we need to move in R9,
+    ; and leave the remainder in RCX)
+
+    mov r9, rcx
+    shr r9, 6
+
+    and rcx, (64 - 1)
+
+  ; Move each 64-byte block using SSE registers, using R9 as a counter,
+  ; starting from the end; again, we read the entire block before writing
+  ; any of it.
+
+  .MoveBackwardBlockData:
+
+    cmp r9, 0
+    je .MoveBackwardRemainder
+
+    sub rsi, 64
+    sub rdi, 64
+
+    movdqu xmm0, [rsi+48]
+    movdqu xmm1, [rsi+32]
+    movdqu xmm2, [rsi+16]
+    movdqu xmm3, [rsi+0]
+
+    movdqa [rdi+48], xmm0
+    movdqa [rdi+32], xmm1
+    movdqa [rdi+16], xmm2
+    movdqa [rdi+0], xmm3
+
+    dec r9
+    jmp .MoveBackwardBlockData
+
+  ; Move the remainder of the data (which is now at the *start* of both
+  ; areas), one byte at a time, back-to-front.
+
+  .MoveBackwardRemainder:
+
+    cmp rcx, 0
+    je .Cleanup
+
+    dec rsi
+    dec rdi
+
+    mov al, [rsi]
+    mov [rdi], al
+
+    dec rcx
+    jmp .MoveBackwardRemainder
+
+  ; Now that we're done, we can safely return.
+
+  .Cleanup:
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than YMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Destination (RDI), const void* Source (RSI), uint64 Size (RDX))
+
+Memmove_Avx:
+
+  ; (Store `Size` (RDX) in RCX, since it's used for `rep movsb`)
+
+  mov rcx, rdx
+
+  ; First, let's figure out which direction we need to copy in; if
+  ; Destination comes after Source, we need to copy back-to-front.
+
+  cmp rdi, rsi
+  je .Cleanup
+  ja .MoveBackward
+
+  ; (If there isn't enough data to be worth aligning, skip straight to
+  ; the end, and copy everything with `rep movsb`)
+
+  cmp rcx, (128 + 32)
+  jb .MoveForwardRemainder
+
+  ; If the destination address isn't 32-byte-aligned, copy the bytes
+  ; before the next boundary using `rep movsb` (front-to-back, which is
+  ; safe here, since Destination comes before Source).
+
+  ; (We store the number of bytes we need to copy in R8)
+
+  mov r8, rdi
+  neg r8
+  and r8, (32 - 1)
+
+  .MoveForwardUnalignedData:
+
+    push rcx
+    mov rcx, r8
+
+    cld
+    rep movsb
+
+    pop rcx
+    sub rcx, r8
+
+    ; (Calculate the number of 128-byte 'blocks' we need to move in R9,
+    ; and leave the remainder in RCX)
+
+    mov r9, rcx
+    shr r9, 7
+
+    and rcx, (128 - 1)
+
+  ; Move each 128-byte block using AVX registers, using R9 as a counter;
+  ; we read the entire block before writing any of it.
+
+  .MoveForwardBlockData:
+
+    cmp r9, 0
+    je .MoveForwardRemainder
+
+    vmovdqu ymm0, [rsi+0]
+    vmovdqu ymm1, [rsi+32]
+    vmovdqu ymm2, [rsi+64]
+    vmovdqu ymm3, [rsi+96]
+
+    vmovdqa [rdi+0], ymm0
+    vmovdqa [rdi+32], ymm1
+    vmovdqa [rdi+64], ymm2
+    vmovdqa [rdi+96], ymm3
+
+    add rsi, 128
+    add rdi, 128
+
+    dec r9
+    jmp .MoveForwardBlockData
+
+  ; Move the remainder of the data, using `rep movsb` again.
+
+  .MoveForwardRemainder:
+
+    cld
+    rep movsb
+
+    jmp .Cleanup
+
+  ; If Destination comes after Source, then we need to do the same thing,
+  ; but starting from the end of both areas, and working backwards.
+
+  .MoveBackward:
+
+    add rsi, rcx
+    add rdi, rcx
+
+    ; (If there isn't enough data to be worth aligning, skip straight to
+    ; the end, and copy everything one byte at a time)
+
+    cmp rcx, (128 + 32)
+    jb .MoveBackwardRemainder
+
+    ; (Calculate the number of bytes after the last 32-byte boundary in
+    ; the destination area in R8, and copy those one byte at a time)
+
+    mov r8, rdi
+    and r8, (32 - 1)
+
+    sub rcx, r8
+
+  .MoveBackwardUnalignedData:
+
+    cmp r8, 0
+    je .MoveBackwardAlignedData
+
+    dec rsi
+    dec rdi
+
+    mov al, [rsi]
+    mov [rdi], al
+
+    dec r8
+    jmp .MoveBackwardUnalignedData
+
+  .MoveBackwardAlignedData:
+
+    ; (Calculate the number of 128-byte 'blocks' we need to move in R9,
+    ; and leave the remainder in RCX)
+
+    mov r9, rcx
+    shr r9, 7
+
+    and rcx, (128 - 1)
+
+  ; Move each 128-byte block using AVX registers, using R9 as a counter,
+  ; starting from the end; again, we read the entire block before writing
+  ; any of it.
+
+  .MoveBackwardBlockData:
+
+    cmp r9, 0
+    je .MoveBackwardRemainder
+
+    sub rsi, 128
+    sub rdi, 128
+
+    vmovdqu ymm0, [rsi+96]
+    vmovdqu ymm1, [rsi+64]
+    vmovdqu ymm2, [rsi+32]
+    vmovdqu ymm3, [rsi+0]
+
+    vmovdqa [rdi+96], ymm0
+    vmovdqa [rdi+64], ymm1
+    vmovdqa [rdi+32], ymm2
+    vmovdqa [rdi+0], ymm3
+
+    dec r9
+    jmp .MoveBackwardBlockData
+
+  ; Move the remainder of the data (which is now at the *start* of both
+  ; areas), one byte at a time, back-to-front.
+
+  .MoveBackwardRemainder:
+
+    cmp rcx, 0
+    je .Cleanup
+
+    dec rsi
+    dec rdi
+
+    mov al, [rsi]
+    mov [rdi], al
+
+    dec rcx
+    jmp .MoveBackwardRemainder
+
+  ; Now that we're done, we can safely return.
+
+  .Cleanup:
+
+    vzeroupper
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than ZMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Destination (RDI), const void* Source (RSI), uint64 Size (RDX))
+
+Memmove_Avx512f:
+
+  ; (Store `Size` (RDX) in RCX, since it's used for `rep movsb`)
+
+  mov rcx, rdx
+
+  ; First, let's figure out which direction we need to copy in; if
+  ; Destination comes after Source, we need to copy back-to-front.
+
+  cmp rdi, rsi
+  je .Cleanup
+  ja .MoveBackward
+
+  ; (If there isn't enough data to be worth aligning, skip straight to
+  ; the end, and copy everything with `rep movsb`)
+
+  cmp rcx, (256 + 64)
+  jb .MoveForwardRemainder
+
+  ; If the destination address isn't 64-byte-aligned, copy the bytes
+  ; before the next boundary using `rep movsb` (front-to-back, which is
+  ; safe here, since Destination comes before Source).
+
+  ; (We store the number of bytes we need to copy in R8)
+
+  mov r8, rdi
+  neg r8
+  and r8, (64 - 1)
+
+  .MoveForwardUnalignedData:
+
+    push rcx
+    mov rcx, r8
+
+    cld
+    rep movsb
+
+    pop rcx
+    sub rcx, r8
+
+    ; (Calculate the number of 256-byte 'blocks' we need to move in R9,
+    ; and leave the remainder in RCX)
+
+    mov r9, rcx
+    shr r9, 8
+
+    and rcx, (256 - 1)
+
+  ; Move each 256-byte block using AVX-512 registers, using R9 as a counter;
+  ; we read the entire block before writing any of it.
+
+  .MoveForwardBlockData:
+
+    cmp r9, 0
+    je .MoveForwardRemainder
+
+    vmovdqu64 zmm0, [rsi+0]
+    vmovdqu64 zmm1, [rsi+64]
+    vmovdqu64 zmm2, [rsi+128]
+    vmovdqu64 zmm3, [rsi+192]
+
+    vmovdqa64 [rdi+0], zmm0
+    vmovdqa64 [rdi+64], zmm1
+    vmovdqa64 [rdi+128], zmm2
+    vmovdqa64 [rdi+192], zmm3
+
+    add rsi, 256
+    add rdi, 256
+
+    dec r9
+    jmp .MoveForwardBlockData
+
+  ; Move the remainder of the data, using `rep movsb` again.
+
+  .MoveForwardRemainder:
+
+    cld
+    rep movsb
+
+    jmp .Cleanup
+
+  ; If Destination comes after Source, then we need to do the same thing,
+  ; but starting from the end of both areas, and working backwards.
+
+  .MoveBackward:
+
+    add rsi, rcx
+    add rdi, rcx
+
+    ; (If there isn't enough data to be worth aligning, skip straight to
+    ; the end, and copy everything one byte at a time)
+
+    cmp rcx, (256 + 64)
+    jb .MoveBackwardRemainder
+
+    ; (Calculate the number of bytes after the last 64-byte boundary in
+    ; the destination area in R8, and copy those one byte at a time)
+
+    mov r8, rdi
+    and r8, (64 - 1)
+
+    sub rcx, r8
+
+  .MoveBackwardUnalignedData:
+
+    cmp r8, 0
+    je .MoveBackwardAlignedData
+
+    dec rsi
+    dec rdi
+
+    mov al, [rsi]
+    mov [rdi], al
+
+    dec r8
+    jmp .MoveBackwardUnalignedData
+
+  .MoveBackwardAlignedData:
+
+    ; (Calculate the number of 256-byte 'blocks' we need to move in R9,
+    ; and leave the remainder in RCX)
+
+    mov r9, rcx
+    shr r9, 8
+
+    and rcx, (256 - 1)
+
+  ; Move each 256-byte block using AVX-512 registers, using R9 as a counter,
+  ; starting from the end; again, we read the entire block before writing
+  ; any of it.
+
+  .MoveBackwardBlockData:
+
+    cmp r9, 0
+    je .MoveBackwardRemainder
+
+    sub rsi, 256
+    sub rdi, 256
+
+    vmovdqu64 zmm0, [rsi+192]
+    vmovdqu64 zmm1, [rsi+128]
+    vmovdqu64 zmm2, [rsi+64]
+    vmovdqu64 zmm3, [rsi+0]
+
+    vmovdqa64 [rdi+192], zmm0
+    vmovdqa64 [rdi+128], zmm1
+    vmovdqa64 [rdi+64], zmm2
+    vmovdqa64 [rdi+0], zmm3
+
+    dec r9
+    jmp .MoveBackwardBlockData
+
+  ; Move the remainder of the data (which is now at the *start* of both
+  ; areas), one byte at a time, back-to-front.
+
+  .MoveBackwardRemainder:
+
+    cmp rcx, 0
+    je .Cleanup
+
+    dec rsi
+    dec rdi
+
+    mov al, [rsi]
+    mov [rdi], al
+
+    dec rcx
+    jmp .MoveBackwardRemainder
+
+  ; Now that we're done, we can safely return.
+
+  .Cleanup:
+
+    vzeroupper
+
+    ret
@@ -10,7 +10,13 @@ SECTION .text
 GLOBAL Memset_RepStosb
 GLOBAL Memset_Sse2
 GLOBAL Memset_Avx
+GLOBAL Memset_Avx2
 GLOBAL Memset_Avx512f
+GLOBAL Memset_NonTemporal
+
+GLOBAL MemsetPattern_Sse2
+GLOBAL MemsetPattern_Avx
+GLOBAL MemsetPattern_Avx512f
 
 
 ; This function shouldn't change any preserved registers.
@@ -62,12 +68,14 @@ Memset_RepStosb:
   ; Now that we know that Buffer is 16-byte-aligned, we can safely
   ; use `rep stosb` to copy everything else, before returning.
 
+  ; (These are all regular stores, so unlike Memset_NonTemporal(), we
+  ; don't need an `sfence` afterwards)
+
   .FillAlignedData:
 
     cld
     rep stosb
 
-    sfence
     ret
 
 
@@ -178,11 +186,11 @@ Memset_Sse2:
     cld
     rep stosb
 
-  ; Now that we're done, let's return.
+  ; Now that we're done, we can return; since these are all regular
+  ; stores, we don't need an `sfence` here.
 
   .Cleanup:
 
-    sfence
     ret
 
 
@@ -293,11 +301,85 @@ Memset_Avx:
     cld
     rep stosb
 
-  ; Now that we're done, we can safely return.
+  ; Now that we're done, we can return; since these are all regular
+  ; stores, we don't need an `sfence` here.
 
   .Cleanup:
 
-    sfence
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than YMM
+; ones, but those are covered by the System V ABI. Unlike the other
+; functions here, `Size` must be at least 32 bytes.
+
+; (void* Buffer (RDI), uint8 Character (RSI), uint64 Size (RDX))
+
+Memset_Avx2:
+
+  ; (Broadcast the lowest byte of RSI to every byte of YMM0, using the
+  ; `vpbroadcastb` instruction; unlike Memset_Avx(), we don't need to
+  ; go through the stack to do this)
+
+  vmovd xmm0, esi
+  vpbroadcastb ymm0, xmm0
+
+  ; Instead of aligning the buffer with `rep stosb`, fill the first and
+  ; last 32 bytes with unaligned stores; that way, the main loop only
+  ; has to deal with aligned 32-byte blocks.
+
+  ; (Store the end of the buffer in R8)
+
+  lea r8, [rdi+rdx]
+
+  vmovdqu [rdi], ymm0
+  vmovdqu [r8-32], ymm0
+
+  ; (Round the start of the buffer up to the next 32-byte boundary, and
+  ; the end down to the previous one (in R9))
+
+  add rdi, 32
+  and rdi, -32
+
+  mov r9, r8
+  and r9, -32
+
+  ; Fill each 128-byte block using YMM0, comparing against the end
+  ; pointer (in R9) instead of keeping a separate counter.
+
+  .FillBlockData:
+
+    lea rax, [rdi+128]
+
+    cmp rax, r9
+    ja .FillRemainder
+
+    vmovdqa [rdi+0], ymm0
+    vmovdqa [rdi+32], ymm0
+    vmovdqa [rdi+64], ymm0
+    vmovdqa [rdi+96], ymm0
+
+    mov rdi, rax
+    jmp .FillBlockData
+
+  ; Fill any aligned 32-byte blocks that are left over, one at a time.
+
+  .FillRemainder:
+
+    cmp rdi, r9
+    jae .Cleanup
+
+    vmovdqa [rdi], ymm0
+
+    add rdi, 32
+    jmp .FillRemainder
+
+  ; Now that we're done, we can return.
+
+  .Cleanup:
+
+    vzeroupper
     ret
 
 
@@ -406,9 +488,255 @@ Memset_Avx512f:
     cld
     rep stosb
 
-  ; Now that we're done, let's return.
+  ; Now that we're done, we can return; since these are all regular
+  ; stores, we don't need an `sfence` here.
+
+  .Cleanup:
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than XMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Buffer (RDI), uint8 Character (RSI), uint64 Size (RDX))
+
+Memset_NonTemporal:
+
+  ; First, let's check to see if the buffer address is 16-byte-aligned;
+  ; and if not, use `rep stosb` to fill it out.
+
+  ; (We store the remainder in R8, and use R9 as a scratch register)
+
+  mov r9, rdi
+  and r9, (16 - 1)
+
+  mov r8, 16
+  sub r8, r9
+
+  ; (Store `Character` in RAX, and `Size` in RCX)
+
+  mov rax, rsi
+  mov rcx, rdx
+
+  ; (If it's already aligned, or if it's too small to be worth it, then
+  ; we don't need to align it)
+
+  cmp r9, 0
+  je .FillAlignedData
+
+  cmp rcx, r8
+  jb .FillRemainder
+
+  ; If the buffer address isn't 16-byte-aligned, fill the remainder
+  ; (also using `rep stosb`, but *only* for the remainder)
+
+  .FillUnalignedData:
+
+    push rcx
+    mov rcx, r8
+
+    cld
+    rep stosb
+
+    pop rcx
+    sub rcx, r8
+
+  ; If it is, then prepare the environment for SSE.
+
+  .FillAlignedData:
+
+    ; (Calculate the amount of 64-byte blocks we'll need to fill in R9,
+    ; and leave the remainder in RCX.)
+
+    mov r9, rcx
+    shr r9, 6
+
+    and rcx, (64 - 1)
+
+    ; (Broadcast AL to the rest of RAX, using R10 as a scratch register,
+    ; and then broadcast RAX to both halves of XMM0)
+
+    movzx r10, al
+    mov rax, 0101010101010101h
+    imul rax, r10
+
+    movq xmm0, rax
+    punpcklqdq xmm0, xmm0
+
+  ; Fill each 64-byte block with SSE registers, using R9 as a counter
+  ; (R9 == (Size / 64)).
+
+  .FillBlockData:
+
+    ; (If we've filled all necessary blocks, exit the loop)
+
+    cmp r9, 0
+    je .FillRemainder
+
+    ; (Otherwise, use the `movntdq` instruction to fill the next 64
+    ; bytes; this is a non-temporal move, so it goes around the cache
+    ; instead of evicting whatever's already there)
+
+    movntdq [rdi+0], xmm0
+    movntdq [rdi+16], xmm0
+    movntdq [rdi+32], xmm0
+    movntdq [rdi+48], xmm0
+
+    ; (Move to the next 64-byte block, and repeat the loop)
+
+    add rdi, 64
+    dec r9
+
+    jmp .FillBlockData
+
+  ; Fill out the remainder of the data, using `rep stosb` again.
+
+  .FillRemainder:
+
+    cld
+    rep stosb
+
+  ; Now that we're done, let's return; non-temporal stores are weakly
+  ; ordered, so the `sfence` here is required, not just a precaution.
 
   .Cleanup:
 
     sfence
     ret
+
+
+
+; These functions repeat a pattern (or 'lane') that's exactly three
+; vectors long (48, 96 or 192 bytes), which is what MemsetBlock() uses
+; for anything that isn't a single byte; three vectors is enough to fit
+; a whole number of 3-byte pixels, as well as 2, 4 and 8-byte ones.
+
+; They all expect `Buffer` to be aligned to the size of one vector, and
+; the lane to already be in phase with it (MemsetBlock() takes care of
+; both); the remainder is copied straight from the lane, since it always
+; starts at the beginning of the pattern.
+
+
+; This function shouldn't change any preserved registers, other than XMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Buffer (RDI), const void* Lane (RSI), uint64 Size (RDX))
+
+MemsetPattern_Sse2:
+
+  ; (Load the lane into XMM0, XMM1 and XMM2)
+
+  movdqu xmm0, [rsi+0]
+  movdqu xmm1, [rsi+16]
+  movdqu xmm2, [rsi+32]
+
+  ; Fill each 48-byte block with the lane, using aligned stores.
+
+  .FillBlockData:
+
+    cmp rdx, 48
+    jb .FillRemainder
+
+    movdqa [rdi+0], xmm0
+    movdqa [rdi+16], xmm1
+    movdqa [rdi+32], xmm2
+
+    add rdi, 48
+    sub rdx, 48
+    jmp .FillBlockData
+
+  ; Copy whatever's left (less than one lane) from the start of the lane,
+  ; using `rep movsb`.
+
+  .FillRemainder:
+
+    mov rcx, rdx
+    rep movsb
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than YMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Buffer (RDI), const void* Lane (RSI), uint64 Size (RDX))
+
+MemsetPattern_Avx:
+
+  ; (Load the lane into YMM0, YMM1 and YMM2)
+
+  vmovdqu ymm0, [rsi+0]
+  vmovdqu ymm1, [rsi+32]
+  vmovdqu ymm2, [rsi+64]
+
+  ; Fill each 96-byte block with the lane, using aligned stores.
+
+  .FillBlockData:
+
+    cmp rdx, 96
+    jb .FillRemainder
+
+    vmovdqa [rdi+0], ymm0
+    vmovdqa [rdi+32], ymm1
+    vmovdqa [rdi+64], ymm2
+
+    add rdi, 96
+    sub rdx, 96
+    jmp .FillBlockData
+
+  ; Copy whatever's left (less than one lane) from the start of the lane,
+  ; using `rep movsb`.
+
+  .FillRemainder:
+
+    vzeroupper
+
+    mov rcx, rdx
+    rep movsb
+
+    ret
+
+
+
+; This function shouldn't change any preserved registers, other than ZMM
+; ones, but those are covered by the System V ABI.
+
+; (void* Buffer (RDI), const void* Lane (RSI), uint64 Size (RDX))
+
+MemsetPattern_Avx512f:
+
+  ; (Load the lane into ZMM0, ZMM1 and ZMM2)
+
+  vmovdqu64 zmm0, [rsi+0]
+  vmovdqu64 zmm1, [rsi+64]
+  vmovdqu64 zmm2, [rsi+128]
+
+  ; Fill each 192-byte block with the lane, using aligned stores.
+
+  .FillBlockData:
+
+    cmp rdx, 192
+    jb .FillRemainder
+
+    vmovdqa64 [rdi+0], zmm0
+    vmovdqa64 [rdi+64], zmm1
+    vmovdqa64 [rdi+128], zmm2
+
+    add rdi, 192
+    sub rdx, 192
+    jmp .FillBlockData
+
+  ; Copy whatever's left (less than one lane) from the start of the lane,
+  ; using `rep movsb`.
+
+  .FillRemainder:
+
+    vzeroupper
+
+    mov rcx, rdx
+    rep movsb
+
+    ret
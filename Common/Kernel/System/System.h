@@ -34,9 +34,24 @@
       bool Avx : 1; // Are (base) AVX features available?
       bool Avx2 : 1; // Are (base) AVX2 features available?
       bool Avx512f : 1; // Are (foundational) AVX512 features available?
+      bool Avx512bw : 1; // Are AVX512 byte and word instructions available?
 
     } cpuFeaturesAvailable;
 
+    #define DefaultNonTemporalThreshold 0x100000 // (Used if we can't figure out how large the caches are)
+
+    typedef struct _cpuCacheInfo {
+
+      uint16 LineSize; // The size of each cache line, in bytes
+
+      uint64 L1dSize; // The size of the L1 data cache, in bytes (or 0, if unknown)
+      uint64 L2Size; // The size of the L2 cache, in bytes (or 0, if unknown)
+      uint64 LlcSize; // The size of the last-level cache (L3, or L2 if there isn't one)
+
+      uint64 NonTemporalThreshold; // Copies or fills at least this large bypass the cache
+
+    } cpuCacheInfo;
+
     typedef struct _cpuidRegisterTable {
       uint64 Rax, Rbx, Rcx, Rdx;
     } __attribute__ ((packed)) cpuidRegisterTable;
@@ -44,7 +59,9 @@
     // Include functions and global variables from x64.c
 
     extern cpuFeaturesAvailable CpuFeaturesAvailable;
+    extern cpuCacheInfo CpuCacheInfo;
     void InitializeCpuFeatures(void);
+    void DetectCacheTopology(void);
 
     void WriteToControlRegister(uint8 Register, bool IsExtendedRegister, uint64 Value);
     uint64 ReadFromControlRegister(uint8 Register, bool IsExtendedRegister);
@@ -53,6 +70,8 @@
     uint64 ReadFromMsr(uint32 Msr);
 
     cpuidRegisterTable QueryCpuid(uint64 Rax, uint64 Rcx);
+    uint64 ReadTimestampCounter(void);
+    uint64 GetTimestampFrequency(void);
 
   #elif defined(__aarch64__)
 
@@ -7,6 +7,7 @@
 #endif
 
 #include "../Libraries/Stdint.h"
+#include "../Memory/Memory.h"
 #include "System.h"
 
 /* cpuFeaturesAvailable CpuFeaturesAvailable{}
@@ -25,6 +26,155 @@ cpuFeaturesAvailable CpuFeaturesAvailable = {false};
 
 
 
+/* cpuCacheInfo CpuCacheInfo{}
+
+   Members: (See definition in System.h)
+
+   A table that contains the sizes of the CPU's data caches, on x64
+   platforms; this is used by InitializeMemoryDispatchTable() to decide
+   when Memcpy() and Memset() should switch from regular SIMD stores to
+   `rep movsb` / `rep stosb` (past the L2 cache), and to non-temporal
+   stores, which bypass the cache entirely.
+
+   Like CpuFeaturesAvailable{}, this is only meant to be initialized by
+   InitializeCpuFeatures(); until then, it uses a reasonable default.
+
+*/
+
+cpuCacheInfo CpuCacheInfo = {.LineSize = 64, .NonTemporalThreshold = DefaultNonTemporalThreshold};
+
+
+
+/* void DetectCacheTopology(void)
+
+   Inputs: (none)
+   Outputs: (modifies CpuCacheInfo{})
+
+   This function figures out the size of each data cache, using CPUID
+   leaf 04h (on Intel processors) or leaf 8000001Dh (on AMD processors,
+   which use the same format), and falls back to the older 80000005h and
+   80000006h leaves if neither of those are available.
+
+   Once it knows how large the last-level cache is, it also sets the
+   threshold above which Memcpy() and Memset() use non-temporal stores -
+   anything larger than about 3/4 of the last-level cache would evict
+   most of it anyways, so there's no point in going through the cache.
+
+   This is called by InitializeCpuFeatures(), but it only uses CPUID, so
+   the host-side tools in Common/Host can also call it directly.
+
+*/
+
+void DetectCacheTopology(void) {
+
+  cpuCacheInfo Info = {.LineSize = 64};
+
+  uint64 MaxLeaf = QueryCpuid(0, 0).Rax;
+  uint64 MaxExtendedLeaf = QueryCpuid(0x80000000, 0).Rax;
+
+  // (Figure out which leaf we can use to enumerate each cache, if any;
+  // AMD processors report leaf 04h as reserved (all zeroes), and only
+  // support leaf 8000001Dh if they support topology extensions)
+
+  #define TopologyExtensionsBit (1ULL << 22) // (Within 80000001h.rcx)
+
+  uint64 CacheLeaf = 0;
+
+  if ((MaxLeaf >= 0x04) && ((QueryCpuid(0x04, 0).Rax & 0x1F) != 0)) {
+
+    CacheLeaf = 0x04;
+
+  } else if (MaxExtendedLeaf >= 0x8000001D) {
+
+    if ((QueryCpuid(0x80000001, 0).Rcx & TopologyExtensionsBit) != 0) {
+      CacheLeaf = 0x8000001D;
+    }
+
+  }
+
+  if (CacheLeaf != 0) {
+
+    // Each subleaf describes one cache, until we reach one with a type of
+    // zero; the size of each cache is (ways * partitions * line size *
+    // sets), and we skip instruction caches, since we only care about data.
+
+    for (uint64 Subleaf = 0; Subleaf < 16; Subleaf++) {
+
+      cpuidRegisterTable Cache = QueryCpuid(CacheLeaf, Subleaf);
+
+      uint8 Type = (Cache.Rax & 0x1F);
+      uint8 Level = ((Cache.Rax >> 5) & 0x07);
+
+      if (Type == 0) {
+        break;
+      } else if (Type == 2) {
+        continue;
+      }
+
+      uint64 LineSize = ((Cache.Rbx & 0xFFF) + 1);
+      uint64 Partitions = (((Cache.Rbx >> 12) & 0x3FF) + 1);
+      uint64 Ways = (((Cache.Rbx >> 22) & 0x3FF) + 1);
+      uint64 Sets = ((Cache.Rcx & 0xFFFFFFFF) + 1);
+
+      uint64 Size = (Ways * Partitions * LineSize * Sets);
+
+      if (Level == 1) {
+
+        Info.L1dSize = Size;
+        Info.LineSize = (uint16)LineSize;
+
+      } else if (Level == 2) {
+
+        Info.L2Size = Size;
+
+      } else if (Size > Info.LlcSize) {
+
+        Info.LlcSize = Size;
+
+      }
+
+    }
+
+  } else if (MaxExtendedLeaf >= 0x80000006) {
+
+    // (Older AMD processors only report their cache sizes through these
+    // leaves; the L1 and L2 sizes are in KiB, and the L3 size is in
+    // units of 512 KiB)
+
+    cpuidRegisterTable L1Cache = QueryCpuid(0x80000005, 0);
+    cpuidRegisterTable L2Cache = QueryCpuid(0x80000006, 0);
+
+    Info.L1dSize = (((L1Cache.Rcx >> 24) & 0xFF) * 1024);
+    Info.L2Size = (((L2Cache.Rcx >> 16) & 0xFFFF) * 1024);
+    Info.LlcSize = (((L2Cache.Rdx >> 18) & 0x3FFF) * 512 * 1024);
+
+    if ((L1Cache.Rcx & 0xFF) != 0) {
+      Info.LineSize = (L1Cache.Rcx & 0xFF);
+    }
+
+  }
+
+  // (If there's no L3 cache, then the L2 cache is the last-level one)
+
+  if (Info.LlcSize == 0) {
+    Info.LlcSize = Info.L2Size;
+  }
+
+  // Finally, calculate the non-temporal threshold, which is 3/4 of the
+  // last-level cache (or the default value, if we don't know its size).
+
+  if (Info.LlcSize != 0) {
+    Info.NonTemporalThreshold = ((Info.LlcSize / 4) * 3);
+  } else {
+    Info.NonTemporalThreshold = DefaultNonTemporalThreshold;
+  }
+
+  CpuCacheInfo = Info;
+
+}
+
+
+
 /* void InitializeCpuFeatures(void)
 
    Inputs: (none)
@@ -204,13 +354,20 @@ void InitializeCpuFeatures(void) {
     #define Avx2Bit (1ULL << 5) // (Within rbx)
     #define ErmsBit (1ULL << 9) // (Within rbx)
     #define Avx512fBit (1ULL << 16) // (Within rbx)
+    #define Avx512bwBit (1ULL << 30) // (Within rbx)
 
     CpuFeaturesAvailable.Erms = ((AvxRelevantFeatureFlags.Rbx & ErmsBit) != 0);
     CpuFeaturesAvailable.Avx2 = ((AvxRelevantFeatureFlags.Rbx & Avx2Bit) != 0);
     CpuFeaturesAvailable.Avx512f = ((AvxRelevantFeatureFlags.Rbx & Avx512fBit) != 0);
+    CpuFeaturesAvailable.Avx512bw = (CpuFeaturesAvailable.Avx512f && ((AvxRelevantFeatureFlags.Rbx & Avx512bwBit) != 0));
 
   }
 
+  // (Figure out how large each cache is, so that Memcpy() and Memset()
+  // can decide when to bypass it)
+
+  DetectCacheTopology();
+
   // Okay - now that we've successfully analyzed the CPU's *supported* feature
   // set, we can move onto enabling any supported features.
 
@@ -296,6 +453,12 @@ void InitializeCpuFeatures(void) {
 
   }
 
+  // Finally, now that we know which features are available (and how
+  // large each cache is), we can decide which routines Memcpy(), Memset()
+  // and others should use, once, instead of checking on every call.
+
+  InitializeMemoryDispatchTable();
+
   // Now that we've finished everything, return.
 
   return;
@@ -545,3 +708,77 @@ cpuidRegisterTable QueryCpuid(uint64 Rax, uint64 Rcx) {
   return Table;
 
 }
+
+
+
+/* uint64 ReadTimestampCounter()
+
+   Inputs: (None)
+   Outputs: uint64 - The current value of the CPU's timestamp counter.
+
+   This function serves as a wrapper around the rdtsc instruction, which
+   reads the CPU's timestamp counter (a 64-bit counter that increases at
+   a constant rate on most modern CPUs) into [edx:eax].
+
+   The actual rate depends on the CPU, so this is mostly useful for
+   comparing timestamps with each other, rather than measuring time.
+
+*/
+
+uint64 ReadTimestampCounter(void) {
+
+  // Execute the rdtsc instruction ([edx:eax] output)
+
+  uint32 Eax, Edx;
+  __asm__ __volatile__ ("rdtsc" : "=a"(Eax), "=d"(Edx));
+
+  // Assemble that into a proper value, and return
+
+  uint64 Value = ((uint64)Edx << 32) + Eax;
+  return Value;
+
+}
+
+
+
+/* uint64 GetTimestampFrequency()
+
+   Inputs: (None)
+   Outputs: uint64 - How many times per second the timestamp counter
+            ticks, or 0 if we couldn't figure that out.
+
+   This function uses CPUID leaf 15h (the ratio between the timestamp
+   counter and the core crystal clock) if it's available, and falls back
+   to leaf 16h (the processor's base frequency) otherwise; older CPUs
+   support neither, in which case timestamps can only be compared with
+   each other.
+
+*/
+
+uint64 GetTimestampFrequency(void) {
+
+  uint64 MaxLeaf = QueryCpuid(0, 0).Rax;
+
+  if (MaxLeaf >= 0x15) {
+
+    cpuidRegisterTable Ratio = QueryCpuid(0x15, 0);
+
+    if ((Ratio.Rax != 0) && (Ratio.Rbx != 0) && (Ratio.Rcx != 0)) {
+      return ((Ratio.Rcx * Ratio.Rbx) / Ratio.Rax);
+    }
+
+  }
+
+  if (MaxLeaf >= 0x16) {
+
+    uint64 BaseFrequency = (QueryCpuid(0x16, 0).Rax & 0xFFFF); // (In MHz)
+
+    if (BaseFrequency != 0) {
+      return (BaseFrequency * 1000000);
+    }
+
+  }
+
+  return 0;
+
+}
@@ -0,0 +1,435 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+// (This file is compiled by both the 32-bit (Legacy) and the 64-bit (EFI)
+// bootloaders, as well as the kernel, so we need to pick the right
+// Stdint.h)
+
+#if defined(__amd64__) || defined(__x86_64__)
+  #include "../../Boot/Efi/Stdint.h"
+#else
+  #include "../../Boot/Legacy/Shared/Stdint.h"
+#endif
+
+#include "../Common.h"
+#include "Mmap.h"
+
+// Firmware memory maps aren't guaranteed to be in any particular order,
+// and they can have overlapping (or even duplicate) entries; some EFI
+// firmware also returns several hundred entries at once.
+
+// This file turns them into a usable memory map (a list of
+// usableMmapEntry{}), in the same way for every stage - entries are
+// sorted in place with heapsort, which needs no extra space (we usually
+// can't allocate any at this point) and is O(n log n) even in the worst
+// case, and then usable areas are merged, cut around reserved ones, and
+// aligned in a single pass.
+
+// (Reserved areas always take priority over usable ones, so if the two
+// overlap, the usable area is split around the reserved one)
+
+
+
+/* static inline void* GetEntry()
+
+   Inputs: const void* Mmap - The memory map you want to index;
+           uint32 EntrySize - The size of each entry, in bytes;
+           uint32 Index - The index of the entry you want.
+
+   Outputs: void* - The location of that entry.
+
+*/
+
+static inline void* GetEntry(const void* Mmap, uint32 EntrySize, uint32 Index) {
+
+  return (void*)((uintptr)Mmap + ((uintptr)Index * EntrySize));
+
+}
+
+
+
+/* static void SwapEntries()
+
+   Inputs: void* EntryA, void* EntryB - The two entries you want to swap;
+           uint32 EntrySize - The size of each entry, in bytes.
+
+   Outputs: (None, except for the swapped entries)
+
+   (This is used instead of Memswap(), since each stage has its own)
+
+*/
+
+static void SwapEntries(void* EntryA, void* EntryB, uint32 EntrySize) {
+
+  uint8* ByteA = (uint8*)EntryA;
+  uint8* ByteB = (uint8*)EntryB;
+
+  for (uint32 Offset = 0; Offset < EntrySize; Offset++) {
+
+    uint8 Temporary = ByteA[Offset];
+
+    ByteA[Offset] = ByteB[Offset];
+    ByteB[Offset] = Temporary;
+
+  }
+
+}
+
+
+
+/* static bool IsEntryBefore()
+
+   Inputs: const void* EntryA, const void* EntryB - The two entries you
+           want to compare;
+
+           mmapQueryFunction Query - The callback used to read them.
+
+   Outputs: bool - Whether EntryA should be sorted before EntryB.
+
+   Entries are sorted by their starting address; if two entries start at
+   the same address, reserved ones come first. (NormalizeMmap() doesn't
+   depend on this, but it keeps the order of the sorted map predictable)
+
+*/
+
+static bool IsEntryBefore(const void* EntryA, const void* EntryB, mmapQueryFunction Query) {
+
+  uint64 BaseA, BaseB, Size;
+
+  bool IsUsableA = Query(EntryA, &BaseA, &Size);
+  bool IsUsableB = Query(EntryB, &BaseB, &Size);
+
+  if (BaseA != BaseB) {
+    return (BaseA < BaseB);
+  }
+
+  return ((IsUsableA == false) && (IsUsableB == true));
+
+}
+
+
+
+/* static void SiftDown()
+
+   Inputs: void* Mmap - The memory map (heap) you want to sift through;
+           uint32 EntrySize - The size of each entry, in bytes;
+           uint32 Root - The index of the entry you want to sift down;
+           uint32 NumEntries - The number of entries in the heap;
+           mmapQueryFunction Query - The callback used to read entries.
+
+   Outputs: (None, except for the modified memory map)
+
+   This function moves an entry down a (max-)heap until neither of its
+   children are larger than it, which is the main step of heapsort.
+
+*/
+
+static void SiftDown(void* Mmap, uint32 EntrySize, uint32 Root, uint32 NumEntries, mmapQueryFunction Query) {
+
+  while (true) {
+
+    // (Find the largest out of the root and its two children)
+
+    uint32 Largest = Root;
+    uint32 Child = ((2 * Root) + 1);
+
+    for (uint32 Index = Child; (Index < NumEntries) && (Index <= (Child + 1)); Index++) {
+
+      if (IsEntryBefore(GetEntry(Mmap, EntrySize, Largest), GetEntry(Mmap, EntrySize, Index), Query) == true) {
+        Largest = Index;
+      }
+
+    }
+
+    // (If that's the root itself, we're done; otherwise, swap them, and
+    // keep going from the child's position)
+
+    if (Largest == Root) {
+      break;
+    }
+
+    SwapEntries(GetEntry(Mmap, EntrySize, Root), GetEntry(Mmap, EntrySize, Largest), EntrySize);
+    Root = Largest;
+
+  }
+
+}
+
+
+
+/* void SortMmap()
+
+   Inputs: void* Mmap - The memory map you want to sort;
+           uint32 NumEntries - The number of entries in that memory map;
+           uint32 EntrySize - The size of each entry, in bytes;
+           mmapQueryFunction Query - The callback used to read entries.
+
+   Outputs: (None, except for the sorted memory map)
+
+   This function sorts a memory map in place, by starting address (see
+   IsEntryBefore()), using heapsort.
+
+*/
+
+void SortMmap(void* Mmap, uint32 NumEntries, uint32 EntrySize, mmapQueryFunction Query) {
+
+  if (NumEntries < 2) {
+    return;
+  }
+
+  // First, turn the memory map into a heap, starting from the last entry
+  // that has any children.
+
+  for (uint32 Index = (NumEntries / 2); Index > 0; Index--) {
+    SiftDown(Mmap, EntrySize, (Index - 1), NumEntries, Query);
+  }
+
+  // Next, repeatedly move the largest entry (the root) to the end, and
+  // restore the heap with whatever's left.
+
+  for (uint32 End = (NumEntries - 1); End > 0; End--) {
+
+    SwapEntries(GetEntry(Mmap, EntrySize, 0), GetEntry(Mmap, EntrySize, End), EntrySize);
+    SiftDown(Mmap, EntrySize, 0, End, Query);
+
+  }
+
+}
+
+
+
+/* static uint32 AddUsableEntry()
+
+   Inputs: usableMmapEntry* UsableMmap - The usable memory map;
+           uint32 NumEntries - The number of entries already in it;
+           uint32 MaxEntries - The maximum number of entries it can hold;
+           uint64 Start, uint64 End - The area you want to add;
+           uint64 Alignment, uint64 MinSize - See NormalizeMmap().
+
+   Outputs: uint32 - The number of entries in the usable memory map, after
+            (possibly) adding this area.
+
+   This function aligns an area inwards (so it never covers anything that
+   wasn't usable), and adds it to the usable memory map, unless it ends up
+   smaller than `MinSize`, or there's no space left.
+
+*/
+
+static uint32 AddUsableEntry(usableMmapEntry* UsableMmap, uint32 NumEntries, uint32 MaxEntries, uint64 Start, uint64 End, uint64 Alignment, uint64 MinSize) {
+
+  // (Round the end down, and the start up, to `Alignment`; we check the
+  // start against the end first, so rounding it up can't overflow)
+
+  End &= ~(Alignment - 1);
+
+  if (Start > End) {
+    return NumEntries;
+  }
+
+  Start = ((Start + (Alignment - 1)) & ~(Alignment - 1));
+
+  // (Make sure the area is still large enough, and that we have space)
+
+  if ((End <= Start) || ((End - Start) < MinSize)) {
+    return NumEntries;
+  } else if (NumEntries >= MaxEntries) {
+    return NumEntries;
+  }
+
+  UsableMmap[NumEntries].Base = Start;
+  UsableMmap[NumEntries].Limit = (End - Start);
+
+  return (NumEntries + 1);
+
+}
+
+
+
+/* uint32 NormalizeMmap()
+
+   Inputs: const void* Mmap - The (already sorted, with SortMmap()) memory
+           map you want to normalize;
+
+           uint32 NumEntries - The number of entries in that memory map;
+           uint32 EntrySize - The size of each entry, in bytes;
+           mmapQueryFunction Query - The callback used to read entries;
+
+           usableMmapEntry* UsableMmap - The buffer you want to write the
+           usable memory map to;
+
+           uint32 MaxUsableEntries - The number of entries that buffer can
+           hold (`NumEntries` is always enough);
+
+           uint64 Alignment - What to align each usable area to (this must
+           be a power of two, like 4096);
+
+           uint64 MinSize - The minimum size of each usable area, in bytes.
+
+   Outputs: uint32 - The number of entries in the usable memory map.
+
+   This function builds a usable memory map out of a sorted firmware
+   memory map, in a single pass:
+
+   - Overlapping and adjacent usable entries are merged into one area;
+   - Any part of a usable area that overlaps a reserved entry is removed,
+   splitting the area in two if necessary;
+   - Each resulting area is aligned inwards to `Alignment`, and dropped if
+   it's smaller than `MinSize` afterwards.
+
+   The result is sorted, and no two areas overlap, so it always passes
+   VerifyUsableMmap() with the same `Alignment` and `MinSize`.
+
+*/
+
+uint32 NormalizeMmap(const void* Mmap, uint32 NumEntries, uint32 EntrySize, mmapQueryFunction Query, usableMmapEntry* UsableMmap, uint32 MaxUsableEntries, uint64 Alignment, uint64 MinSize) {
+
+  uint32 NumUsableEntries = 0;
+
+  // (The usable area we're currently building, which is empty while
+  // AreaStart == AreaEnd, and the end of the last reserved area we've
+  // seen so far)
+
+  uint64 AreaStart = 0;
+  uint64 AreaEnd = 0;
+  uint64 ReservedEnd = 0;
+
+  for (uint32 Index = 0; Index < NumEntries; Index++) {
+
+    // (Read the entry, and skip it if it's empty; if it wraps around the
+    // end of the address space, treat it as ending there)
+
+    uint64 Start, Size;
+    bool IsUsable = Query(GetEntry(Mmap, EntrySize, Index), &Start, &Size);
+
+    if (Size == 0) {
+      continue;
+    }
+
+    uint64 End = (Start + Size);
+
+    if (End < Start) {
+      End = (uint64)-1;
+    }
+
+    if (IsUsable == true) {
+
+      // If this is a usable entry, remove anything that's covered by
+      // a previous reserved entry, and either add it to the current
+      // area (if the two overlap or touch), or start a new one.
+
+      if (Start < ReservedEnd) {
+        Start = ReservedEnd;
+      }
+
+      if (End <= Start) {
+        continue;
+      }
+
+      if ((AreaStart != AreaEnd) && (Start <= AreaEnd)) {
+
+        if (End > AreaEnd) {
+          AreaEnd = End;
+        }
+
+      } else {
+
+        NumUsableEntries = AddUsableEntry(UsableMmap, NumUsableEntries, MaxUsableEntries, AreaStart, AreaEnd, Alignment, MinSize);
+
+        AreaStart = Start;
+        AreaEnd = End;
+
+      }
+
+    } else {
+
+      // If this is a reserved entry, cut it out of the current area; since
+      // everything is sorted, anything before it is final, so we can add
+      // that part straight away.
+
+      if (End > ReservedEnd) {
+        ReservedEnd = End;
+      }
+
+      if ((AreaStart == AreaEnd) || (Start >= AreaEnd)) {
+        continue;
+      }
+
+      if (Start > AreaStart) {
+        NumUsableEntries = AddUsableEntry(UsableMmap, NumUsableEntries, MaxUsableEntries, AreaStart, Start, Alignment, MinSize);
+      }
+
+      // (Keep whatever's left after the reserved entry, if anything)
+
+      if (End < AreaEnd) {
+
+        if (End > AreaStart) {
+          AreaStart = End;
+        }
+
+      } else {
+
+        AreaStart = AreaEnd;
+
+      }
+
+    }
+
+  }
+
+  // (Add the last area we were working on, if there's one)
+
+  NumUsableEntries = AddUsableEntry(UsableMmap, NumUsableEntries, MaxUsableEntries, AreaStart, AreaEnd, Alignment, MinSize);
+  return NumUsableEntries;
+
+}
+
+
+
+/* mmapCheckResult VerifyUsableMmap()
+
+   Inputs: const usableMmapEntry* UsableMmap - The usable memory map you
+           want to check;
+
+           uint32 NumEntries - The number of entries in it;
+           uint64 Alignment - What each entry should be aligned to;
+           uint64 MinSize - The minimum size of each entry, in bytes.
+
+   Outputs: mmapCheckResult - MmapIsValid if the usable memory map is in
+            the format NormalizeMmap() produces, or the first problem we
+            found otherwise.
+
+*/
+
+mmapCheckResult VerifyUsableMmap(const usableMmapEntry* UsableMmap, uint32 NumEntries, uint64 Alignment, uint64 MinSize) {
+
+  if ((NumEntries == 0) || (UsableMmap == NULL)) {
+    return MmapHasNoEntries;
+  }
+
+  for (uint32 Index = 0; Index < NumEntries; Index++) {
+
+    uint64 Start = UsableMmap[Index].Base;
+    uint64 End = (Start + UsableMmap[Index].Limit);
+
+    // (Check that entries are sorted, and don't overlap or wrap around)
+
+    if (End < Start) {
+      return MmapHasOverlappingEntries;
+    } else if ((Index > 0) && (Start < (UsableMmap[Index - 1].Base + UsableMmap[Index - 1].Limit))) {
+      return MmapHasOverlappingEntries;
+    }
+
+    // (Check that entries are aligned, and large enough)
+
+    if (((Start | End) & (Alignment - 1)) != 0) {
+      return MmapIsNotAligned;
+    } else if ((End - Start) < MinSize) {
+      return MmapHasEntryUnderMinSize;
+    }
+
+  }
+
+  return MmapIsValid;
+
+}
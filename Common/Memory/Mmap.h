@@ -0,0 +1,39 @@
+// Copyright (C) 2025 NunoLealF
+// This file is part of the Serra project, which is released under the MIT license.
+// For more information, please refer to the accompanying license agreement. <3
+
+#ifndef SERRA_MMAP_H
+#define SERRA_MMAP_H
+
+  // (This file is shared between the 32-bit (Legacy) and 64-bit (EFI)
+  // bootloaders, as well as the kernel, so it has to be included *after*
+  // the right Stdint.h, and after Common.h (for usableMmapEntry{}))
+
+  // Callback used by SortMmap() and NormalizeMmap() to read a single
+  // firmware memory map entry, whatever format it's in; it should fill
+  // out `Base` and `Size` (in bytes), and return true if the area is
+  // usable, or false if it's reserved.
+
+  typedef bool (*mmapQueryFunction)(const void* Entry, uint64* Base, uint64* Size);
+
+  // The result of VerifyUsableMmap() - anything other than MmapIsValid
+  // means the usable memory map can't be trusted.
+
+  typedef enum _mmapCheckResult {
+
+    MmapIsValid = 0,
+    MmapHasNoEntries = 1,
+    MmapHasOverlappingEntries = 2, // (This also covers unsorted entries)
+    MmapIsNotAligned = 3,
+    MmapHasEntryUnderMinSize = 4
+
+  } mmapCheckResult;
+
+
+  // Functions from Mmap.c
+
+  void SortMmap(void* Mmap, uint32 NumEntries, uint32 EntrySize, mmapQueryFunction Query);
+  uint32 NormalizeMmap(const void* Mmap, uint32 NumEntries, uint32 EntrySize, mmapQueryFunction Query, usableMmapEntry* UsableMmap, uint32 MaxUsableEntries, uint64 Alignment, uint64 MinSize);
+  mmapCheckResult VerifyUsableMmap(const usableMmapEntry* UsableMmap, uint32 NumEntries, uint64 Alignment, uint64 MinSize);
+
+#endif